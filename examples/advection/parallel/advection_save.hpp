@@ -33,17 +33,21 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef ADVECTION_SAVE_HPP
 #define ADVECTION_SAVE_HPP
 
+#include "array"
 #include "cstdlib"
 #include "iomanip"
+#include "iostream"
 #include "mpi.h"
 #include "sstream"
 #include "string"
 #include "tuple"
+#include "vector"
 
 #include "dccrg.hpp"
 #include "dccrg_cartesian_geometry.hpp"
 
 #include "gensimcell.hpp"
+#include "vtk_writer.hpp"
 
 //! see ../serial.cpp for the basics
 
@@ -88,6 +92,55 @@ template<
 	Cell_T::set_transfer_all(false, Density_T(), Velocity_T());
 }
 
+
+/*!
+Saves the simulation in given grid into VTK files with names derived from given time.
+
+Given communicator must be the one used by given grid.
+Each process writes its own cells directly into a
+binary file which can be visualized without conversion.
+*/
+template<
+	class Cell_T,
+	class Density_T,
+	class Velocity_T
+> void save_vtk(
+	dccrg::Dccrg<Cell_T, dccrg::Cartesian_Geometry>& grid,
+	const double simulation_time,
+	MPI_Comm comm
+) {
+	std::ostringstream time_string;
+	time_string
+		<< std::setw(4)
+		<< std::setfill('0')
+		<< size_t(simulation_time * 1000);
+
+	std::vector<const Cell_T*> cells;
+	std::vector<std::array<double, 3>> cell_min, cell_max;
+	for (const auto& cell_id: grid.get_cells()) {
+		cells.push_back(grid[cell_id]);
+		cell_min.push_back(grid.geometry.get_min(cell_id));
+		cell_max.push_back(grid.geometry.get_max(cell_id));
+	}
+
+	if (
+		not gensimcell::save_vtk(
+			"advection_" + time_string.str(),
+			comm,
+			cells,
+			cell_min,
+			cell_max,
+			Density_T(),
+			Velocity_T()
+		)
+	) {
+		std::cerr << __FILE__ << ":" << __LINE__
+			<< ": Couldn't save VTK files."
+			<< std::endl;
+		abort();
+	}
+}
+
 } // namespace
 
 #endif // ifndef ADVECTION_SAVE_HPP
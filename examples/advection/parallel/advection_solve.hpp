@@ -41,6 +41,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "dccrg_cartesian_geometry.hpp"
 
 #include "gensimcell.hpp"
+#include "neighbor_table.hpp"
 
 //! see ../serial.cpp for the basics
 
@@ -48,11 +49,99 @@ namespace advection {
 
 /*!
 Calculates the flux of advected density into (+) and
-out of (-) each given cell in given grid over given time.
+out of (-) each cell in given table over given time.
 
 Returns the longest allowed time step for given cells
 and their neighbors.
 */
+template<
+	class Cell_T,
+	class Density_T,
+	class Density_Flux_T,
+	class Velocity_T,
+	class Geometry_T
+> double solve(
+	const double dt,
+	const examples::Neighbor_Table<Cell_T, Geometry_T>& cells
+) {
+	double max_time_step = std::numeric_limits<double>::max();
+
+	for (size_t i = 0; i < cells.size(); i++) {
+
+		/*
+		Unoptimized version that only changes the data of the current
+		cell, i.e. the flux through each face is always solved twice
+		even if the neighboring cell is on the same process
+		*/
+
+		auto& data = *cells.get_data(i);
+
+		// shorthand notation
+		const auto& n = data[Density_T()];
+		const auto& v = data[Velocity_T()];
+		auto& flux = data[Density_Flux_T()];
+
+		// substract density flowing out of this cell in x and y directions
+		flux -= fabs(n * v[0] * dt * cells.get_inverse_length(i, 0));
+		flux -= fabs(n * v[1] * dt * cells.get_inverse_length(i, 1));
+
+		// check time step
+		max_time_step =
+			std::min(max_time_step,
+			std::min(
+				fabs(cells.get_length(i, 0) / v[0]),
+				fabs(cells.get_length(i, 1) / v[1])
+			));
+
+		// advection into current cell from neighbors
+		for (
+			size_t neighbor = cells.get_face_neighbors_begin(i);
+			neighbor < cells.get_face_neighbors_end(i);
+			neighbor++
+		) {
+			// direction of this neighbor from the cell
+			const int dir = cells.get_face_direction(neighbor);
+			// index into multidimensional arrays
+			const size_t dim = size_t(abs(dir) - 1);
+
+			const auto& neighbor_data = *cells.get_face_neighbor_data(neighbor);
+			const auto& neigh_n = neighbor_data[Density_T()];
+			const auto& neigh_v = neighbor_data[Velocity_T()];
+
+			if (
+				(dir < 0 and neigh_v[dim] < 0)
+				or (dir > 0 and neigh_v[dim] > 0)
+			) {
+				// nothing flows into the cell from this neighbor
+				continue;
+			}
+
+			const size_t position = cells.get_face_neighbor_position(neighbor);
+
+			flux += fabs(
+				neigh_n * neigh_v[dim] * dt
+				* cells.get_inverse_length(position, dim)
+			);
+
+			max_time_step
+				= std::min(
+					max_time_step,
+					fabs(cells.get_length(position, dim) / neigh_v[dim])
+				);
+		}
+	}
+
+	return max_time_step;
+}
+
+/*!
+Calculates the flux of advected density into (+) and
+out of (-) each given cell in given grid over given time.
+
+Looks up given cells and their neighbors from given
+grid, use the version taking a Neighbor_Table to
+avoid that when solving the same cells repeatedly.
+*/
 template<
 	class Cell_T,
 	class Density_T,
@@ -142,6 +231,23 @@ template<
 }
 
 
+/*!
+Applies the density fluxes in cells of given table.
+*/
+template<
+	class Cell_T,
+	class Density_T,
+	class Density_Flux_T,
+	class Geometry_T
+> void apply_solution(const examples::Neighbor_Table<Cell_T, Geometry_T>& cells)
+{
+	for (size_t i = 0; i < cells.size(); i++) {
+		auto& data = *cells.get_data(i);
+		data[Density_T()] += data[Density_Flux_T()];
+		data[Density_Flux_T()] = 0;
+	}
+}
+
 /*!
 Applies the density fluxes in given cells.
 */
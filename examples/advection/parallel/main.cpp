@@ -38,6 +38,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "cstdlib"
 #include "iostream"
 #include "mpi.h"
+#include "string"
 
 #include "dccrg.hpp"
 #include "dccrg_cartesian_geometry.hpp"
@@ -47,6 +48,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "advection_save.hpp"
 #include "advection_solve.hpp"
 #include "advection_variables.hpp"
+#include "neighbor_table.hpp"
+#include "phase_timer.hpp"
 
 int main(int argc, char* argv[])
 {
@@ -82,7 +85,16 @@ int main(int argc, char* argv[])
 	dccrg::Dccrg<Cell, dccrg::Cartesian_Geometry> grid;
 
 	// initialize the grid
-	std::array<uint64_t, 3> grid_length = {{20, 20, 1}};
+	// number of cells in x and y dimensions can be given as first argument
+	uint64_t grid_size = 20;
+	if (argc > 1) {
+		grid_size = boost::lexical_cast<uint64_t>(argv[1]);
+	}
+	std::array<uint64_t, 3> grid_length = {{grid_size, grid_size, 1}};
+
+	// VTK files are also saved if second argument is vtk
+	const bool write_vtk = argc > 2 and std::string(argv[2]) == "vtk";
+
 	const unsigned int neighborhood_size = 1;
 	if (not grid.initialize(
 		grid_length,
@@ -129,10 +141,17 @@ int main(int argc, char* argv[])
 		inner_cells = grid.get_local_cells_not_on_process_boundary(),
 		outer_cells = grid.get_local_cells_on_process_boundary();
 
+	// data of cells and their neighbors for solvers
+	const examples::Neighbor_Table<Cell>
+		inner_table(inner_cells, grid),
+		outer_table(outer_cells, grid);
+
 	const double advection_save_interval = 0.1;
 
 	double advection_next_save = 0;
 
+	examples::Phase_Timer timer;
+
 	double
 		simulation_time = 0,
 		time_step = 0;
@@ -153,11 +172,21 @@ int main(int argc, char* argv[])
 		if (advection_next_save <= simulation_time) {
 			advection_next_save += advection_save_interval;
 
+			timer.start("save");
 			advection::save<
 				Cell,
 				advection::Density,
 				advection::Velocity
 			>(grid, simulation_time);
+
+			if (write_vtk) {
+				advection::save_vtk<
+					Cell,
+					advection::Density,
+					advection::Velocity
+				>(grid, simulation_time, comm);
+			}
+			timer.stop("save");
 		}
 
 
@@ -169,6 +198,7 @@ int main(int argc, char* argv[])
 		/*
 		Solve
 		*/
+		timer.start("solve");
 		Cell::set_transfer_all(
 			true,
 			advection::Density(),
@@ -184,11 +214,15 @@ int main(int argc, char* argv[])
 					advection::Density,
 					advection::Density_Flux,
 					advection::Velocity
-				>(time_step, inner_cells, grid)
+				>(time_step, inner_table)
 			);
+		timer.stop("solve");
 
+		timer.start("wait");
 		grid.wait_remote_neighbor_copy_update_receives();
+		timer.stop("wait");
 
+		timer.start("solve");
 		next_time_step
 			= std::min(
 				next_time_step,
@@ -197,30 +231,37 @@ int main(int argc, char* argv[])
 					advection::Density,
 					advection::Density_Flux,
 					advection::Velocity
-				>(time_step, outer_cells, grid)
+				>(time_step, outer_table)
 			);
+		timer.stop("solve");
 
 		/*
 		Apply solution
 		*/
+		timer.start("apply");
 		advection::apply_solution<
 			Cell,
 			advection::Density,
 			advection::Density_Flux
-		>(inner_cells, grid);
+		>(inner_table);
+		timer.stop("apply");
 
+		timer.start("wait");
 		grid.wait_remote_neighbor_copy_update_sends();
+		timer.stop("wait");
 		Cell::set_transfer_all(
 			false,
 			advection::Density(),
 			advection::Velocity()
 		);
 
+		timer.start("apply");
 		advection::apply_solution<
 			Cell,
 			advection::Density,
 			advection::Density_Flux
-		>(outer_cells, grid);
+		>(outer_table);
+		timer.stop("apply");
 
 		simulation_time += time_step;
 
@@ -229,6 +270,8 @@ int main(int argc, char* argv[])
 		time_step *= CFL;
 	}
 
+	timer.report(std::cout, comm);
+
 	MPI_Finalize();
 
 	return EXIT_SUCCESS;
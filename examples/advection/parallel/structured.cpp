@@ -0,0 +1,247 @@
+/*
+Parallel advection on a structured grid with wide ghost layers.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+
+Same problem as in ../serial.cpp decomposed with MPI_Cart_create.
+With a ghost depth of k density is exchanged every k steps and
+at each step in between also the ghost cells whose neighbors are
+still correct are solved. Run e.g. with
+mpirun -n 4 examples/advection/parallel/structured.mexe 50 3
+for blocks of 50 x 50 cells and ghost depth of 3.
+*/
+
+#include "algorithm"
+#include "array"
+#include "boost/lexical_cast.hpp"
+#include "cmath"
+#include "cstdlib"
+#include "iomanip"
+#include "iostream"
+#include "limits"
+
+#include "mpi.h" // must be included before gensimcell.hpp
+#include "gensimcell.hpp"
+#include "phase_timer.hpp"
+#include "structured_grid.hpp"
+#include "structured_halo.hpp"
+
+using namespace std;
+
+
+struct Density { using data_type = double; };
+
+struct Density_Flux { using data_type = double; };
+
+struct Velocity { using data_type = array<double, 2>; };
+
+using Cell_T = gensimcell::Cell<
+	gensimcell::Optional_Transfer,
+	Density,
+	Density_Flux,
+	Velocity
+>;
+
+using Grid_T = gensimcell::Structured_Grid<Cell_T, 2>;
+using Index_T = Grid_T::Index_T;
+
+
+int main(int argc, char* argv[])
+{
+	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
+		cerr << "Couldn't initialize MPI." << endl;
+		abort();
+	}
+
+	// cells per process in each dimension and ghost depth
+	size_t block_size = 20, depth = 1;
+	if (argc > 1) {
+		block_size = boost::lexical_cast<size_t>(argv[1]);
+	}
+	if (argc > 2) {
+		depth = boost::lexical_cast<size_t>(argv[2]);
+	}
+	if (depth == 0 or depth > block_size) {
+		cerr << "Ghost depth must be from 1 to block size." << endl;
+		abort();
+	}
+
+	int comm_size = 0;
+	MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+	array<int, 2> dimensions{{0, 0}}, periodic{{1, 1}}, coordinates{{0, 0}};
+	MPI_Dims_create(comm_size, 2, dimensions.data());
+
+	MPI_Comm comm;
+	MPI_Cart_create(MPI_COMM_WORLD, 2, dimensions.data(), periodic.data(), 0, &comm);
+	int rank = 0;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Cart_coords(comm, rank, 2, coordinates.data());
+
+	Grid_T grid({{block_size, block_size}}, depth);
+
+	// grid covers [-1, 1] in both dimensions
+	const array<double, 2> cell_size{{
+		2.0 / (dimensions[0] * block_size),
+		2.0 / (dimensions[1] * block_size)
+	}};
+
+	// initial condition of ../serial.cpp
+	grid.for_each_cell([&](Cell_T& cell, const Index_T& index) {
+		const array<double, 2> center{{
+			-1.0 + (0.5 + coordinates[0] * ptrdiff_t(block_size) + index[0]) * cell_size[0],
+			-1.0 + (0.5 + coordinates[1] * ptrdiff_t(block_size) + index[1]) * cell_size[1]
+		}};
+		const double r = sqrt(pow(center[0] + 0.45, 2) + pow(center[1], 2));
+
+		cell[Density()] = cell[Density_Flux()] = 0;
+		if (
+			center[0] > 0.1
+			and center[0] < 0.6
+			and center[1] > -0.25
+			and center[1] < 0.25
+		) {
+			cell[Density()] = 1;
+		} else if (r < 0.35) {
+			cell[Density()] = 1 - r / 0.35;
+		}
+
+		cell[Velocity()] = {{
+			+2 * center[1],
+			-2 * center[0]
+		}};
+	});
+
+	gensimcell::Structured_Halo<Cell_T, 2> halo;
+	if (not halo.initialize(grid, comm)) {
+		cerr << "Couldn't initialize ghost cell exchange." << endl;
+		abort();
+	}
+
+	// velocity doesn't change so neither does time step
+	Cell_T::set_transfer_all(true, Velocity());
+	if (not halo.exchange()) {
+		cerr << "Couldn't exchange ghost cells." << endl;
+		abort();
+	}
+	Cell_T::set_transfer_all(false, Velocity());
+
+	double time_step = numeric_limits<double>::max();
+	grid.for_each_cell([&](const Cell_T& cell, const Index_T&) {
+		time_step = min(time_step, min(
+			fabs(cell_size[0] / cell[Velocity()][0]),
+			fabs(cell_size[1] / cell[Velocity()][1])
+		));
+	});
+	MPI_Allreduce(MPI_IN_PLACE, &time_step, 1, MPI_DOUBLE, MPI_MIN, comm);
+	time_step *= 0.5;
+
+	const auto get_total_density = [&]() {
+		double total = 0;
+		grid.for_each_cell([&](const Cell_T& cell, const Index_T&) {
+			total += cell[Density()];
+		});
+		MPI_Allreduce(MPI_IN_PLACE, &total, 1, MPI_DOUBLE, MPI_SUM, comm);
+		return total;
+	};
+	const double initial_density = get_total_density();
+
+	enum {negative_x, positive_x, negative_y, positive_y};
+	const auto neighbor_offsets = grid.get_offsets<4>({{
+		{{-1, 0}}, {{1, 0}}, {{0, -1}}, {{0, 1}}
+	}});
+
+	// advection out of given cell in x and y directions
+	const auto get_flux
+		= [&](const Cell_T& cell) -> array<double, 2> {
+			return {{
+				cell[Density()] * (cell[Velocity()][0] * time_step / cell_size[0]),
+				cell[Density()] * (cell[Velocity()][1] * time_step / cell_size[1])
+			}};
+		};
+
+	examples::Phase_Timer timer;
+
+	Cell_T::set_transfer_all(true, Density());
+	size_t step = 0;
+	for (double simulation_time = 0; simulation_time < M_PI; step++) {
+
+		// ghost cells up to margin + 1 layers away are correct at this step
+		const size_t margin = depth - 1 - step % depth;
+		if (margin == depth - 1) {
+			timer.start("exchange");
+			if (not halo.exchange()) {
+				cerr << "Couldn't exchange ghost cells." << endl;
+				abort();
+			}
+			timer.stop("exchange");
+		}
+
+		timer.start("solve");
+		grid.for_each_cell(
+			margin,
+			neighbor_offsets,
+			[&](Cell_T& cell, const array<Cell_T*, 4>& neighbors, const Index_T&) {
+				const array<double, 2> flux = get_flux(cell);
+				cell[Density_Flux()]
+					+= max(get_flux(*neighbors[negative_x])[0], 0.0)
+					+ max(-get_flux(*neighbors[positive_x])[0], 0.0)
+					+ max(get_flux(*neighbors[negative_y])[1], 0.0)
+					+ max(-get_flux(*neighbors[positive_y])[1], 0.0)
+					- fabs(flux[0]) - fabs(flux[1]);
+			}
+		);
+		timer.stop("solve");
+
+		timer.start("apply");
+		grid.for_each_cell(margin, [](Cell_T& cell, const Index_T&) {
+			cell[Density()] += cell[Density_Flux()];
+			cell[Density_Flux()] = 0;
+		});
+		timer.stop("apply");
+
+		simulation_time += time_step;
+	}
+
+	const double final_density = get_total_density();
+	if (rank == 0) {
+		cout << setprecision(15)
+			<< "Total density after " << step << " steps: " << final_density
+			<< ", initially " << initial_density << endl;
+	}
+
+	timer.report(cout, comm);
+
+	MPI_Comm_free(&comm);
+	MPI_Finalize();
+
+	return EXIT_SUCCESS;
+}
@@ -44,6 +44,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "string"
 
 #include "gensimcell.hpp"
+#include "structured_grid.hpp"
 
 
 using namespace std;
@@ -80,13 +81,15 @@ constexpr size_t
 	height = 20;
 
 /*!
-Use row wise storage so, for example, to access
-the cell at horizontal (x) index = 2 and
-vertical (y) index = 4 use grid[4][2]
-(indices start from 0)
+Cells are indexed by their horizontal (x) and vertical (y)
+index so, for example, to access the cell at x index = 2
+and y index = 4 use grid[{{2, 4}}] (indices start from 0).
+One layer of ghost cells around the grid stores copies of
+cells on the opposite side to make the grid periodic.
 */
-using Grid_T = array<array<Cell_T, width>, height>;
-Grid_T grid;
+using Grid_T = gensimcell::Structured_Grid<Cell_T, 2>;
+using Index_T = Grid_T::Index_T;
+Grid_T grid({{width, height}}, 1);
 
 
 /*!
@@ -97,11 +100,12 @@ second in vertical (y). Indices increase in positive direction.
 */
 array<double, 2> get_cell_center(
 	const Grid_T& grid,
-	const array<size_t, 2>& index
+	const Index_T& index
 ) {
+	const auto& size = grid.get_size();
 	if (
-		index[1] >= grid.size()
-		or index[0] >= grid[index[1]].size()
+		index[0] < 0 or size_t(index[0]) >= size[0]
+		or index[1] < 0 or size_t(index[1]) >= size[1]
 	) {
 		return {{
 			std::numeric_limits<double>::quiet_NaN(),
@@ -110,8 +114,8 @@ array<double, 2> get_cell_center(
 	}
 
 	return {{
-		-1.0 + (0.5 + index[0]) * 2.0 / grid[index[1]].size(),
-		-1.0 + (0.5 + index[1]) * 2.0 / grid.size()
+		-1.0 + (0.5 + index[0]) * 2.0 / size[0],
+		-1.0 + (0.5 + index[1]) * 2.0 / size[1]
 	}};
 }
 
@@ -122,11 +126,12 @@ at given x and y indices in the grid.
 */
 array<double, 2> get_cell_size(
 	const Grid_T& grid,
-	const array<size_t, 2>& index
+	const Index_T& index
 ) {
+	const auto& size = grid.get_size();
 	if (
-		index[1] >= grid.size()
-		or index[0] >= grid[index[1]].size()
+		index[0] < 0 or size_t(index[0]) >= size[0]
+		or index[1] < 0 or size_t(index[1]) >= size[1]
 	) {
 		return {{
 			std::numeric_limits<double>::quiet_NaN(),
@@ -135,8 +140,8 @@ array<double, 2> get_cell_size(
 	}
 
 	return {{
-		2.0 / grid.size(),
-		2.0 / grid[index[1]].size()
+		2.0 / size[0],
+		2.0 / size[1]
 	}};
 }
 
@@ -151,14 +156,11 @@ ISBN 978-0-521-00924-9.
 */
 void initialize(Grid_T& grid)
 {
-	for (size_t row_i = 0; row_i < grid.size(); row_i++)
-	for (size_t cell_i = 0; cell_i < grid[row_i].size(); cell_i++) {
+	grid.for_each_cell([&](Cell_T& cell, const Index_T& index) {
 
-		const array<double, 2> center = get_cell_center(grid, {{cell_i, row_i}});
+		const array<double, 2> center = get_cell_center(grid, index);
 		const double r = sqrt(pow(center[0] + 0.45, 2) + pow(center[1], 2));
 
-		auto& cell = grid[row_i][cell_i];
-
 		/*
 		Initialize density
 		*/
@@ -186,7 +188,7 @@ void initialize(Grid_T& grid)
 			+2 * center[1],
 			-2 * center[0]
 		}};
-	}
+	});
 }
 
 
@@ -197,18 +199,17 @@ double get_max_time_step(const Grid_T& grid)
 {
 	double ret_val = std::numeric_limits<double>::max();
 
-	for (size_t y_i = 0; y_i < grid.size(); y_i++)
-	for (size_t x_i = 0; x_i < grid[y_i].size(); x_i++) {
+	grid.for_each_cell([&](const Cell_T& cell, const Index_T& index) {
 
 		const array<double, 2>
-			cell_size = get_cell_size(grid, {{x_i, y_i}}),
-			vel = grid[x_i][y_i][Velocity()];
+			cell_size = get_cell_size(grid, index),
+			vel = cell[Velocity()];
 
 		ret_val =
 			min(ret_val,
 			min(fabs(cell_size[0] / vel[0]),
 			    fabs(cell_size[1] / vel[1])));
-	}
+	});
 
 	return ret_val;
 }
@@ -221,60 +222,50 @@ out of (-) each cell in given grid over given time.
 Advection is calculated only into four edge neighbors of each cell.
 Velocity does not change during the simulation.
 
+Each cell collects the flux from its neighbors, which have
+been copied into ghost cells at the edges of the grid, so
+the loop over cells doesn't need periodic index arithmetic.
+
 The solver is probably simplest possible
 so it has e.g. very large diffusion.
 */
 void solve(Grid_T& grid, const double dt)
 {
-	static_assert(
-		std::tuple_size<Grid_T>::value > 0,
-		"Given grid must have at least one cell in first dimension"
-	);
-	static_assert(
-		std::tuple_size<Grid_T::value_type>::value > 0,
-		"Given grid must have at least one cell in second dimension"
-	);
-
-	for (size_t y_i = 0; y_i < height; y_i++)
-	for (size_t x_i = 0; x_i < width; x_i++) {
-
-		auto& cell = grid[y_i][x_i];
-
-		const double density = cell[Density()];
-		const array<double, 2>
-			cell_size = get_cell_size(grid, {{x_i, y_i}}),
-			velocity = cell[Velocity()];
-
-		const double
-			// advection out of current cell in x direction
-			flux_x = density * (velocity[0] * dt / cell_size[0]),
-			// advection out of current cell in y direction
-			flux_y = density * (velocity[1] * dt / cell_size[1]);
-
-		// save the flux out of the current cell
-		cell[Density_Flux()] -= fabs(flux_x) + fabs(flux_y);
-
-		// figure out where the density from current cell goes
-		if (flux_x < 0) {
-			// stuff flows into neighbor on the negative x side
-			Cell_T& neighbor = grid[y_i][(x_i + (width - 1)) % width];
-			neighbor[Density_Flux()] += fabs(flux_x);
-		} else {
-			// stuff flows into neighbor on the positive x side
-			Cell_T& neighbor = grid[y_i][(x_i + 1) % width];
-			neighbor[Density_Flux()] += flux_x;
-		}
-
-		if (flux_y < 0) {
-			// stuff flows into neighbor on the negative y side
-			Cell_T& neighbor = grid[(y_i + (height - 1)) % height][x_i];
-			neighbor[Density_Flux()] += fabs(flux_y);
-		} else {
-			// stuff flows into neighbor on the positive y side
-			Cell_T& neighbor = grid[(y_i + 1) % height][x_i];
-			neighbor[Density_Flux()] += flux_y;
+	grid.fill_periodic(Density(), Velocity());
+
+	enum {negative_x, positive_x, negative_y, positive_y};
+	const auto neighbor_offsets = grid.get_offsets<4>({{
+		{{-1, 0}}, {{1, 0}}, {{0, -1}}, {{0, 1}}
+	}});
+
+	// all cells have the same size
+	const array<double, 2> cell_size = get_cell_size(grid, {{0, 0}});
+
+	// advection out of given cell in x and y directions
+	const auto get_flux
+		= [&](const Cell_T& cell) -> array<double, 2> {
+			return {{
+				cell[Density()] * (cell[Velocity()][0] * dt / cell_size[0]),
+				cell[Density()] * (cell[Velocity()][1] * dt / cell_size[1])
+			}};
+		};
+
+	grid.for_each_cell(
+		neighbor_offsets,
+		[&](Cell_T& cell, const array<Cell_T*, 4>& neighbors, const Index_T&) {
+
+			// save the flux out of the current cell
+			const array<double, 2> flux = get_flux(cell);
+			cell[Density_Flux()] -= fabs(flux[0]) + fabs(flux[1]);
+
+			// stuff flows in from neighbors whose flux points towards this cell
+			cell[Density_Flux()]
+				+= max(get_flux(*neighbors[negative_x])[0], 0.0)
+				+ max(-get_flux(*neighbors[positive_x])[0], 0.0)
+				+ max(get_flux(*neighbors[negative_y])[1], 0.0)
+				+ max(-get_flux(*neighbors[positive_y])[1], 0.0);
 		}
-	}
+	);
 }
 
 
@@ -285,11 +276,10 @@ Density flux is zeroed after applying it.
 */
 void apply_solution(Grid_T& grid)
 {
-	for (auto& row: grid)
-	for (auto& cell: row) {
+	grid.for_each_cell([](Cell_T& cell, const Index_T&) {
 		cell[Density()] += cell[Density_Flux()];
 		cell[Density_Flux()] = 0;
-	}
+	});
 }
 
 
@@ -332,9 +322,9 @@ string save(
 		   "plot '-' matrix with image title ''\n";
 
 	// plotting 'with image' requires row data from bottom to top
-	for (size_t row_i = 0; row_i < grid.size(); row_i++) {
-		for (size_t cell_i = 0; cell_i < grid[row_i].size(); cell_i++) {
-			const auto& cell = grid[row_i][cell_i];
+	for (size_t row_i = 0; row_i < grid.get_size()[1]; row_i++) {
+		for (size_t cell_i = 0; cell_i < grid.get_size()[0]; cell_i++) {
+			const auto& cell = grid[{{ptrdiff_t(cell_i), ptrdiff_t(row_i)}}];
 			gnuplot_file << cell[Density()] << " ";
 		}
 		gnuplot_file << "\n";
@@ -42,6 +42,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 namespace combined {
 
+/*
+Particle lists are only used by the particle solver so they're
+stored outside of cells to keep the cells of other solvers compact.
+*/
 using Cell = gensimcell::Cell<
 	gensimcell::Optional_Transfer,
 	gol::Is_Alive,
@@ -52,8 +56,8 @@ using Cell = gensimcell::Cell<
 	particle::Number_Of_Internal_Particles,
 	particle::Number_Of_External_Particles,
 	particle::Velocity,
-	particle::Internal_Particles,
-	particle::External_Particles
+	gensimcell::Cold<particle::Internal_Particles>,
+	gensimcell::Cold<particle::External_Particles>
 >;
 
 } // namespace
@@ -56,6 +56,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "particle_solve.hpp"
 #include "particle_variables.hpp"
 #include "combined_variables.hpp"
+#include "neighbor_table.hpp"
+#include "phase_timer.hpp"
 
 int main(int argc, char* argv[])
 {
@@ -91,7 +93,12 @@ int main(int argc, char* argv[])
 	dccrg::Dccrg<Cell, dccrg::Cartesian_Geometry> grid;
 
 	// initialize the grid
-	std::array<uint64_t, 3> grid_length = {{20, 20, 1}};
+	// number of cells in x and y dimensions can be given as first argument
+	uint64_t grid_size = 20;
+	if (argc > 1) {
+		grid_size = boost::lexical_cast<uint64_t>(argv[1]);
+	}
+	std::array<uint64_t, 3> grid_length = {{grid_size, grid_size, 1}};
 	const unsigned int neighborhood_size = 1;
 	if (not grid.initialize(
 		grid_length,
@@ -154,12 +161,19 @@ int main(int argc, char* argv[])
 		inner_cells = grid.get_local_cells_not_on_process_boundary(),
 		outer_cells = grid.get_local_cells_on_process_boundary();
 
+	// data of cells and their neighbors for solvers
+	const examples::Neighbor_Table<Cell>
+		inner_table(inner_cells, grid),
+		outer_table(outer_cells, grid);
+
 	const double advection_save_interval = 0.1;
 	const double particle_save_interval = 0.1;
 
 	double advection_next_save = 0;
 	double particle_next_save = 0;
 
+	examples::Phase_Timer timer;
+
 	double
 		simulation_time = 0,
 		time_step = 0;
@@ -195,6 +209,7 @@ int main(int argc, char* argv[])
 		);
 
 
+		timer.start("save");
 		gol::save<Cell, gol::Is_Alive>(grid, simulation_time);
 
 		if (advection_next_save <= simulation_time) {
@@ -217,6 +232,7 @@ int main(int argc, char* argv[])
 				particle::Internal_Particles
 			>(grid, simulation_time);
 		}
+		timer.stop("save");
 
 
 		if (simulation_time >= M_PI) {
@@ -228,6 +244,7 @@ int main(int argc, char* argv[])
 		Solve
 		*/
 
+		timer.start("solve");
 		next_time_step
 			= std::min(
 				next_time_step,
@@ -238,7 +255,7 @@ int main(int argc, char* argv[])
 					particle::Velocity,
 					particle::Internal_Particles,
 					particle::External_Particles
-				>(time_step, outer_cells, grid)
+				>(time_step, outer_table)
 			);
 
 		Cell::set_transfer_all(true, particle::Number_Of_External_Particles());
@@ -254,18 +271,26 @@ int main(int argc, char* argv[])
 					particle::Velocity,
 					particle::Internal_Particles,
 					particle::External_Particles
-				>(time_step, inner_cells, grid)
+				>(time_step, inner_table)
 			);
+		timer.stop("solve");
 
 
+		timer.start("wait");
 		grid.wait_remote_neighbor_copy_update_receives();
+		timer.stop("wait");
+
+		timer.start("apply");
 		particle::resize_receiving_containers<
 			Cell,
 			particle::Number_Of_External_Particles,
 			particle::External_Particles
 		>(grid);
+		timer.stop("apply");
 
+		timer.start("wait");
 		grid.wait_remote_neighbor_copy_update_sends();
+		timer.stop("wait");
 
 
 		Cell::set_transfer_all(true, gol::Is_Alive());
@@ -283,11 +308,12 @@ int main(int argc, char* argv[])
 		grid.start_remote_neighbor_copy_updates();
 
 
+		timer.start("solve");
 		gol::solve<
 			Cell,
 			gol::Is_Alive,
 			gol::Live_Neighbors
-		>(inner_cells, grid);
+		>(inner_table);
 
 		next_time_step
 			= std::min(
@@ -297,24 +323,30 @@ int main(int argc, char* argv[])
 					advection::Density,
 					advection::Density_Flux,
 					advection::Velocity
-				>(time_step, inner_cells, grid)
+				>(time_step, inner_table)
 			);
+		timer.stop("solve");
 
+		timer.start("apply");
 		particle::incorporate_external_particles<
 			Cell,
 			particle::Number_Of_Internal_Particles,
 			particle::Internal_Particles,
 			particle::External_Particles
-		>(inner_cells, grid);
+		>(inner_table);
+		timer.stop("apply");
 
+		timer.start("wait");
 		grid.wait_remote_neighbor_copy_update_receives();
+		timer.stop("wait");
 
 
+		timer.start("solve");
 		gol::solve<
 			Cell,
 			gol::Is_Alive,
 			gol::Live_Neighbors
-		>(outer_cells, grid);
+		>(outer_table);
 
 		next_time_step
 			= std::min(
@@ -324,54 +356,61 @@ int main(int argc, char* argv[])
 					advection::Density,
 					advection::Density_Flux,
 					advection::Velocity
-				>(time_step, outer_cells, grid)
+				>(time_step, outer_table)
 			);
+		timer.stop("solve");
 
+		timer.start("apply");
 		gol::apply_solution<
 			Cell,
 			gol::Is_Alive,
 			gol::Live_Neighbors
-		>(inner_cells, grid);
+		>(inner_table);
 
 		advection::apply_solution<
 			Cell,
 			advection::Density,
 			advection::Density_Flux
-		>(inner_cells, grid);
+		>(inner_table);
 
 		particle::incorporate_external_particles<
 			Cell,
 			particle::Number_Of_Internal_Particles,
 			particle::Internal_Particles,
 			particle::External_Particles
-		>(outer_cells, grid);
+		>(outer_table);
 
 		particle::remove_external_particles<
 			Cell,
 			particle::Number_Of_External_Particles,
 			particle::External_Particles
-		>(inner_cells, grid);
+		>(inner_table);
+		timer.stop("apply");
 
+		timer.start("wait");
 		grid.wait_remote_neighbor_copy_update_sends();
+		timer.stop("wait");
 
 
+		timer.start("apply");
 		gol::apply_solution<
 			Cell,
 			gol::Is_Alive,
 			gol::Live_Neighbors
-		>(outer_cells, grid);
+		>(outer_table);
 
 		advection::apply_solution<
 			Cell,
 			advection::Density,
 			advection::Density_Flux
-		>(outer_cells, grid);
+		>(outer_table);
 
 		particle::remove_external_particles<
 			Cell,
 			particle::Number_Of_External_Particles,
 			particle::External_Particles
-		>(outer_cells, grid);
+		>(outer_table);
+		timer.stop("apply");
 
 		simulation_time += time_step;
 
@@ -380,6 +419,8 @@ int main(int argc, char* argv[])
 		time_step *= CFL;
 	}
 
+	timer.report(std::cout, comm);
+
 	MPI_Finalize();
 
 	return EXIT_SUCCESS;
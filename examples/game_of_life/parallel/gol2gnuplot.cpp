@@ -33,11 +33,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "cstdint"
 #include "cstdlib"
 #include "fstream"
-#include "mpi.h"
+#include "iostream"
 #include "string"
 #include "unordered_map"
 #include "vector"
 
+#include "mapped_grid_file.hpp"
+
 #include "dccrg_cartesian_geometry.hpp"
 #include "dccrg_mapping.hpp"
 #include "dccrg_topology.hpp"
@@ -49,117 +51,63 @@ using namespace gol;
 
 int main(int argc, char* argv[])
 {
-	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
-		cerr << "Coudln't initialize MPI." << endl;
-		abort();
-	}
-
-	MPI_Comm comm = MPI_COMM_WORLD;
-
-	int rank = 0, comm_size = 0;
-	MPI_Comm_rank(comm, &rank);
-	MPI_Comm_size(comm, &comm_size);
-
-
 	dccrg::Mapping mapping;
 	dccrg::Grid_Topology topology;
 	dccrg::Cartesian_Geometry geometry(mapping.length, mapping, topology);
 
+	gensimcell::Mapped_Grid_File file;
+
 	for (int i = 1; i < argc; i++) {
 
 		const string argv_string(argv[i]);
 
-		if ((i - 1) % comm_size != rank) {
+		if (not file.open(argv_string)) {
+			cerr << "Couldn't open file " << argv_string << endl;
 			continue;
 		}
 
-		MPI_File file;
-		if (
-			MPI_File_open(
-				MPI_COMM_SELF,
-				const_cast<char*>(argv_string.c_str()),
-				MPI_MODE_RDONLY,
-				MPI_INFO_NULL,
-				&file
-			) != MPI_SUCCESS
-		) {
-			cerr << "Process " << rank
-				<< " couldn't open file " << argv_string
+		// skip unncessary data
+		uint64_t offset = sizeof(uint64_t);
+
+		if (not file.read_mapping(offset, mapping, topology, geometry)) {
+			cerr << "Couldn't set cell id mapping for file " << argv_string
 				<< endl;
 			continue;
 		}
 
-		// skip unncessary data
-		MPI_Offset offset = sizeof(uint64_t);
-
-		mapping.read(file, offset);
-
-		offset
-			+= mapping.data_size()
-			+ sizeof(unsigned int)
-			+ topology.data_size()
-			+ geometry.data_size();
-
-		// read number of cells
-		uint64_t total_cells = 0;
-		MPI_File_read_at(
-			file,
-			offset,
-			&total_cells,
-			1,
-			MPI_UINT64_T,
-			MPI_STATUS_IGNORE
-		);
-		offset += sizeof(uint64_t);
-
-		if (total_cells == 0) {
-			MPI_File_close(&file);
+		// read cell ids and data offsets
+		if (not file.read_cells(offset)) {
+			cerr << "Couldn't read cell list from file " << argv_string
+				<< endl;
 			continue;
 		}
 
-		// read cell ids and file offsets of cell data
-		vector<pair<uint64_t, uint64_t>> cells_offsets(total_cells);
-		MPI_File_read_at(
-			file,
-			offset,
-			cells_offsets.data(),
-			2 * total_cells,
-			MPI_UINT64_T,
-			MPI_STATUS_IGNORE
-		);
+		if (file.get_cells().size() == 0) {
+			continue;
+		}
 
 		/*
 		Read cell data
 
 		Assumes that only one variable of type MPI_CXX_BOOL was
-		saved for each cell. For a more generic version which
-		only assumes that the size of each cells' data is known
-		before reading anything from the saved file see
-		../../advection/parallel/advection2gnuplot.cpp
+		saved for each cell. For a more generic version see
+		../../particle_propagation/parallel/particle2gnuplot.cpp
 		*/
 		unordered_map<
 			uint64_t,
 			Is_Alive::data_type
 		> simulation_data;
 
-		for (const auto& item: cells_offsets) {
-			const uint64_t
-				cell_id = item.first,
-				offset = item.second;
-
-			simulation_data[cell_id];
+		for (size_t cell_i = 0; cell_i < file.get_cells().size(); cell_i++) {
+			const uint64_t cell_id = file.get_cells()[cell_i];
 
-			MPI_File_read_at(
-				file,
-				(MPI_Offset) offset,
-				&(simulation_data.at(cell_id)),
-				1,
-				MPI_CXX_BOOL,
-				MPI_STATUS_IGNORE
+			file.read(
+				file.get_cell_data_offset(cell_i),
+				simulation_data[cell_id]
 			);
 		}
 
-		cells_offsets.clear();
+		file.close();
 
 		const string
 			gnuplot_file_name(argv_string + ".dat"),
@@ -200,7 +148,5 @@ int main(int argc, char* argv[])
 		system(("gnuplot " + gnuplot_file_name).c_str());
 	}
 
-	MPI_Finalize();
-
 	return EXIT_SUCCESS;
 }
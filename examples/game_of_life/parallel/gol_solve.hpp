@@ -41,18 +41,48 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "dccrg_cartesian_geometry.hpp"
 
 #include "gensimcell.hpp"
+#include "neighbor_table.hpp"
 
 //! see ../serial.cpp for the basics
 
 namespace gol {
 
 /*!
-Calculates the number of live neighbors for given cells.
+Calculates the number of live neighbors for cells in given table.
 
 Uses Is_Alive to access the data corresponding to
 the life state of a cell and Live_Neighbors to access
 the data corresponding to the number of live neighbors.
 */
+template<
+	class Cell_T,
+	class Is_Alive_T,
+	class Live_Neighbors_T,
+	class Geometry_T
+> void solve(const examples::Neighbor_Table<Cell_T, Geometry_T>& cells)
+{
+	for (size_t i = 0; i < cells.size(); i++) {
+		auto& current_data = *cells.get_data(i);
+
+		for (
+			size_t n = cells.get_neighbors_begin(i);
+			n < cells.get_neighbors_end(i);
+			n++
+		) {
+			if ((*cells.get_neighbor_data(n))[Is_Alive_T()]) {
+				current_data[Live_Neighbors_T()]++;
+			}
+		}
+	}
+}
+
+/*!
+Calculates the number of live neighbors for given cells.
+
+Looks up given cells and their neighbors from given
+grid, use the version taking a Neighbor_Table to
+avoid that when solving the same cells repeatedly.
+*/
 template<
 	class Cell_T,
 	class Is_Alive_T,
@@ -92,6 +122,28 @@ template<
 }
 
 
+/*!
+Applies the rules of Conway's Game of Life to cells in given table.
+*/
+template<
+	class Cell_T,
+	class Is_Alive_T,
+	class Live_Neighbors_T,
+	class Geometry_T
+> void apply_solution(const examples::Neighbor_Table<Cell_T, Geometry_T>& cells)
+{
+	for (size_t i = 0; i < cells.size(); i++) {
+		auto& data = *cells.get_data(i);
+
+		if (data[Live_Neighbors_T()] == 3) {
+			data[Is_Alive_T()] = true;
+		} else if (data[Live_Neighbors_T()] != 2) {
+			data[Is_Alive_T()] = false;
+		}
+		data[Live_Neighbors_T()] = 0;
+	}
+}
+
 /*!
 Applies the rules of Conway's Game of Life to given cells.
 */
@@ -45,6 +45,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "gol_save.hpp"
 #include "gol_solve.hpp"
 #include "gol_variables.hpp"
+#include "neighbor_table.hpp"
+#include "phase_timer.hpp"
 
 int main(int argc, char* argv[])
 {
@@ -80,7 +82,12 @@ int main(int argc, char* argv[])
 	dccrg::Dccrg<Cell, dccrg::Cartesian_Geometry> grid;
 
 	// initialize the grid
-	std::array<uint64_t, 3> grid_length = {{20, 20, 1}};
+	// number of cells in x and y dimensions can be given as first argument
+	uint64_t grid_size = 20;
+	if (argc > 1) {
+		grid_size = boost::lexical_cast<uint64_t>(argv[1]);
+	}
+	std::array<uint64_t, 3> grid_length = {{grid_size, grid_size, 1}};
 	const unsigned int neighborhood_size = 1;
 	if (not grid.initialize(
 		grid_length,
@@ -127,6 +134,13 @@ int main(int argc, char* argv[])
 		inner_cells = grid.get_local_cells_not_on_process_boundary(),
 		outer_cells = grid.get_local_cells_on_process_boundary();
 
+	// data of cells and their neighbors for solvers
+	const examples::Neighbor_Table<Cell>
+		inner_table(inner_cells, grid),
+		outer_table(outer_cells, grid);
+
+	examples::Phase_Timer timer;
+
 	double
 		simulation_time = 0,
 		time_step = 0.1;
@@ -143,7 +157,9 @@ int main(int argc, char* argv[])
 			gol::Live_Neighbors()
 		);
 
+		timer.start("save");
 		gol::save<Cell, gol::Is_Alive>(grid, simulation_time);
+		timer.stop("save");
 
 		if (simulation_time >= M_PI) {
 			// don't simulate an extra step, e.g. if only initial state needed 
@@ -151,6 +167,7 @@ int main(int argc, char* argv[])
 		}
 
 		// start updating data required by the solver between processes
+		timer.start("solve");
 		Cell::set_transfer_all(true, gol::Is_Alive());
 		grid.start_remote_neighbor_copy_updates();
 
@@ -162,45 +179,58 @@ int main(int argc, char* argv[])
 			Cell,
 			gol::Is_Alive,
 			gol::Live_Neighbors
-		>(inner_cells, grid);
+		>(inner_table);
+		timer.stop("solve");
 
 		// wait for the required data to arrive
+		timer.start("wait");
 		grid.wait_remote_neighbor_copy_update_receives();
+		timer.stop("wait");
 
 		// solve the rest of local cells
+		timer.start("solve");
 		gol::solve<
 			Cell,
 			gol::Is_Alive,
 			gol::Live_Neighbors
-		>(outer_cells, grid);
+		>(outer_table);
+		timer.stop("solve");
 
 		/*
 		Set the new state of cells whose data wasn't
 		required by other processes
 		*/
+		timer.start("apply");
 		gol::apply_solution<
 			Cell,
 			gol::Is_Alive,
 			gol::Live_Neighbors
-		>(inner_cells, grid);
+		>(inner_table);
+		timer.stop("apply");
 
 		/*
 		Wait for required data to arrive to other
 		processes before setting the new state to
 		those local cells
 		*/
+		timer.start("wait");
 		grid.wait_remote_neighbor_copy_update_sends();
+		timer.stop("wait");
 		Cell::set_transfer_all(false, gol::Is_Alive());
 
+		timer.start("apply");
 		gol::apply_solution<
 			Cell,
 			gol::Is_Alive,
 			gol::Live_Neighbors
-		>(outer_cells, grid);
+		>(outer_table);
+		timer.stop("apply");
 
 		simulation_time += time_step;
 	}
 
+	timer.report(std::cout, comm);
+
 	MPI_Finalize();
 
 	return EXIT_SUCCESS;
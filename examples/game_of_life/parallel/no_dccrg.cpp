@@ -35,11 +35,11 @@ To keep it simple use 1d grid and one cell / process.
 
 #include "cstdlib"
 #include "iostream"
-#include "tuple"
 #include "vector"
 
 #include "mpi.h" // must be included before gensimcell.hpp
 #include "gensimcell.hpp"
+#include "halo.hpp"
 
 using namespace std;
 
@@ -129,57 +129,37 @@ int main(int argc, char* argv[])
 
 	print_game(cell, rank, comm_size);
 
+	/*
+	Send cell to both neighbors and receive their cells,
+	tags tell which is which if both neighbors are the same
+	*/
+	enum {to_positive, to_negative};
+	const int
+		neg_rank = int(unsigned(rank + comm_size - 1) % comm_size),
+		pos_rank = int(unsigned(rank + 1) % comm_size);
+
+	gensimcell::Halo<Cell_T> halo;
+	halo.add_send(pos_rank, to_positive, cell);
+	halo.add_send(neg_rank, to_negative, cell);
+	halo.add_receive(neg_rank, to_positive, neg_neigh);
+	halo.add_receive(pos_rank, to_negative, pos_neigh);
+	if (not halo.initialize(comm)) {
+		cerr << "Couldn't initialize cell data exchange." << endl;
+		abort();
+	}
+
 	constexpr size_t max_turns = 10;
 	for (size_t turn = 0; turn < max_turns; turn++) {
 
-		// MPI transfer info of cell and its neighbors
-		tuple<void*, int, MPI_Datatype>
-			cell_info, neg_info, pos_info;
-
-		cell_info = cell.get_mpi_datatype();
-		neg_info = neg_neigh.get_mpi_datatype();
-		pos_info = pos_neigh.get_mpi_datatype();
-
 		// update variables between neighboring cells
-		MPI_Request neg_send, pos_send, neg_recv, pos_recv;
-		MPI_Irecv(
-			get<0>(neg_info), get<1>(neg_info), get<2>(neg_info),
-			int(unsigned(rank + comm_size - 1) % comm_size),
-			int(unsigned(rank + comm_size - 1) % comm_size),
-			MPI_COMM_WORLD,
-			&neg_recv
-		);
-		MPI_Irecv(
-			get<0>(pos_info), get<1>(pos_info), get<2>(pos_info),
-			int(unsigned(rank + 1) % comm_size),
-			int(unsigned(rank + 1) % comm_size),
-			MPI_COMM_WORLD,
-			&pos_recv
-		);
-		MPI_Isend(
-			get<0>(cell_info), get<1>(cell_info), get<2>(cell_info),
-			int(unsigned(rank + comm_size - 1) % comm_size),
-			rank,
-			MPI_COMM_WORLD,
-			&neg_send
-		);
-		MPI_Isend(
-			get<0>(cell_info), get<1>(cell_info), get<2>(cell_info),
-			int(unsigned(rank + 1) % comm_size),
-			rank,
-			MPI_COMM_WORLD,
-			&pos_send
-		);
-
-		MPI_Wait(&neg_recv, MPI_STATUS_IGNORE);
-		MPI_Wait(&pos_recv, MPI_STATUS_IGNORE);
+		if (not halo.exchange()) {
+			cerr << "Couldn't exchange cell data between processes." << endl;
+			abort();
+		}
 
 		if (neg_neigh[is_alive]) cell[live_neighbors]++;
 		if (pos_neigh[is_alive]) cell[live_neighbors]++;
 
-		MPI_Wait(&neg_send, MPI_STATUS_IGNORE);
-		MPI_Wait(&pos_send, MPI_STATUS_IGNORE);
-
 		if (cell[live_neighbors] == 2) {
 			cell[is_alive] = true;
 		} else {
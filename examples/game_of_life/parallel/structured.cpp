@@ -0,0 +1,200 @@
+/*
+Parallel Game of Life on a structured grid with wide ghost layers.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+
+Each process has a square block of cells of a periodic grid
+decomposed with MPI_Cart_create. With a ghost depth of k ghost
+cells are exchanged every k turns and at each turn in between
+also the ghost cells that are still correct are solved, which
+requires k times fewer messages. Run e.g. with
+mpirun -n 4 examples/game_of_life/parallel/structured.mexe 100 3
+for blocks of 100 x 100 cells and ghost depth of 3.
+*/
+
+#include "array"
+#include "boost/lexical_cast.hpp"
+#include "cstdlib"
+#include "iostream"
+
+#include "mpi.h" // must be included before gensimcell.hpp
+#include "gensimcell.hpp"
+#include "phase_timer.hpp"
+#include "structured_grid.hpp"
+#include "structured_halo.hpp"
+
+using namespace std;
+
+
+struct Is_Alive { using data_type = bool; };
+
+struct Live_Neighbors { using data_type = int; };
+
+using Cell_T = gensimcell::Cell<
+	gensimcell::Optional_Transfer,
+	Is_Alive,
+	Live_Neighbors
+>;
+
+using Grid_T = gensimcell::Structured_Grid<Cell_T, 2>;
+using Index_T = Grid_T::Index_T;
+
+
+int main(int argc, char* argv[])
+{
+	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
+		cerr << "Couldn't initialize MPI." << endl;
+		abort();
+	}
+
+	// cells per process in each dimension, ghost depth and number of turns
+	size_t block_size = 20, depth = 1, max_turns = 100;
+	if (argc > 1) {
+		block_size = boost::lexical_cast<size_t>(argv[1]);
+	}
+	if (argc > 2) {
+		depth = boost::lexical_cast<size_t>(argv[2]);
+	}
+	if (argc > 3) {
+		max_turns = boost::lexical_cast<size_t>(argv[3]);
+	}
+	if (depth == 0 or depth > block_size) {
+		cerr << "Ghost depth must be from 1 to block size." << endl;
+		abort();
+	}
+
+	int comm_size = 0;
+	MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+	array<int, 2> dimensions{{0, 0}}, periodic{{1, 1}}, coordinates{{0, 0}};
+	MPI_Dims_create(comm_size, 2, dimensions.data());
+
+	MPI_Comm comm;
+	MPI_Cart_create(MPI_COMM_WORLD, 2, dimensions.data(), periodic.data(), 0, &comm);
+	int rank = 0;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Cart_coords(comm, rank, 2, coordinates.data());
+
+	Grid_T grid({{block_size, block_size}}, depth);
+
+	// returns global index of cell at given local index
+	const auto get_global = [&](const Index_T& index) -> Index_T {
+		return {{
+			coordinates[0] * ptrdiff_t(block_size) + index[0],
+			coordinates[1] * ptrdiff_t(block_size) + index[1]
+		}};
+	};
+
+	// glider at upper left of whole grid
+	grid.for_each_cell([&](Cell_T& cell, const Index_T& index) {
+		const Index_T global = get_global(index);
+		cell[Is_Alive()]
+			= (global == Index_T{{2, 1}})
+			or (global == Index_T{{3, 2}})
+			or (global[1] == 3 and global[0] >= 1 and global[0] <= 3);
+		cell[Live_Neighbors()] = 0;
+	});
+
+	gensimcell::Structured_Halo<Cell_T, 2> halo;
+	if (not halo.initialize(grid, comm)) {
+		cerr << "Couldn't initialize ghost cell exchange." << endl;
+		abort();
+	}
+
+	const auto neighbor_offsets = grid.get_offsets<8>({{
+		{{-1, -1}}, {{0, -1}}, {{1, -1}},
+		{{-1,  0}},            {{1,  0}},
+		{{-1,  1}}, {{0,  1}}, {{1,  1}}
+	}});
+
+	examples::Phase_Timer timer;
+
+	Cell_T::set_transfer_all(true, Is_Alive());
+	for (size_t turn = 0; turn < max_turns; turn++) {
+
+		/*
+		Ghost cells up to margin + 1 layers away from
+		interior cells are correct at this turn
+		*/
+		const size_t margin = depth - 1 - turn % depth;
+		if (margin == depth - 1) {
+			timer.start("exchange");
+			if (not halo.exchange()) {
+				cerr << "Couldn't exchange ghost cells." << endl;
+				abort();
+			}
+			timer.stop("exchange");
+		}
+
+		timer.start("solve");
+		grid.for_each_cell(
+			margin,
+			neighbor_offsets,
+			[](Cell_T& cell, const array<Cell_T*, 8>& neighbors, const Index_T&) {
+				for (const auto* neighbor: neighbors) {
+					if ((*neighbor)[Is_Alive()]) {
+						cell[Live_Neighbors()]++;
+					}
+				}
+			}
+		);
+		timer.stop("solve");
+
+		timer.start("apply");
+		grid.for_each_cell(margin, [](Cell_T& cell, const Index_T&) {
+			if (cell[Live_Neighbors()] == 3) {
+				cell[Is_Alive()] = true;
+			} else if (cell[Live_Neighbors()] != 2) {
+				cell[Is_Alive()] = false;
+			}
+			cell[Live_Neighbors()] = 0;
+		});
+		timer.stop("apply");
+	}
+
+	long long int live_cells = 0;
+	grid.for_each_cell([&](const Cell_T& cell, const Index_T&) {
+		if (cell[Is_Alive()]) {
+			live_cells++;
+		}
+	});
+	MPI_Allreduce(MPI_IN_PLACE, &live_cells, 1, MPI_LONG_LONG_INT, MPI_SUM, comm);
+	if (rank == 0) {
+		cout << "Live cells after " << max_turns << " turns: " << live_cells << endl;
+	}
+
+	timer.report(cout, comm);
+
+	MPI_Comm_free(&comm);
+	MPI_Finalize();
+
+	return EXIT_SUCCESS;
+}
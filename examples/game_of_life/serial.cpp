@@ -35,6 +35,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "iostream"
 
 #include "gensimcell.hpp"
+#include "structured_grid.hpp"
 
 using namespace std;
 
@@ -66,16 +67,23 @@ using Cell_T = gensimcell::Cell<
 	Live_Neighbors
 >;
 
+/*
+The game grid stores cells contiguously and
+surrounds them with one layer of ghost cells
+that make the game periodic
+*/
+using Grid_T = gensimcell::Structured_Grid<Cell_T, 2>;
+
 
 /*
 Prints given game of life to standard output,
 using 0 for live cells and . for dead cells.
 */
-template<class Game_Grid> void print_game(const Game_Grid& grid)
+void print_game(const Grid_T& grid)
 {
-	for (const auto& row: grid) {
-		for (const auto& cell: row) {
-			if (cell[Is_Alive()]) {
+	for (size_t y = 0; y < grid.get_size()[1]; y++) {
+		for (size_t x = 0; x < grid.get_size()[0]; x++) {
+			if (grid[{{ptrdiff_t(x), ptrdiff_t(y)}}][Is_Alive()]) {
 				cout << "0";
 			} else {
 				cout << ".";
@@ -94,7 +102,7 @@ int main(int, char**)
 		width = 6,
 		height = 6;
 
-	array<array<Cell_T, width>, height> grid;
+	Grid_T grid({{width, height}}, 1);
 
 
 	// shorthand notation for referring to variables
@@ -102,18 +110,24 @@ int main(int, char**)
 	const Live_Neighbors live_neighbors{};
 
 
-	// initialize the game with a glider at upper left
-	for (auto& row: grid) {
-		for (auto& cell: row) {
-			cell[is_alive] = false;
-			cell[live_neighbors] = 0;
-		}
-	}
-	grid[1][2][is_alive] = true;
-	grid[2][3][is_alive] = true;
-	grid[3][3][is_alive] = true;
-	grid[3][2][is_alive] = true;
-	grid[3][1][is_alive] = true;
+	// initialize the game with a glider at upper left,
+	// cells are indexed by their x and y coordinates
+	grid.for_each_cell([&](Cell_T& cell, const Grid_T::Index_T&) {
+		cell[is_alive] = false;
+		cell[live_neighbors] = 0;
+	});
+	grid[{{2, 1}}][is_alive] = true;
+	grid[{{3, 2}}][is_alive] = true;
+	grid[{{3, 3}}][is_alive] = true;
+	grid[{{2, 3}}][is_alive] = true;
+	grid[{{1, 3}}][is_alive] = true;
+
+	// storage offsets from any cell to its neighbors
+	const auto neighbor_offsets = grid.get_offsets<8>({{
+		{{-1, -1}}, {{0, -1}}, {{1, -1}},
+		{{-1,  0}},            {{1,  0}},
+		{{-1,  1}}, {{0,  1}}, {{1,  1}}
+	}});
 
 
 	constexpr size_t max_turns = 4;
@@ -121,44 +135,34 @@ int main(int, char**)
 
 		print_game(grid);
 
-		// collect live neighbor counts, use periodic boundaries
-		for (size_t row_i = 0; row_i < grid.size(); row_i++)
-		for (size_t cell_i = 0; cell_i < grid[row_i].size(); cell_i++) {
-
-			auto& current_cell = grid[row_i][cell_i];
-
-			for (auto row_offset: {size_t(1), size_t(0), width - 1}) 
-			for (auto cell_offset: {size_t(1), size_t(0), height - 1}) {
-
-				if (row_offset == 0 and cell_offset == 0) {
-					continue;
-				}
-
-				const auto& neighbor
-					= grid[
-						(row_i + row_offset) % height
-					][
-						(cell_i + cell_offset) % width
-					];
-
-				if (neighbor[is_alive]) {
-					current_cell[live_neighbors]++;
+		// use periodic boundaries
+		grid.fill_periodic(is_alive);
+
+		// collect live neighbor counts
+		grid.for_each_cell(
+			neighbor_offsets,
+			[&](
+				Cell_T& cell,
+				const array<Cell_T*, 8>& neighbors,
+				const Grid_T::Index_T&
+			) {
+				for (const auto* neighbor: neighbors) {
+					if ((*neighbor)[is_alive]) {
+						cell[live_neighbors]++;
+					}
 				}
 			}
-		}
+		);
 
 		// set new state
-		for (size_t row_i = 0; row_i < grid.size(); row_i++)
-		for (size_t cell_i = 0; cell_i < grid[row_i].size(); cell_i++) {
-
-			auto& cell = grid[row_i][cell_i];
+		grid.for_each_cell([&](Cell_T& cell, const Grid_T::Index_T&) {
 			if (cell[live_neighbors] == 3) {
 				cell[is_alive] = true;
 			} else if (cell[live_neighbors] != 2) {
 				cell[is_alive] = false;
 			}
 			cell[live_neighbors] = 0;
-		}
+		});
 	}
 
 	print_game(grid);
@@ -75,5 +75,16 @@ int main(int, char**)
 	cout << endl;
 	// prints 3 3
 
+	// all variables of a cell can be iterated over without boost
+	gensimcell::for_each_variable(
+		cell,
+		[](auto variable, auto& data){
+			cout << decltype(cell)::index_of<decltype(variable)>()
+				<< ": " << data << " ";
+		}
+	);
+	cout << endl;
+	// prints 0: 3 1: 1.5 2: 3
+
 	return 0;
 }
@@ -0,0 +1,228 @@
+/*
+Decides when to balance load in the parallel examples.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+#ifndef LOAD_BALANCER_HPP
+#define LOAD_BALANCER_HPP
+
+#include "algorithm"
+#include "array"
+#include "cstddef"
+#include "cstdlib"
+#include "iostream"
+
+#include "mpi.h"
+
+namespace examples {
+
+/*!
+Weight of a cell given by the value of one of its variables.
+
+For example with Variable_Cost<particle::Number_Of_Internal_Particles>
+a cell costs 1 plus the number of particles in it.
+*/
+template<class Variable_T> struct Variable_Cost
+{
+	double base, factor;
+
+	Variable_Cost(const double given_base = 1, const double given_factor = 1) :
+		base(given_base),
+		factor(given_factor)
+	{}
+
+	template<class Cell_T> double operator()(const Cell_T& cell) const
+	{
+		return this->base + this->factor * double(cell[Variable_T()]);
+	}
+};
+
+
+/*!
+Sets the weight of local cells of given dccrg grid to
+the value returned by given cost(const Cell_T&) for each cell.
+*/
+template<class Grid_T, class Cost_T> void set_cell_weights(
+	Grid_T& grid,
+	const Cost_T& cost
+) {
+	for (const auto cell_id: grid.get_cells()) {
+		const auto* const cell_data = grid[cell_id];
+		if (cell_data == NULL) {
+			std::cerr << __FILE__ << ":" << __LINE__ << std::endl;
+			abort();
+		}
+		grid.set_cell_weight(cell_id, cost(*cell_data));
+	}
+}
+
+
+/*!
+Monitors the time processes spend working and tells
+them when to balance load.
+
+Example:
+@code
+examples::Load_Balancer balancer(1.2, 10);
+while (...) {
+	timer.start("solve");
+	...
+	timer.stop("solve");
+	if (balancer.is_imbalanced(timer.get_time("solve"), comm)) {
+		examples::set_cell_weights(grid, cost);
+		grid.balance_load();
+	}
+}
+@endcode
+*/
+class Load_Balancer
+{
+public:
+
+	/*!
+	Load is imbalanced if the maximum work time of processes
+	is more than max_imbalance times their average, checked
+	every check_interval steps.
+	*/
+	Load_Balancer(
+		const double given_max_imbalance = 1.2,
+		const size_t given_check_interval = 10
+	) :
+		max_imbalance(given_max_imbalance),
+		check_interval(std::max<size_t>(1, given_check_interval))
+	{}
+
+
+	/*!
+	Returns true if load should be balanced.
+
+	work_time is the total time this process has spent
+	working, excluding waiting for other processes,
+	e.g. time spent in solver phases of Phase_Timer.
+
+	Must be called once every step by all processes of given
+	communicator, returns the same value on all of them.
+	*/
+	bool is_imbalanced(const double work_time, MPI_Comm comm)
+	{
+		this->steps++;
+		if (this->steps < this->check_interval) {
+			return false;
+		}
+		this->steps = 0;
+
+		const double local_time = work_time - this->previous_work_time;
+		this->previous_work_time = work_time;
+
+		int comm_size = 0;
+		MPI_Comm_size(comm, &comm_size);
+
+		// maximum and total time in one collective
+		MPI_Datatype datatype = MPI_DATATYPE_NULL;
+		MPI_Op op = MPI_OP_NULL;
+		if (
+			MPI_Type_contiguous(2, MPI_DOUBLE, &datatype) != MPI_SUCCESS
+			or MPI_Type_commit(&datatype) != MPI_SUCCESS
+			or MPI_Op_create(&combine_max_and_total, 1, &op) != MPI_SUCCESS
+		) {
+			std::cerr << __FILE__ << ":" << __LINE__
+				<< ": Couldn't create reduction of work times."
+				<< std::endl;
+			abort();
+		}
+
+		std::array<double, 2>
+			local_max_and_total{{local_time, local_time}},
+			max_and_total{{0, 0}};
+		if (
+			MPI_Allreduce(
+				local_max_and_total.data(),
+				max_and_total.data(),
+				1,
+				datatype,
+				op,
+				comm
+			) != MPI_SUCCESS
+		) {
+			std::cerr << __FILE__ << ":" << __LINE__
+				<< ": Couldn't reduce work times."
+				<< std::endl;
+			abort();
+		}
+		MPI_Op_free(&op);
+		MPI_Type_free(&datatype);
+
+		const double average = max_and_total[1] / comm_size;
+		this->imbalance = (average > 0 ? max_and_total[0] / average : 1);
+
+		return this->imbalance > this->max_imbalance;
+	}
+
+
+	//! Returns the imbalance measured by latest check.
+	double get_imbalance() const
+	{
+		return this->imbalance;
+	}
+
+
+private:
+
+	const double max_imbalance;
+	const size_t check_interval;
+
+	size_t steps = 0;
+	double
+		previous_work_time = 0,
+		imbalance = 1;
+
+
+	/*!
+	MPI_User_function combining pairs of maximum
+	and total work time of processes.
+	*/
+	static void combine_max_and_total(
+		void* const in,
+		void* const inout,
+		int* const count,
+		MPI_Datatype*
+	) {
+		const double* const others = static_cast<const double*>(in);
+		double* const results = static_cast<double*>(inout);
+		for (int i = 0; i < *count; i++) {
+			results[2 * i] = std::max(results[2 * i], others[2 * i]);
+			results[2 * i + 1] += others[2 * i + 1];
+		}
+	}
+};
+
+} // namespace
+
+#endif // ifndef LOAD_BALANCER_HPP
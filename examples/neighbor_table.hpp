@@ -0,0 +1,427 @@
+/*
+Flat table of cell data and neighbor pointers of the parallel examples.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+#ifndef NEIGHBOR_TABLE_HPP
+#define NEIGHBOR_TABLE_HPP
+
+#include "array"
+#include "cstdint"
+#include "cstdlib"
+#include "deque"
+#include "functional"
+#include "iostream"
+#include "unordered_map"
+#include "utility"
+#include "vector"
+
+#include "dccrg.hpp"
+#include "dccrg_cartesian_geometry.hpp"
+
+namespace examples {
+
+/*!
+Pointers to data of given cells and their neighbors in a dccrg grid.
+
+Solvers iterate over the table instead of looking up each cell
+and its neighbors from the grid's hash tables every step.
+Neighbors of cell i are in positions from get_neighbors_begin(i)
+to get_neighbors_end(i) of neighbor arrays, face neighbors in
+positions from get_face_neighbors_begin(i) to get_face_neighbors_end(i)
+of face neighbor arrays. Neighbors that don't exist, e.g. outside
+of a non-periodic grid, are not included.
+
+Geometry of cells and their neighbors is cached in separate
+arrays for each dimension. Cell i of the table is at position i
+of geometry arrays and its neighbors at positions returned by
+get_neighbor_position() and get_face_neighbor_position().
+
+Pointers and geometry are valid until cells are refined or load
+is balanced, after which update() must be called even if given
+cells didn't change because dccrg rebuilds copies of remote
+neighbors and neighbors of given cells may have been refined.
+Neighbor_Tables does that automatically for tables built
+through it.
+
+Example:
+@code
+examples::Neighbor_Table<Cell> inner(grid.get_local_cells_not_on_process_boundary(), grid);
+while (...) {
+	gol::solve<Cell, gol::Is_Alive, gol::Live_Neighbors>(inner);
+	...
+	grid.balance_load();
+	inner.update(grid.get_local_cells_not_on_process_boundary(), grid);
+}
+@endcode
+*/
+template<
+	class Cell_T,
+	class Geometry_T = dccrg::Cartesian_Geometry
+> class Neighbor_Table
+{
+public:
+
+	using Grid_T = dccrg::Dccrg<Cell_T, Geometry_T>;
+
+
+	Neighbor_Table(const std::vector<uint64_t>& cell_ids, Grid_T& grid)
+	{
+		this->update(cell_ids, grid);
+	}
+
+
+	//! Rebuilds the table from given cells of given grid.
+	void update(const std::vector<uint64_t>& cell_ids, Grid_T& grid)
+	{
+		this->grid = &grid;
+		this->ids = cell_ids;
+		this->data.clear();
+		this->neighbors_begin.assign(1, 0);
+		this->neighbor_ids.clear();
+		this->neighbor_data.clear();
+		this->face_neighbors_begin.assign(1, 0);
+		this->face_neighbor_ids.clear();
+		this->face_neighbor_data.clear();
+		this->face_directions.clear();
+		this->neighbor_positions.clear();
+		this->face_neighbor_positions.clear();
+		this->geometry_ids = cell_ids;
+
+		// positions of cells in geometry arrays
+		std::unordered_map<uint64_t, size_t> positions;
+		for (size_t i = 0; i < cell_ids.size(); i++) {
+			positions[cell_ids[i]] = i;
+		}
+		const auto get_position
+			= [&](const uint64_t cell_id) {
+				const auto inserted
+					= positions.emplace(cell_id, this->geometry_ids.size());
+				if (inserted.second) {
+					this->geometry_ids.push_back(cell_id);
+				}
+				return inserted.first->second;
+			};
+
+		this->data.reserve(cell_ids.size());
+		this->neighbors_begin.reserve(cell_ids.size() + 1);
+		this->face_neighbors_begin.reserve(cell_ids.size() + 1);
+
+		for (const auto cell_id: cell_ids) {
+			this->data.push_back(this->find_data(cell_id));
+
+			const auto* const neighbors = grid.get_neighbors_of(cell_id);
+			if (neighbors == NULL) {
+				std::cerr << __FILE__ << ":" << __LINE__ << std::endl;
+				abort();
+			}
+			for (const auto neighbor_id: *neighbors) {
+				if (neighbor_id == dccrg::error_cell) {
+					continue;
+				}
+				this->neighbor_ids.push_back(neighbor_id);
+				this->neighbor_data.push_back(this->find_data(neighbor_id));
+				this->neighbor_positions.push_back(get_position(neighbor_id));
+			}
+			this->neighbors_begin.push_back(this->neighbor_ids.size());
+
+			for (const auto& item: grid.get_face_neighbors_of(cell_id)) {
+				this->face_neighbor_ids.push_back(item.first);
+				this->face_neighbor_data.push_back(this->find_data(item.first));
+				this->face_directions.push_back(item.second);
+				this->face_neighbor_positions.push_back(get_position(item.first));
+			}
+			this->face_neighbors_begin.push_back(this->face_neighbor_ids.size());
+		}
+
+		for (size_t dim = 0; dim < 3; dim++) {
+			this->min[dim].resize(this->geometry_ids.size());
+			this->max[dim].resize(this->geometry_ids.size());
+			this->length[dim].resize(this->geometry_ids.size());
+			this->inverse_length[dim].resize(this->geometry_ids.size());
+		}
+		for (size_t i = 0; i < this->geometry_ids.size(); i++) {
+			const auto
+				cell_min = grid.geometry.get_min(this->geometry_ids[i]),
+				cell_max = grid.geometry.get_max(this->geometry_ids[i]),
+				cell_length = grid.geometry.get_length(this->geometry_ids[i]);
+			for (size_t dim = 0; dim < 3; dim++) {
+				this->min[dim][i] = cell_min[dim];
+				this->max[dim][i] = cell_max[dim];
+				this->length[dim][i] = cell_length[dim];
+				this->inverse_length[dim][i] = 1 / cell_length[dim];
+			}
+		}
+
+	}
+
+
+	//! Returns the grid from which the table was built.
+	Grid_T& get_grid() const
+	{
+		return *this->grid;
+	}
+
+	//! Returns the number of cells in the table.
+	size_t size() const
+	{
+		return this->ids.size();
+	}
+
+	//! Returns ids of cells in the table in the order they were given.
+	const std::vector<uint64_t>& get_cells() const
+	{
+		return this->ids;
+	}
+
+	uint64_t get_id(const size_t i) const
+	{
+		return this->ids[i];
+	}
+
+	Cell_T* get_data(const size_t i) const
+	{
+		return this->data[i];
+	}
+
+
+	size_t get_neighbors_begin(const size_t i) const
+	{
+		return this->neighbors_begin[i];
+	}
+
+	size_t get_neighbors_end(const size_t i) const
+	{
+		return this->neighbors_begin[i + 1];
+	}
+
+	uint64_t get_neighbor_id(const size_t n) const
+	{
+		return this->neighbor_ids[n];
+	}
+
+	Cell_T* get_neighbor_data(const size_t n) const
+	{
+		return this->neighbor_data[n];
+	}
+
+
+	size_t get_face_neighbors_begin(const size_t i) const
+	{
+		return this->face_neighbors_begin[i];
+	}
+
+	size_t get_face_neighbors_end(const size_t i) const
+	{
+		return this->face_neighbors_begin[i + 1];
+	}
+
+	uint64_t get_face_neighbor_id(const size_t n) const
+	{
+		return this->face_neighbor_ids[n];
+	}
+
+	Cell_T* get_face_neighbor_data(const size_t n) const
+	{
+		return this->face_neighbor_data[n];
+	}
+
+	//! Returns the direction of face neighbor as in get_face_neighbors_of().
+	int get_face_direction(const size_t n) const
+	{
+		return this->face_directions[n];
+	}
+
+
+	//! Returns the position of neighbor n in geometry arrays.
+	size_t get_neighbor_position(const size_t n) const
+	{
+		return this->neighbor_positions[n];
+	}
+
+	//! Returns the position of face neighbor n in geometry arrays.
+	size_t get_face_neighbor_position(const size_t n) const
+	{
+		return this->face_neighbor_positions[n];
+	}
+
+	double get_min(const size_t position, const size_t dimension) const
+	{
+		return this->min[dimension][position];
+	}
+
+	double get_max(const size_t position, const size_t dimension) const
+	{
+		return this->max[dimension][position];
+	}
+
+	double get_length(const size_t position, const size_t dimension) const
+	{
+		return this->length[dimension][position];
+	}
+
+	double get_inverse_length(const size_t position, const size_t dimension) const
+	{
+		return this->inverse_length[dimension][position];
+	}
+
+
+private:
+
+	Grid_T* grid = nullptr;
+
+	std::vector<uint64_t> ids;
+	std::vector<Cell_T*> data;
+
+	// neighbors of cell i start at neighbors_begin[i]
+	std::vector<size_t> neighbors_begin;
+	std::vector<uint64_t> neighbor_ids;
+	std::vector<Cell_T*> neighbor_data;
+
+	std::vector<size_t> face_neighbors_begin;
+	std::vector<uint64_t> face_neighbor_ids;
+	std::vector<Cell_T*> face_neighbor_data;
+	std::vector<int> face_directions;
+
+	// cells of the table first, then their neighbors
+	std::vector<uint64_t> geometry_ids;
+	std::vector<size_t> neighbor_positions, face_neighbor_positions;
+	std::array<std::vector<double>, 3> min, max, length, inverse_length;
+
+
+	Cell_T* find_data(const uint64_t cell_id) const
+	{
+		Cell_T* const cell_data = (*this->grid)[cell_id];
+		if (cell_data == NULL) {
+			std::cerr << __FILE__ << ":" << __LINE__ << std::endl;
+			abort();
+		}
+		return cell_data;
+	}
+};
+
+
+/*!
+Neighbor tables of a dccrg grid that stay valid when cells
+of the grid are refined or its load is balanced.
+
+Each table is built from cells returned by the function given
+to add(), e.g. local cells on or not on process boundaries, and
+all tables are rebuilt from their functions after the grid is
+changed through balance_load() or change_grid().
+
+Example:
+@code
+examples::Neighbor_Tables<Cell> tables(grid);
+const auto& inner = tables.add(
+	[](Grid& grid) {
+		return grid.get_local_cells_not_on_process_boundary();
+	}
+);
+while (...) {
+	gol::solve<Cell, gol::Is_Alive, gol::Live_Neighbors>(inner);
+	...
+	tables.balance_load();
+}
+@endcode
+*/
+template<
+	class Cell_T,
+	class Geometry_T = dccrg::Cartesian_Geometry
+> class Neighbor_Tables
+{
+public:
+
+	using Grid_T = dccrg::Dccrg<Cell_T, Geometry_T>;
+	using Table_T = Neighbor_Table<Cell_T, Geometry_T>;
+	using Cells_Getter = std::function<std::vector<uint64_t>(Grid_T&)>;
+
+
+	explicit Neighbor_Tables(Grid_T& given_grid) :
+		grid(given_grid)
+	{}
+
+	Neighbor_Tables(const Neighbor_Tables&) = delete;
+	Neighbor_Tables& operator=(const Neighbor_Tables&) = delete;
+
+
+	/*!
+	Adds a table of cells returned by given function.
+
+	The returned reference stays valid for
+	the lifetime of this instance.
+	*/
+	const Table_T& add(Cells_Getter get_cells)
+	{
+		this->tables.emplace_back(get_cells(this->grid), this->grid);
+		this->getters.push_back(std::move(get_cells));
+		return this->tables.back();
+	}
+
+
+	//! Balances load of the grid and rebuilds all tables.
+	void balance_load()
+	{
+		this->change_grid([](Grid_T& grid) { grid.balance_load(); });
+	}
+
+	/*!
+	Calls given function with the grid and rebuilds all tables.
+
+	Refine cells or balance load of the grid,
+	e.g. with a custom transfer of cell data,
+	through this instead of directly.
+	*/
+	template<class Function> void change_grid(Function&& function)
+	{
+		std::forward<Function>(function)(this->grid);
+		this->update();
+	}
+
+	//! Rebuilds all tables from the current cells of the grid.
+	void update()
+	{
+		for (size_t i = 0; i < this->tables.size(); i++) {
+			this->tables[i].update(this->getters[i](this->grid), this->grid);
+		}
+	}
+
+
+private:
+
+	Grid_T& grid;
+	// references to tables stay valid when adding more
+	std::deque<Table_T> tables;
+	std::vector<Cells_Getter> getters;
+};
+
+} // namespace
+
+#endif // ifndef NEIGHBOR_TABLE_HPP
@@ -37,6 +37,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "cmath"
 #include "cstdlib"
 #include "iostream"
+#include "string"
 #include "vector"
 
 #include "dccrg.hpp"
@@ -48,6 +49,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "particle_save.hpp"
 #include "particle_solve.hpp"
 #include "particle_variables.hpp"
+#include "load_balancer.hpp"
+#include "neighbor_table.hpp"
+#include "particle_balance.hpp"
+#include "phase_timer.hpp"
 
 int main(int argc, char* argv[])
 {
@@ -83,7 +88,30 @@ int main(int argc, char* argv[])
 	dccrg::Dccrg<Cell, dccrg::Cartesian_Geometry> grid;
 
 	// initialize the grid
-	std::array<uint64_t, 3> grid_length = {{20, 20, 1}};
+	// number of cells in x and y dimensions can be given as first argument
+	uint64_t grid_size = 20;
+	if (argc > 1) {
+		grid_size = boost::lexical_cast<uint64_t>(argv[1]);
+	}
+	std::array<uint64_t, 3> grid_length = {{grid_size, grid_size, 1}};
+
+	/*
+	Load is balanced when the maximum solving time of processes
+	exceeds their average by given factor, e.g. 1.2
+	*/
+	double max_imbalance = 1.2;
+	if (argc > 2) {
+		max_imbalance = boost::lexical_cast<double>(argv[2]);
+	}
+
+	/*
+	If third argument is sparse particles are sent directly
+	to processes owning their destination instead of updating
+	copies of all remote neighbors of local cells
+	*/
+	const bool sparse = argc > 3 and std::string(argv[3]) == "sparse";
+	gensimcell::Sparse_Exchange<particle::Sent_Particle> particle_exchange;
+
 	const unsigned int neighborhood_size = 1;
 	if (not grid.initialize(
 		grid_length,
@@ -115,6 +143,8 @@ int main(int argc, char* argv[])
 	}
 
 	grid.balance_load();
+	// the default method ignores cell weights
+	grid.set_load_balancing_method("RCB");
 
 	/*
 	Simulate
@@ -129,14 +159,27 @@ int main(int argc, char* argv[])
 		particle::External_Particles
 	>(grid);
 
-	const std::vector<uint64_t>
-		inner_cells = grid.get_local_cells_not_on_process_boundary(),
-		outer_cells = grid.get_local_cells_on_process_boundary();
+	// data of cells and their neighbors for solvers
+	examples::Neighbor_Tables<Cell> tables(grid);
+	const auto& inner_table = tables.add(
+		[](dccrg::Dccrg<Cell, dccrg::Cartesian_Geometry>& particle_grid) {
+			return particle_grid.get_local_cells_not_on_process_boundary();
+		}
+	);
+	const auto& outer_table = tables.add(
+		[](dccrg::Dccrg<Cell, dccrg::Cartesian_Geometry>& particle_grid) {
+			return particle_grid.get_local_cells_on_process_boundary();
+		}
+	);
+
+	examples::Load_Balancer balancer(max_imbalance);
 
 	const double particle_save_interval = 0.1;
 
 	double particle_next_save = 0;
 
+	examples::Phase_Timer timer;
+
 	double
 		simulation_time = 0,
 		time_step = 0;
@@ -159,12 +202,14 @@ int main(int argc, char* argv[])
 		if (particle_next_save <= simulation_time) {
 			particle_next_save += particle_save_interval;
 
+			timer.start("save");
 			particle::save<
 				Cell,
 				particle::Number_Of_Internal_Particles,
 				particle::Velocity,
 				particle::Internal_Particles
 			>(grid, simulation_time);
+			timer.stop("save");
 		}
 
 
@@ -177,6 +222,7 @@ int main(int argc, char* argv[])
 		Propagate particles in outer cells first so the number of
 		resulting external particles can be sent to other processes.
 		*/
+		timer.start("solve");
 		next_time_step
 			= std::min(
 				next_time_step,
@@ -187,15 +233,24 @@ int main(int argc, char* argv[])
 					particle::Velocity,
 					particle::Internal_Particles,
 					particle::External_Particles
-				>(time_step, outer_cells, grid)
+				>(time_step, outer_table)
 			);
 
+		// only send particles to processes that own their destination
+		particle::bucket_external_particles<
+			Cell,
+			particle::External_Particles,
+			particle::External_Particle_Buckets
+		>(outer_table);
+
 		/*
 		Update number of particles in external lists of remote neighbors
 		so that receiving processes can allocate memory for coordinates.
 		*/
-		Cell::set_transfer_all(true, particle::Number_Of_External_Particles());
-		grid.start_remote_neighbor_copy_updates();
+		if (not sparse) {
+			Cell::set_transfer_all(true, particle::Number_Of_External_Particles());
+			grid.start_remote_neighbor_copy_updates();
+		}
 
 		/*
 		Propagate particles in inner cells while number of particles
@@ -211,63 +266,94 @@ int main(int argc, char* argv[])
 					particle::Velocity,
 					particle::Internal_Particles,
 					particle::External_Particles
-				>(time_step, inner_cells, grid)
+				>(time_step, inner_table)
 			);
+		timer.stop("solve");
 
 		/*
 		Wait for particle counts in external lists of
 		remote neighbors to arrive and allocate memory
 		required for particle coordinates.
 		*/
-		grid.wait_remote_neighbor_copy_update_receives();
-		particle::resize_receiving_containers<
-			Cell,
-			particle::Number_Of_External_Particles,
-			particle::External_Particles
-		>(grid);
-
-		grid.wait_remote_neighbor_copy_update_sends();
+		if (not sparse) {
+			timer.start("wait");
+			grid.wait_remote_neighbor_copy_update_receives();
+			timer.stop("wait");
 
-		/*
-		Start transferring coordinates of particles in external lists
-		of outer cells between processes.
-		*/
-		Cell::set_transfer_all(false, particle::Number_Of_External_Particles());
-		Cell::set_transfer_all(
-			true,
-			particle::Velocity(),
-			particle::External_Particles()
-		);
-		grid.start_remote_neighbor_copy_updates();
+			timer.start("apply");
+			particle::resize_receiving_containers<
+				Cell,
+				particle::Number_Of_External_Particles,
+				particle::External_Particles
+			>(grid);
+			timer.stop("apply");
+
+			timer.start("wait");
+			grid.wait_remote_neighbor_copy_update_sends();
+			timer.stop("wait");
+
+			/*
+			Start transferring coordinates of particles in external lists
+			of outer cells between processes.
+			*/
+			Cell::set_transfer_all(false, particle::Number_Of_External_Particles());
+			Cell::set_transfer_all(
+				true,
+				particle::Velocity(),
+				particle::External_Particles()
+			);
+			grid.start_remote_neighbor_copy_updates();
+		}
 
 		/*
 		Copy particles in external lists of neighbors
 		of inner cells to internal lists of inner cells.
 		*/
+		timer.start("apply");
 		particle::incorporate_external_particles<
 			Cell,
 			particle::Number_Of_Internal_Particles,
 			particle::Internal_Particles,
 			particle::External_Particles
-		>(inner_cells, grid);
+		>(inner_table);
+		timer.stop("apply");
 
 		/*
 		Wait for particles in external lists of other
-		processes' cells to arrive.
+		processes' cells to arrive, in sparse mode those
+		are added directly to internal lists of local cells.
 		*/
-		grid.wait_remote_neighbor_copy_update_receives();
+		timer.start("wait");
+		if (sparse) {
+			if (not particle::exchange_external_particles<
+				Cell,
+				particle::Number_Of_Internal_Particles,
+				particle::Internal_Particles,
+				particle::External_Particles,
+				particle::External_Particle_Buckets
+			>(outer_table, particle_exchange, comm)) {
+				std::cerr << __FILE__ << ":" << __LINE__
+					<< ": Couldn't exchange particles."
+					<< std::endl;
+				abort();
+			}
+		} else {
+			grid.wait_remote_neighbor_copy_update_receives();
+		}
+		timer.stop("wait");
 
 		/*
 		After receiving external lists of neighbors of
 		outer cells their particles can be copied to the
 		internal lists of local cells.
 		*/
+		timer.start("apply");
 		particle::incorporate_external_particles<
 			Cell,
 			particle::Number_Of_Internal_Particles,
 			particle::Internal_Particles,
 			particle::External_Particles
-		>(outer_cells, grid);
+		>(outer_table);
 
 		/*
 		All local cells have incorporated the particles in
@@ -277,28 +363,59 @@ int main(int argc, char* argv[])
 			Cell,
 			particle::Number_Of_External_Particles,
 			particle::External_Particles
-		>(inner_cells, grid);
+		>(inner_table);
+		timer.stop("apply");
 
 		/*
 		Wait for coordinates of local particles in external
 		lists of outer cells to arrive to other processes.
 		*/
-		grid.wait_remote_neighbor_copy_update_sends();
-		Cell::set_transfer_all(
-			false,
-			particle::Velocity(),
-			particle::External_Particles()
-		);
+		if (not sparse) {
+			timer.start("wait");
+			grid.wait_remote_neighbor_copy_update_sends();
+			timer.stop("wait");
+			Cell::set_transfer_all(
+				false,
+				particle::Velocity(),
+				particle::External_Particles()
+			);
+		}
 
 		/*
 		Once local external lists have arrived to other
 		processes they can be removed on this one.
 		*/
+		timer.start("apply");
 		particle::remove_external_particles<
 			Cell,
 			particle::Number_Of_External_Particles,
 			particle::External_Particles
-		>(outer_cells, grid);
+		>(outer_table);
+		timer.stop("apply");
+
+		/*
+		Move cells between processes if some of them
+		have spent too long solving their particles.
+		*/
+		if (balancer.is_imbalanced(
+			timer.get_time("solve") + timer.get_time("apply"),
+			comm
+		)) {
+			timer.start("balance");
+			tables.change_grid(
+				[](dccrg::Dccrg<Cell, dccrg::Cartesian_Geometry>& particle_grid) {
+					particle::balance_load<
+						Cell,
+						particle::Number_Of_Internal_Particles,
+						particle::Number_Of_External_Particles,
+						particle::Velocity,
+						particle::Internal_Particles,
+						particle::External_Particles
+					>(particle_grid, examples::Variable_Cost<particle::Number_Of_Internal_Particles>());
+				}
+			);
+			timer.stop("balance");
+		}
 
 		simulation_time += time_step;
 
@@ -307,6 +424,8 @@ int main(int argc, char* argv[])
 		time_step *= CFL;
 	}
 
+	timer.report(std::cout, comm);
+
 	MPI_Finalize();
 
 	return EXIT_SUCCESS;
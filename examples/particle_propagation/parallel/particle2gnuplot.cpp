@@ -32,16 +32,16 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 //! see ../../advection/parallel/advection2gnuplot.cpp for basics
 
-#include "boost/logic/tribool.hpp"
 #include "cstdint"
 #include "cstdlib"
 #include "fstream"
-#include "mpi.h"
+#include "iostream"
 #include "string"
-#include "tuple"
 #include "unordered_map"
 #include "vector"
 
+#include "mapped_grid_file.hpp"
+
 #include "dccrg_cartesian_geometry.hpp"
 #include "dccrg_mapping.hpp"
 #include "dccrg_topology.hpp"
@@ -53,192 +53,87 @@ using namespace particle;
 
 int main(int argc, char* argv[])
 {
-	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
-		cerr << "Coudln't initialize MPI." << endl;
-		abort();
-	}
-
-	MPI_Comm comm = MPI_COMM_WORLD;
-
-	int rank = 0, comm_size = 0;
-	MPI_Comm_rank(comm, &rank);
-	MPI_Comm_size(comm, &comm_size);
-
-
 	dccrg::Mapping mapping;
 	dccrg::Grid_Topology topology;
 	dccrg::Cartesian_Geometry geometry(mapping.length, mapping, topology);
 
+	gensimcell::Mapped_Grid_File file;
+
 	for (int i = 1; i < argc; i++) {
 
 		const string argv_string(argv[i]);
 
-		if ((i - 1) % comm_size != rank) {
+		if (not file.open(argv_string)) {
+			cerr << "Couldn't open file " << argv_string << endl;
 			continue;
 		}
 
-		MPI_File file;
-		if (
-			MPI_File_open(
-				MPI_COMM_SELF,
-				const_cast<char*>(argv_string.c_str()),
-				MPI_MODE_RDONLY,
-				MPI_INFO_NULL,
-				&file
-			) != MPI_SUCCESS
-		) {
-			cerr << "Process " << rank
-				<< " couldn't open file " << argv_string
+		// skip unncessary data
+		uint64_t offset = sizeof(uint64_t);
+
+		if (not file.read_mapping(offset, mapping, topology, geometry)) {
+			cerr << "Couldn't set cell id mapping for file " << argv_string
 				<< endl;
 			continue;
 		}
 
-		// skip unncessary data
-		MPI_Offset offset = sizeof(uint64_t);
-
-		if (not mapping.read(file, offset)) {
-			cerr << "Process " << rank
-				<< " couldn't set cell id mapping for file " << argv_string
+		// read cell ids and data offsets
+		if (not file.read_cells(offset)) {
+			cerr << "Couldn't read cell list from file " << argv_string
 				<< endl;
 			continue;
 		}
 
-		offset
-			+= mapping.data_size()
-			+ sizeof(unsigned int)
-			+ topology.data_size()
-			+ geometry.data_size();
-
-		// read number of cells
-		uint64_t total_cells = 0;
-		MPI_File_read_at(
-			file,
-			offset,
-			&total_cells,
-			1,
-			MPI_UINT64_T,
-			MPI_STATUS_IGNORE
-		);
-		offset += sizeof(uint64_t);
-
-		if (total_cells == 0) {
-			MPI_File_close(&file);
+		if (file.get_cells().size() == 0) {
 			continue;
 		}
 
-		// read cell ids and data offsets
-		vector<pair<uint64_t, uint64_t>> cells_offsets(total_cells);
-		MPI_File_read_at(
-			file,
-			offset,
-			cells_offsets.data(),
-			2 * total_cells,
-			MPI_UINT64_T,
-			MPI_STATUS_IGNORE
-		);
-
-		// read the number of particles in each cell
+		/*
+		Read cell data
+
+		dccrg writes cell data without padding in the order of
+		variables in the cell: number of particles, velocity
+		and particles, which are copied from the mapped file
+		because their coordinates aren't necessarily aligned
+		*/
 		unordered_map<
 			uint64_t,
-			Cell
+			Internal_Particles::data_type
 		> simulation_data;
 
-		/*
-		Particle data must be read in two stages as the
-		number of particles in each cell isn't known
-		prior to reading that number from the file,
-		after which the particles themselves can be read
-		*/
+		for (size_t cell_i = 0; cell_i < file.get_cells().size(); cell_i++) {
+			const uint64_t cell_id = file.get_cells()[cell_i];
 
-		for (const auto& item: cells_offsets) {
-			const uint64_t cell_id = item.first;
-			uint64_t file_address = item.second;
-
-			simulation_data[cell_id];
-			auto& cell_data = simulation_data.at(cell_id);
-
-			void* memory_address = NULL;
-			int memory_count = -1;
-			MPI_Datatype
-				memory_datatype = MPI_DATATYPE_NULL,
-				file_datatype = MPI_DATATYPE_NULL;
-
-			// read constant sized data
-			cell_data.set_transfer_all(true, Number_Of_Internal_Particles(), Velocity());
-
-			tie(
-				memory_address,
-				memory_count,
-				memory_datatype
-			) = cell_data.get_mpi_datatype();
-			MPI_Type_commit(&memory_datatype);
-
-			int sizeof_memory_datatype;
-			MPI_Type_size(memory_datatype, &sizeof_memory_datatype);
-			MPI_Type_contiguous(sizeof_memory_datatype, MPI_BYTE, &file_datatype);
-			MPI_Type_commit(&file_datatype);
-
-			MPI_File_set_view(
-				file,
-				file_address,
-				MPI_BYTE,
-				file_datatype,
-				const_cast<char*>("native"),
-				MPI_INFO_NULL
-			);
-
-			MPI_File_read_at(
-				file,
-				0,
-				memory_address,
-				memory_count,
-				memory_datatype,
-				MPI_STATUS_IGNORE
-			);
-			file_address += sizeof_memory_datatype;
-			MPI_Type_free(&memory_datatype);
-			MPI_Type_free(&file_datatype);
-
-			cell_data[Internal_Particles()].resize(cell_data[Number_Of_Internal_Particles()]);
-
-			// read the particle coordinates and velocity
-			cell_data.set_transfer_all(false, Number_Of_Internal_Particles(), Velocity());
-			cell_data.set_transfer_all(true, Internal_Particles());
-
-			tie(
-				memory_address,
-				memory_count,
-				memory_datatype
-			) = cell_data.get_mpi_datatype();
-			MPI_Type_commit(&memory_datatype);
-
-			MPI_Type_size(memory_datatype, &sizeof_memory_datatype);
-			MPI_Type_contiguous(sizeof_memory_datatype, MPI_BYTE, &file_datatype);
-			MPI_Type_commit(&file_datatype);
-
-			MPI_File_set_view(
-				file,
-				file_address,
-				MPI_BYTE,
-				file_datatype,
-				const_cast<char*>("native"),
-				MPI_INFO_NULL
-			);
-
-			MPI_File_read_at(
-				file,
-				0,
-				memory_address,
-				memory_count,
-				memory_datatype,
-				MPI_STATUS_IGNORE
-			);
-			file_address += sizeof_memory_datatype;
-			MPI_Type_free(&file_datatype);
+			uint64_t cell_offset = file.get_cell_data_offset(cell_i);
+
+			Number_Of_Internal_Particles::data_type number_of_particles = 0;
+			if (not file.read(cell_offset, number_of_particles)) {
+				cerr << "Couldn't read number of particles of cell " << cell_id
+					<< " from file " << argv_string
+					<< endl;
+				continue;
+			}
+			cell_offset
+				+= sizeof(Number_Of_Internal_Particles::data_type)
+				+ sizeof(Velocity::data_type);
+
+			auto& particles = simulation_data[cell_id];
+			particles.resize(number_of_particles);
+			if (
+				not file.read(
+					cell_offset,
+					particles.data(),
+					particles.size()
+				)
+			) {
+				cerr << "Couldn't read particles of cell " << cell_id
+					<< " from file " << argv_string
+					<< endl;
+				particles.clear();
+			}
 		}
 
-		MPI_File_close(&file);
-		cells_offsets.clear();
+		file.close();
 
 		const string
 			gnuplot_file_name(argv_string + ".dat"),
@@ -259,7 +154,7 @@ int main(int argc, char* argv[])
 		size_t total_particles = 0;
 		for (const auto& item: simulation_data) {
 			const auto& cell_id = item.first;
-			const auto& cell_data = item.second;
+			const auto& particles = item.second;
 
 			// plot particles in cells at z index 0
 			const auto index = mapping.get_indices(cell_id);
@@ -267,7 +162,7 @@ int main(int argc, char* argv[])
 				continue;
 			}
 
-			for (const auto& particle: cell_data[Internal_Particles()]) {
+			for (const auto& particle: particles) {
 				total_particles++;
 				gnuplot_file
 					<< particle[0] << " "
@@ -281,7 +176,5 @@ int main(int argc, char* argv[])
 		system(("gnuplot " + gnuplot_file_name).c_str());
 	}
 
-	MPI_Finalize();
-
 	return EXIT_SUCCESS;
 }
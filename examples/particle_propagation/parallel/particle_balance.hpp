@@ -0,0 +1,120 @@
+/*
+Balances load of parallel particle propagator program.
+
+Copyright 2014, 2015, 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef PARTICLE_BALANCE_HPP
+#define PARTICLE_BALANCE_HPP
+
+#include "cstdlib"
+#include "iostream"
+
+#include "dccrg.hpp"
+#include "dccrg_cartesian_geometry.hpp"
+
+#include "gensimcell.hpp"
+#include "load_balancer.hpp"
+
+//! see ../serial.cpp for the basics
+
+namespace particle {
+
+/*!
+Balances load of given grid using cell weights from given cost.
+
+Cells are moved between processes in two phases, like external
+particles of remote neighbors in main.cpp: first the number of
+internal particles and velocity, after which memory for particle
+coordinates is allocated in arrived cells, and then coordinates.
+External particle lists must be empty, e.g. after
+remove_external_particles() of all local cells.
+
+Transfer of all variables is switched off afterwards.
+Local cells and their neighbors can change so neighbor
+tables of local cells must be updated afterwards, e.g. by
+calling this through examples::Neighbor_Tables::change_grid().
+*/
+template<
+	class Cell_T,
+	class Number_Of_Internal_Particles_T,
+	class Number_Of_External_Particles_T,
+	class Velocity_T,
+	class Internal_Particles_T,
+	class External_Particles_T,
+	class Cost_T
+> void balance_load(
+	dccrg::Dccrg<Cell_T, dccrg::Cartesian_Geometry>& grid,
+	const Cost_T& cost
+) {
+	examples::set_cell_weights(grid, cost);
+
+	Cell_T::set_transfer_all(
+		false,
+		Number_Of_External_Particles_T(),
+		Internal_Particles_T(),
+		External_Particles_T()
+	);
+	Cell_T::set_transfer_all(
+		true,
+		Number_Of_Internal_Particles_T(),
+		Velocity_T()
+	);
+
+	grid.initialize_balance_load(true);
+	grid.continue_balance_load();
+
+	for (const auto cell_id: grid.get_cells_added_by_balance_load()) {
+		auto* const cell_data = grid[cell_id];
+		if (cell_data == NULL) {
+			std::cerr << __FILE__ << ":" << __LINE__ << std::endl;
+			abort();
+		}
+
+		(*cell_data)[Internal_Particles_T()]
+			.resize((*cell_data)[Number_Of_Internal_Particles_T()]);
+		(*cell_data)[Number_Of_External_Particles_T()] = 0;
+		(*cell_data)[External_Particles_T()].clear();
+	}
+
+	Cell_T::set_transfer_all(
+		false,
+		Number_Of_Internal_Particles_T(),
+		Velocity_T()
+	);
+	Cell_T::set_transfer_all(true, Internal_Particles_T());
+	grid.continue_balance_load();
+	grid.finish_balance_load();
+
+	Cell_T::set_transfer_all(false, Internal_Particles_T());
+}
+
+} // namespace
+
+#endif // ifndef PARTICLE_BALANCE_HPP
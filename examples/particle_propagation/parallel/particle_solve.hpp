@@ -34,6 +34,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define PARTICLE_SOLVE_HPP
 
 
+#include "algorithm"
+#include "array"
+#include "cstdint"
 #include "cstdlib"
 #include "iostream"
 #include "vector"
@@ -42,6 +45,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "dccrg_cartesian_geometry.hpp"
 
 #include "gensimcell.hpp"
+#include "neighbor_table.hpp"
+#include "sparse_exchange.hpp"
 
 
 //! see ../serial.cpp for the basics
@@ -50,6 +55,37 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 namespace particle {
 
 
+/*!
+Orders external particles by their destination cell.
+
+Can also compare a particle to a destination cell, e.g. in
+std::equal_range(), to find the particles of a destination.
+*/
+struct Destination_Less
+{
+	template<class Particle_T> bool operator()(
+		const Particle_T& a,
+		const Particle_T& b
+	) const {
+		return a.second < b.second;
+	}
+
+	template<class Particle_T> bool operator()(
+		const Particle_T& particle,
+		const uint64_t destination
+	) const {
+		return particle.second < destination;
+	}
+
+	template<class Particle_T> bool operator()(
+		const uint64_t destination,
+		const Particle_T& particle
+	) const {
+		return destination < particle.second;
+	}
+};
+
+
 /*!
 Allocates space in each copy of a remote neighbor
 in given grid to hold as many particles as given by
@@ -77,13 +113,122 @@ template<
 
 
 /*!
-Propagates particles in given cells for a given amount of time.
+Propagates particles in cells of given table for a given amount of time.
 
 Returns the longest allowed time step for given cells
 and their neighbors. Particles which propagate outside of the
 cell in which they are stored are moved to the External_Particles_T
 list of their previous cell and added to Particle_Destinations_T
-information.
+information. External particles of each cell are sorted by their
+destination so that each destination's particles are contiguous.
+*/
+template<
+	class Cell_T,
+	class Number_Of_Internal_Particles_T,
+	class Number_Of_External_Particles_T,
+	class Velocity_T,
+	class Internal_Particles_T,
+	class External_Particles_T,
+	class Geometry_T
+> double solve(
+	const double dt,
+	const examples::Neighbor_Table<Cell_T, Geometry_T>& cells
+) {
+	const auto& grid = cells.get_grid();
+
+	double max_time_step = std::numeric_limits<double>::max();
+
+	// propagate particles and maybe move from internal to external list
+	for (size_t cell_i = 0; cell_i < cells.size(); cell_i++) {
+
+		auto* const cell_data = cells.get_data(cell_i);
+
+		// shorthand notation
+		const auto& vel = (*cell_data)[Velocity_T()];
+		auto& int_particles = (*cell_data)[Internal_Particles_T()];
+
+		for (size_t i = 0; i < int_particles.size(); i++) {
+			auto& coordinate = int_particles[i];
+
+			coordinate[0] += vel[0] * dt;
+			coordinate[1] += vel[1] * dt;
+
+			// handle periodic grid
+			coordinate = grid.geometry.get_real_coordinate(coordinate);
+
+			// move to ext list if particle outside of current cell
+			if (
+				coordinate[0] < cells.get_min(cell_i, 0)
+				or coordinate[0] > cells.get_max(cell_i, 0)
+				or coordinate[1] < cells.get_min(cell_i, 1)
+				or coordinate[1] > cells.get_max(cell_i, 1)
+				or coordinate[2] < cells.get_min(cell_i, 2)
+				or coordinate[2] > cells.get_max(cell_i, 2)
+			) {
+				uint64_t destination = dccrg::error_cell;
+
+				for (
+					size_t neighbor = cells.get_neighbors_begin(cell_i);
+					neighbor < cells.get_neighbors_end(cell_i);
+					neighbor++
+				) {
+					const size_t position = cells.get_neighbor_position(neighbor);
+
+					if (
+						coordinate[0] >= cells.get_min(position, 0)
+						and coordinate[0] <= cells.get_max(position, 0)
+						and coordinate[1] >= cells.get_min(position, 1)
+						and coordinate[1] <= cells.get_max(position, 1)
+						and coordinate[2] >= cells.get_min(position, 2)
+						and coordinate[2] <= cells.get_max(position, 2)
+					) {
+						destination = cells.get_neighbor_id(neighbor);
+						break;
+					}
+				}
+
+				if (destination != dccrg::error_cell) {
+					(*cell_data)[External_Particles_T()]
+						.emplace_back(coordinate, destination);
+
+					int_particles.erase(int_particles.begin() + i);
+					i--;
+				}
+			}
+		}
+
+		// group external particles by destination for receivers
+		auto& ext_particles = (*cell_data)[External_Particles_T()];
+		std::stable_sort(
+			ext_particles.begin(),
+			ext_particles.end(),
+			Destination_Less()
+		);
+
+		(*cell_data)[Number_Of_Internal_Particles_T()] = int_particles.size();
+		(*cell_data)[Number_Of_External_Particles_T()] = ext_particles.size();
+
+		// check time step
+		max_time_step =
+			std::min(max_time_step,
+			std::min(
+				fabs(cells.get_length(cell_i, 0) / vel[0]),
+				fabs(cells.get_length(cell_i, 1) / vel[1])
+			));
+	}
+
+	return max_time_step;
+}
+
+/*!
+Propagates particles in given cells for a given amount of time.
+
+Looks up given cells and their neighbors from given
+grid, use the version taking a Neighbor_Table to
+avoid that when solving the same cells repeatedly.
+External particles are not sorted by destination
+so they must be incorporated with the version of
+incorporate_external_particles() taking cell ids.
 */
 template<
 	class Cell_T,
@@ -192,9 +337,60 @@ template<
 }
 
 
+/*!
+Copies particles from the external particle lists of neighbors
+of cells in given table into internal particle lists of those cells.
+
+External particle lists must be sorted by destination as in solve().
+*/
+template<
+	class Cell_T,
+	class Number_Of_Internal_Particles_T,
+	class Internal_Particles_T,
+	class External_Particles_T,
+	class Geometry_T
+> void incorporate_external_particles(
+	const examples::Neighbor_Table<Cell_T, Geometry_T>& cells
+) {
+	for (size_t i = 0; i < cells.size(); i++) {
+
+		const auto cell_id = cells.get_id(i);
+		auto* const cell_data = cells.get_data(i);
+
+		auto& int_particles = (*cell_data)[Internal_Particles_T()];
+
+		// assign some particles from neighbors' external list to this cell
+		for (
+			size_t neighbor = cells.get_neighbors_begin(i);
+			neighbor < cells.get_neighbors_end(i);
+			neighbor++
+		) {
+			const auto& neigh_ext_particles
+				= (*cells.get_neighbor_data(neighbor))[External_Particles_T()];
+
+			// only read particles destined to this cell
+			const auto bucket = std::equal_range(
+				neigh_ext_particles.begin(),
+				neigh_ext_particles.end(),
+				cell_id,
+				Destination_Less()
+			);
+			for (auto particle = bucket.first; particle != bucket.second; particle++) {
+				int_particles.emplace_back(particle->first);
+			}
+		}
+
+		(*cell_data)[Number_Of_Internal_Particles_T()] = int_particles.size();
+	}
+}
+
 /*!
 Copies particles from the external particle lists of neighbors
 of given cells into internal particle lists of given cells.
+
+Looks up given cells and their neighbors from given
+grid, use the version taking a Neighbor_Table to
+avoid that when solving the same cells repeatedly.
 */
 template<
 	class Cell_T,
@@ -253,6 +449,167 @@ template<
 }
 
 
+/*!
+Records which process owns the destination of each
+group of external particles in cells of given table.
+
+Cells that record this information, e.g. particle::Cell,
+send to other processes only the external particles destined
+to their cells. Must be called after solve() and before
+transferring external particles of given cells.
+*/
+template<
+	class Cell_T,
+	class External_Particles_T,
+	class External_Particle_Buckets_T,
+	class Geometry_T
+> void bucket_external_particles(
+	const examples::Neighbor_Table<Cell_T, Geometry_T>& cells
+) {
+	const auto& grid = cells.get_grid();
+
+	for (size_t i = 0; i < cells.size(); i++) {
+		auto* const cell_data = cells.get_data(i);
+
+		const auto& ext_particles = (*cell_data)[External_Particles_T()];
+		auto& buckets = (*cell_data)[External_Particle_Buckets_T()];
+		buckets.buckets.clear();
+		buckets.process_counts.clear();
+
+		size_t begin = 0;
+		while (begin < ext_particles.size()) {
+			const auto destination = ext_particles[begin].second;
+			size_t end = begin + 1;
+			while (
+				end < ext_particles.size()
+				and ext_particles[end].second == destination
+			) {
+				end++;
+			}
+
+			const int process = int(grid.get_process(destination));
+			buckets.buckets.push_back({destination, process, begin, end});
+
+			auto count = buckets.process_counts.begin();
+			while (
+				count != buckets.process_counts.end()
+				and count->first != process
+			) {
+				count++;
+			}
+			if (count == buckets.process_counts.end()) {
+				buckets.process_counts.emplace_back(process, 0);
+				count = buckets.process_counts.end() - 1;
+			}
+			count->second += end - begin;
+
+			begin = end;
+		}
+	}
+}
+
+
+//! External particle sent to the process of its destination.
+struct Sent_Particle
+{
+	std::array<double, 3> coordinate;
+	unsigned long long int destination;
+};
+
+
+/*!
+Sends external particles of cells in given table to
+processes that own their destinations, instead of updating
+copies of remote neighbors, and adds particles received from
+other processes to internal lists of their destinations.
+
+Only processes with particles for each other exchange messages.
+External particles must have been bucketed with
+bucket_external_particles(), those destined to local cells
+are incorporated by incorporate_external_particles() as usual
+for which copies of remote neighbors must not have external
+particles. Must be called by all processes of given
+communicator, returns false if the exchange failed.
+*/
+template<
+	class Cell_T,
+	class Number_Of_Internal_Particles_T,
+	class Internal_Particles_T,
+	class External_Particles_T,
+	class External_Particle_Buckets_T,
+	class Geometry_T
+> bool exchange_external_particles(
+	const examples::Neighbor_Table<Cell_T, Geometry_T>& cells,
+	gensimcell::Sparse_Exchange<Sent_Particle>& exchange,
+	MPI_Comm comm
+) {
+	auto& grid = cells.get_grid();
+
+	int rank = -1;
+	MPI_Comm_rank(comm, &rank);
+
+	for (size_t i = 0; i < cells.size(); i++) {
+		const auto* const cell_data = cells.get_data(i);
+		const auto& ext_particles = (*cell_data)[External_Particles_T()];
+		const auto& buckets = (*cell_data)[External_Particle_Buckets_T()];
+
+		if (not buckets.is_valid(ext_particles)) {
+			std::cerr << __FILE__ << ":" << __LINE__
+				<< ": External particles not bucketed."
+				<< std::endl;
+			abort();
+		}
+
+		for (const auto& bucket: buckets.buckets) {
+			if (bucket.process == rank) {
+				continue;
+			}
+			auto& sent = exchange.get_send_items(bucket.process);
+			for (size_t j = bucket.begin; j < bucket.end; j++) {
+				sent.push_back({ext_particles[j].first, ext_particles[j].second});
+			}
+		}
+	}
+
+	return exchange.exchange(
+		comm,
+		[&](const int, const std::vector<Sent_Particle>& particles) {
+			for (const auto& particle: particles) {
+				auto* const cell_data = grid[particle.destination];
+				if (cell_data == NULL) {
+					std::cerr << __FILE__ << ":" << __LINE__ << std::endl;
+					abort();
+				}
+
+				auto& int_particles = (*cell_data)[Internal_Particles_T()];
+				int_particles.emplace_back(particle.coordinate);
+				(*cell_data)[Number_Of_Internal_Particles_T()] = int_particles.size();
+			}
+		}
+	);
+}
+
+
+/*!
+Removes particles from the external particle list of cells in given table.
+
+Updates number of external particles.
+*/
+template<
+	class Cell_T,
+	class Number_Of_External_Particles_T,
+	class External_Particles_T,
+	class Geometry_T
+> void remove_external_particles(
+	const examples::Neighbor_Table<Cell_T, Geometry_T>& cells
+) {
+	for (size_t i = 0; i < cells.size(); i++) {
+		auto* const cell_data = cells.get_data(i);
+		(*cell_data)[Number_Of_External_Particles_T()] = 0;
+		(*cell_data)[External_Particles_T()].clear();
+	}
+}
+
 /*!
 Removes particles from the external particle list of given cells.
 
@@ -35,7 +35,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
 #include "array"
+#include "cstddef"
+#include "cstdint"
 #include "tuple"
+#include "utility"
 #include "vector"
 
 #include "mpi.h" // must be included before gensimcell
@@ -52,13 +55,26 @@ using a unique namespace for each one.
 namespace particle {
 
 
+/*!
+Memory of particle lists is shared between cells.
+
+Particles move between cells every step which
+otherwise would allocate and free memory of
+particle lists repeatedly.
+*/
+struct Particle_Pool {};
+
+
 /*!
 Particles whose coordinates are inside of
 the cell in which they are stored.
 */
 struct Internal_Particles
 {
-	using data_type = std::vector<std::array<double, 3>>;
+	using data_type = std::vector<
+		std::array<double, 3>,
+		gensimcell::Pool_Allocator<std::array<double, 3>, Particle_Pool>
+	>;
 };
 
 
@@ -75,6 +91,10 @@ struct External_Particles
 			std::pair<
 				std::array<double, 3>, // coordinate
 				unsigned long long int // destination cell
+			>,
+			gensimcell::Pool_Allocator<
+				std::pair<std::array<double, 3>, unsigned long long int>,
+				Particle_Pool
 			>
 		>;
 };
@@ -110,6 +130,76 @@ struct Velocity
 };
 
 
+/*!
+Groups of external particles of a cell with the same
+destination and processes that own the destinations.
+
+Filled by bucket_external_particles() and only used
+by the process that owns the cell.
+*/
+struct Destination_Buckets
+{
+	struct Bucket
+	{
+		unsigned long long int destination;
+		int process;
+		// range of particles in external list
+		size_t begin, end;
+	};
+
+	std::vector<Bucket> buckets;
+
+	//! Number of external particles going to each process
+	std::vector<std::pair<int, unsigned long long int>> process_counts;
+
+	//! Number of external particles going to other processes
+	unsigned long long int no_particles = 0;
+
+
+	//! Returns true if buckets are up to date with given external particles.
+	template<class External_Particles_T> bool is_valid(
+		const External_Particles_T& ext_particles
+	) const {
+		size_t end = 0;
+		for (const auto& bucket: this->buckets) {
+			if (
+				bucket.begin != end
+				or bucket.end <= bucket.begin
+				or bucket.end > ext_particles.size()
+				or ext_particles[bucket.begin].second != bucket.destination
+				or ext_particles[bucket.end - 1].second != bucket.destination
+			) {
+				return false;
+			}
+			end = bucket.end;
+		}
+		return end == ext_particles.size();
+	}
+
+	//! Returns the number of external particles going to given process.
+	const unsigned long long int& get_count(const int process) const
+	{
+		for (const auto& count: this->process_counts) {
+			if (count.first == process) {
+				return count.second;
+			}
+		}
+		return this->no_particles;
+	}
+
+	//! Never transferred
+	std::tuple<void*, int, MPI_Datatype> get_mpi_datatype() const
+	{
+		return std::make_tuple((void*) NULL, 0, MPI_BYTE);
+	}
+};
+
+struct External_Particle_Buckets
+{
+	using data_type = Destination_Buckets;
+};
+
+
 /*!
 Cell definition for the particle propagation example.
 
@@ -118,15 +208,212 @@ are saved at a known position in the file by dccrg.
 The cell class puts the variables in an MPI datatype
 in the same order as they are given here, which
 dccrg will use to save the file.
+
+When sending external particles to another process
+only the particles destined to cells of that process
+are sent, if they have been bucketed by
+bucket_external_particles().
 */
-using Cell = gensimcell::Cell<
+class Cell : public gensimcell::Cell<
 	gensimcell::Optional_Transfer,
 	Number_Of_Internal_Particles,
 	Number_Of_External_Particles,
 	Velocity,
 	Internal_Particles,
-	External_Particles
->;
+	External_Particles,
+	External_Particle_Buckets
+> {
+public:
+
+	using Base = gensimcell::Cell<
+		gensimcell::Optional_Transfer,
+		Number_Of_Internal_Particles,
+		Number_Of_External_Particles,
+		Velocity,
+		Internal_Particles,
+		External_Particles,
+		External_Particle_Buckets
+	>;
+
+	using Base::get_mpi_datatype;
+
+
+	//! Called by dccrg when transferring cell data.
+	std::tuple<void*, int, MPI_Datatype> get_mpi_datatype(
+		const uint64_t,
+		const int,
+		const int receiver,
+		const bool receiving,
+		const int
+	) const {
+		const auto& ext_particles = (*this)[External_Particles()];
+		const auto& buckets = (*this)[External_Particle_Buckets()];
+
+		if (
+			receiving
+			or not (
+				this->is_transferred(Number_Of_External_Particles())
+				or this->is_transferred(External_Particles())
+			)
+			or not buckets.is_valid(ext_particles)
+		) {
+			return this->get_mpi_datatype();
+		}
+
+		std::array<void*, 5> addresses;
+		std::array<int, 5> counts;
+		std::array<MPI_Datatype, 5> datatypes;
+		size_t nr_vars = 0;
+
+		const auto add
+			= [&](const std::tuple<void*, int, MPI_Datatype>& info) {
+				std::tie(
+					addresses[nr_vars],
+					counts[nr_vars],
+					datatypes[nr_vars]
+				) = info;
+				nr_vars++;
+			};
+
+		// same order as in the cell
+		if (this->is_transferred(Number_Of_Internal_Particles())) {
+			add(gensimcell::detail::get_var_mpi_datatype(
+				(*this)[Number_Of_Internal_Particles()]
+			));
+		}
+		if (this->is_transferred(Number_Of_External_Particles())) {
+			add(gensimcell::detail::get_var_mpi_datatype(
+				buckets.get_count(receiver)
+			));
+		}
+		if (this->is_transferred(Velocity())) {
+			add(gensimcell::detail::get_var_mpi_datatype((*this)[Velocity()]));
+		}
+		if (this->is_transferred(Internal_Particles())) {
+			add(gensimcell::detail::get_var_mpi_datatype(
+				(*this)[Internal_Particles()]
+			));
+		}
+		if (this->is_transferred(External_Particles())) {
+			add(this->get_external_particles_datatype(receiver));
+		}
+
+		// skip variables with nothing to transfer
+		size_t nr_transferred = 0;
+		for (size_t i = 0; i < nr_vars; i++) {
+			if (counts[i] < 0) {
+				return std::make_tuple((void*) NULL, -1, MPI_DATATYPE_NULL);
+			}
+			if (counts[i] > 0) {
+				addresses[nr_transferred] = addresses[i];
+				counts[nr_transferred] = counts[i];
+				datatypes[nr_transferred] = datatypes[i];
+				nr_transferred++;
+			}
+		}
+
+		if (nr_transferred == 0) {
+			return std::make_tuple((void*) NULL, 0, MPI_BYTE);
+		}
+		if (nr_transferred == 1) {
+			return std::make_tuple(addresses[0], counts[0], datatypes[0]);
+		}
+
+		std::array<MPI_Aint, 5> displacements;
+		for (size_t i = 0; i < nr_transferred; i++) {
+			displacements[i]
+				= static_cast<char*>(addresses[i])
+				- static_cast<char*>(addresses[0]);
+		}
+
+		MPI_Datatype final_datatype = MPI_DATATYPE_NULL;
+		const int result = MPI_Type_create_struct(
+			int(nr_transferred),
+			counts.data(),
+			displacements.data(),
+			datatypes.data(),
+			&final_datatype
+		);
+		for (size_t i = 0; i < nr_transferred; i++) {
+			gensimcell::detail::free_derived_datatype(datatypes[i]);
+		}
+		if (result != MPI_SUCCESS) {
+			return std::make_tuple((void*) NULL, -1, MPI_DATATYPE_NULL);
+		}
+
+		return std::make_tuple(addresses[0], 1, final_datatype);
+	}
+
+
+private:
+
+	/*!
+	Returns transfer info of external particles destined
+	to given process with the same type signature as
+	when receiving them into a list of the same length.
+	*/
+	std::tuple<void*, int, MPI_Datatype> get_external_particles_datatype(
+		const int receiver
+	) const {
+		const auto& ext_particles = (*this)[External_Particles()];
+		const auto& buckets = (*this)[External_Particle_Buckets()];
+
+		std::vector<int> lengths, offsets;
+		for (const auto& bucket: buckets.buckets) {
+			if (bucket.process == receiver) {
+				lengths.push_back(int(bucket.end - bucket.begin));
+				offsets.push_back(int(bucket.begin));
+			}
+		}
+		if (lengths.size() == 0) {
+			return std::make_tuple((void*) NULL, 0, MPI_BYTE);
+		}
+
+		// datatype of one particle with the extent of a list item
+		void* address = NULL;
+		int count = -1;
+		MPI_Datatype item_datatype = MPI_DATATYPE_NULL;
+		std::tie(address, count, item_datatype)
+			= gensimcell::detail::get_var_mpi_datatype(ext_particles[0]);
+		if (count < 0) {
+			return std::make_tuple((void*) NULL, -1, MPI_DATATYPE_NULL);
+		}
+
+		const MPI_Aint displacement
+			= static_cast<const char*>(address)
+			- reinterpret_cast<const char*>(ext_particles.data());
+
+		MPI_Datatype particle_datatype = MPI_DATATYPE_NULL, resized = MPI_DATATYPE_NULL;
+		MPI_Type_create_struct(1, &count, &displacement, &item_datatype, &particle_datatype);
+		gensimcell::detail::free_derived_datatype(item_datatype);
+		MPI_Type_create_resized(
+			particle_datatype,
+			0,
+			sizeof(ext_particles[0]),
+			&resized
+		);
+		MPI_Type_free(&particle_datatype);
+
+		MPI_Datatype final_datatype = MPI_DATATYPE_NULL;
+		const int result = MPI_Type_indexed(
+			int(lengths.size()),
+			lengths.data(),
+			offsets.data(),
+			resized,
+			&final_datatype
+		);
+		MPI_Type_free(&resized);
+		if (result != MPI_SUCCESS) {
+			return std::make_tuple((void*) NULL, -1, MPI_DATATYPE_NULL);
+		}
+
+		return std::make_tuple(
+			const_cast<void*>(static_cast<const void*>(ext_particles.data())),
+			1,
+			final_datatype
+		);
+	}
+};
 
 
 } // namespace
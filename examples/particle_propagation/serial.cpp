@@ -45,6 +45,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "vector"
 
 #include "gensimcell.hpp"
+#include "structured_grid.hpp"
 
 
 using namespace std;
@@ -77,8 +78,13 @@ constexpr size_t
 	width = 20,
 	height = 20;
 
-using Grid_T = array<array<Cell_T, width>, height>;
-Grid_T grid;
+/*!
+Particles are moved directly between interior cells
+so ghost cells aren't needed.
+*/
+using Grid_T = gensimcell::Structured_Grid<Cell_T, 2>;
+using Index_T = Grid_T::Index_T;
+Grid_T grid({{width, height}}, 0);
 
 
 /*!
@@ -124,15 +130,15 @@ string save(
 	// color the particles for easier visualization
 	size_t color = 0;
 
-	for (const auto& row: grid)
-	for (const auto& cell: row)
-	for (const auto& coordinate: cell[Particles()]) {
-		gnuplot_file
-			<< coordinate[0] << " "
-			<< coordinate[1] << " "
-			<< color << "\n";
-		color++;
-	}
+	grid.for_each_cell([&](const Cell_T& cell, const Index_T&) {
+		for (const auto& coordinate: cell[Particles()]) {
+			gnuplot_file
+				<< coordinate[0] << " "
+				<< coordinate[1] << " "
+				<< color << "\n";
+			color++;
+		}
+	});
 	gnuplot_file << "end" << endl;
 
 	return gnuplot_file_name;
@@ -147,11 +153,12 @@ second in vertical (y).
 */
 array<double, 2> get_cell_center(
 	const Grid_T& grid,
-	const array<size_t, 2>& index
+	const Index_T& index
 ) {
+	const auto& size = grid.get_size();
 	if (
-		index[1] >= grid.size()
-		or index[0] >= grid[index[1]].size()
+		index[0] < 0 or size_t(index[0]) >= size[0]
+		or index[1] < 0 or size_t(index[1]) >= size[1]
 	) {
 		return {{
 			std::numeric_limits<double>::quiet_NaN(),
@@ -160,8 +167,8 @@ array<double, 2> get_cell_center(
 	}
 
 	return {{
-		-1.0 + (0.5 + index[0]) * 2.0 / grid[index[1]].size(),
-		-1.0 + (0.5 + index[1]) * 2.0 / grid.size()
+		-1.0 + (0.5 + index[0]) * 2.0 / size[0],
+		-1.0 + (0.5 + index[1]) * 2.0 / size[1]
 	}};
 }
 
@@ -172,11 +179,12 @@ at given x and y indices in the grid.
 */
 array<double, 2> get_cell_size(
 	const Grid_T& grid,
-	const array<size_t, 2>& index
+	const Index_T& index
 ) {
+	const auto& size = grid.get_size();
 	if (
-		index[1] >= grid.size()
-		or index[0] >= grid[index[1]].size()
+		index[0] < 0 or size_t(index[0]) >= size[0]
+		or index[1] < 0 or size_t(index[1]) >= size[1]
 	) {
 		return {{
 			std::numeric_limits<double>::quiet_NaN(),
@@ -185,8 +193,8 @@ array<double, 2> get_cell_size(
 	}
 
 	return {{
-		2.0 / grid.size(),
-		2.0 / grid[index[1]].size()
+		2.0 / size[0],
+		2.0 / size[1]
 	}};
 }
 
@@ -196,25 +204,26 @@ Initializes cells in given grid with 3 particles
 */
 void initialize(Grid_T& grid)
 {
-	for (size_t row_i = 0; row_i < height; row_i++)
-	for (size_t cell_i = 0; cell_i < width; cell_i++) {
+	grid.for_each_cell([&](Cell_T& cell, const Index_T& index) {
 
 		const auto
-			cell_center = get_cell_center(grid, {{cell_i, row_i}}),
-			cell_size = get_cell_size(grid, {{cell_i, row_i}});
+			cell_center = get_cell_center(grid, index),
+			cell_size = get_cell_size(grid, index);
 
-		auto& cell = grid[row_i][cell_i];
 		cell[Velocity()][0] = -2 * cell_center[1];
 		cell[Velocity()][1] = +2 * cell_center[0];
 
 		// don't create particles too close to the edges
+		const size_t
+			row_i = size_t(index[1]),
+			cell_i = size_t(index[0]);
 		if (
 			row_i < height / 4
 			or row_i >= height - height / 4
 			or cell_i < width / 4
 			or cell_i >= width - width / 4
 		) {
-			continue;
+			return;
 		}
 
 		cell[Particles()].push_back({{
@@ -229,7 +238,7 @@ void initialize(Grid_T& grid)
 				cell_center[0] + cell_size[0] / 4,
 				cell_center[1] - cell_size[1] / 4
 		}});
-	}
+	});
 }
 
 
@@ -240,18 +249,17 @@ double get_max_time_step(const Grid_T& grid)
 {
 	double ret_val = std::numeric_limits<double>::max();
 
-	for (size_t y_i = 0; y_i < grid.size(); y_i++)
-	for (size_t x_i = 0; x_i < grid[y_i].size(); x_i++) {
+	grid.for_each_cell([&](const Cell_T& cell, const Index_T& index) {
 
 		const auto
-			cell_size = get_cell_size(grid, {{x_i, y_i}}),
-			vel = grid[x_i][y_i][Velocity()];
+			cell_size = get_cell_size(grid, index),
+			vel = cell[Velocity()];
 
 		ret_val =
 			min(ret_val,
 			min(fabs(cell_size[0] / vel[0]),
 			    fabs(cell_size[1] / vel[1])));
-	}
+	});
 
 	return ret_val;
 }
@@ -264,10 +272,7 @@ Does not change the cell in which a particle is stored.
 */
 void solve(Grid_T& grid, const double dt)
 {
-	for (size_t y_i = 0; y_i < height; y_i++)
-	for (size_t x_i = 0; x_i < width; x_i++) {
-
-		auto& cell = grid[y_i][x_i];
+	grid.for_each_cell([&](Cell_T& cell, const Index_T&) {
 
 		for (auto& particle: cell[Particles()]) {
 
@@ -288,7 +293,7 @@ void solve(Grid_T& grid, const double dt)
 				}
 			}
 		}
-	}
+	});
 }
 
 
@@ -301,13 +306,11 @@ previous cell than one of the cell's nearest neighbors.
 */
 void apply_solution(Grid_T& grid)
 {
-	for (size_t y_i = 0; y_i < height; y_i++)
-	for (size_t x_i = 0; x_i < width; x_i++) {
+	grid.for_each_cell([&](Cell_T& cell, const Index_T& index) {
 
-		auto& cell = grid[y_i][x_i];
 		const auto
-			cell_center = get_cell_center(grid, {{x_i, y_i}}),
-			cell_size = get_cell_size(grid, {{x_i, y_i}});
+			cell_center = get_cell_center(grid, index),
+			cell_size = get_cell_size(grid, index);
 
 		// shorter notation for current coordinate list
 		vector<array<double, 2>>& coords = cell[Particles()];
@@ -330,26 +333,23 @@ void apply_solution(Grid_T& grid)
 			}
 
 			// assign the particle to the closest neighbor
-			size_t
-				closest_x = numeric_limits<size_t>::max(),
-				closest_y = numeric_limits<size_t>::max();
+			Index_T closest{{-1, -1}};
 			double closest_distance = numeric_limits<double>::max();
 
-			for (size_t y_offset: {size_t(1), size_t(0), height - 1})
-			for (size_t x_offset: {size_t(1), size_t(0), width - 1}) {
+			for (ptrdiff_t y_offset: {1, 0, -1})
+			for (ptrdiff_t x_offset: {1, 0, -1}) {
 
 				if (x_offset == 0 and y_offset == 0) {
 					continue;
 				}
 
-				const size_t
-					neighbor_x = (x_i + x_offset) % width,
-					neighbor_y = (y_i + y_offset) % height;
+				// only particles that move wrap around the grid
+				const Index_T neighbor_index{{
+					(index[0] + x_offset + ptrdiff_t(width)) % ptrdiff_t(width),
+					(index[1] + y_offset + ptrdiff_t(height)) % ptrdiff_t(height)
+				}};
 
-				const auto neighbor_center = get_cell_center(
-					grid,
-					{{neighbor_x, neighbor_y}}
-				);
+				const auto neighbor_center = get_cell_center(grid, neighbor_index);
 
 				const double distance
 					= sqrt(
@@ -359,15 +359,14 @@ void apply_solution(Grid_T& grid)
 
 				if (closest_distance > distance) {
 					closest_distance = distance;
-					closest_x = neighbor_x;
-					closest_y = neighbor_y;
+					closest = neighbor_index;
 				}
 			}
 
-			auto& neighbor = grid[closest_y][closest_x];
+			auto& neighbor = grid[closest];
 			neighbor[Particles()].push_back(coordinate);
 		}
-	}
+	});
 }
 
 
@@ -0,0 +1,177 @@
+/*
+Accumulates wall clock time spent in phases of the parallel examples.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PHASE_TIMER_HPP
+#define PHASE_TIMER_HPP
+
+#include "chrono"
+#include "ostream"
+#include "string"
+#include "utility"
+#include "vector"
+
+#include "mpi.h"
+
+namespace examples {
+
+/*!
+Records the total time spent in named phases of a simulation.
+
+Phases are reported in the order they were first started,
+for example by tests/parallel/scaling.cpp which parses the
+output of report().
+
+Example:
+@code
+examples::Phase_Timer timer;
+while (...) {
+	timer.start("solve");
+	solve(...);
+	timer.stop("solve");
+}
+timer.report(std::cout, comm);
+@endcode
+*/
+class Phase_Timer
+{
+public:
+
+	Phase_Timer() :
+		creation_time(std::chrono::steady_clock::now())
+	{}
+
+
+	//! Starts measuring the time of given phase.
+	void start(const std::string& phase)
+	{
+		this->get_phase(phase).start = std::chrono::steady_clock::now();
+	}
+
+
+	//! Adds time elapsed since start() of given phase to its total.
+	void stop(const std::string& phase)
+	{
+		auto& item = this->get_phase(phase);
+		item.total
+			+= std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - item.start
+			).count();
+	}
+
+
+	//! Returns the total time spent in given phase in seconds.
+	double get_time(const std::string& phase) const
+	{
+		for (const auto& item: this->phases) {
+			if (item.first == phase) {
+				return item.second.total;
+			}
+		}
+		return 0;
+	}
+
+
+	/*!
+	Writes the maximum time of each phase over all processes to given stream.
+
+	The total time since creating the timer is reported as phase total.
+	Output is written by process 0 on one line of the form:
+	phase_times <name> <seconds> <name> <seconds> ...
+
+	Must be called by all processes of given communicator
+	all of which must have recorded the same phases.
+	*/
+	void report(std::ostream& out, MPI_Comm comm) const
+	{
+		int rank = -1;
+		MPI_Comm_rank(comm, &rank);
+
+		std::vector<double> local_times, max_times(this->phases.size() + 1, 0);
+		for (const auto& item: this->phases) {
+			local_times.push_back(item.second.total);
+		}
+		local_times.push_back(
+			std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - this->creation_time
+			).count()
+		);
+
+		MPI_Reduce(
+			local_times.data(),
+			max_times.data(),
+			int(local_times.size()),
+			MPI_DOUBLE,
+			MPI_MAX,
+			0,
+			comm
+		);
+
+		if (rank != 0) {
+			return;
+		}
+
+		out << "phase_times";
+		for (size_t i = 0; i < this->phases.size(); i++) {
+			out << " " << this->phases[i].first << " " << max_times[i];
+		}
+		out << " total " << max_times.back() << std::endl;
+	}
+
+
+private:
+
+	struct Phase
+	{
+		std::chrono::steady_clock::time_point start;
+		double total = 0;
+	};
+
+	const std::chrono::steady_clock::time_point creation_time;
+	std::vector<std::pair<std::string, Phase>> phases;
+
+
+	Phase& get_phase(const std::string& phase)
+	{
+		for (auto& item: this->phases) {
+			if (item.first == phase) {
+				return item.second;
+			}
+		}
+		this->phases.emplace_back(phase, Phase());
+		return this->phases.back().second;
+	}
+};
+
+} // namespace
+
+#endif // ifndef PHASE_TIMER_HPP
@@ -0,0 +1,166 @@
+/*
+Allocator returning memory with given alignment.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef GENSIMCELL_ALIGNED_ALLOCATOR_HPP
+#define GENSIMCELL_ALIGNED_ALLOCATOR_HPP
+
+
+#include "cstddef"
+#include "cstdint"
+#include "limits"
+#include "new"
+#include "type_traits"
+
+
+namespace gensimcell {
+
+
+/*!
+Standard library compatible allocator of aligned memory.
+
+Memory returned by allocate() is aligned to at least
+Alignment bytes and at least alignof(T) bytes, which
+also applies to cells with variables that define a
+stricter alignment (see gensimcell::get_variable_alignment).
+Allows e.g. storing such cells in a std::vector:
+@code
+using Cell_T = gensimcell::Cell<...>;
+std::vector<Cell_T, gensimcell::Aligned_Allocator<Cell_T>> cells;
+@endcode
+or storing data of a vector variable aligned for SIMD loads:
+@code
+struct Density {
+	using data_type = std::vector<
+		double,
+		gensimcell::Aligned_Allocator<double, 32>
+	>;
+};
+@endcode
+*/
+template <
+	class T,
+	std::size_t Alignment = alignof(T)
+> class Aligned_Allocator
+{
+	static_assert(
+		Alignment > 0 and (Alignment & (Alignment - 1)) == 0,
+		"Alignment must be a power of 2"
+	);
+
+public:
+
+	using value_type = T;
+	using pointer = T*;
+	using const_pointer = const T*;
+	using reference = T&;
+	using const_reference = const T&;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+
+	//! Alignment of allocated memory in bytes.
+	static constexpr std::size_t alignment
+		= (Alignment > alignof(T)) ? Alignment : alignof(T);
+
+	template <class U> struct rebind {
+		using other = Aligned_Allocator<U, Alignment>;
+	};
+
+
+	Aligned_Allocator() = default;
+
+	template <class U> Aligned_Allocator(const Aligned_Allocator<U, Alignment>&) {}
+
+
+	/*!
+	Returns memory for given number of items.
+
+	Throws std::bad_alloc if memory couldn't be allocated.
+	*/
+	T* allocate(const std::size_t number_of_items)
+	{
+		if (number_of_items > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+			throw std::bad_alloc();
+		}
+
+		/*
+		Allocate extra space for aligning the returned
+		address and storing the original address before it
+		*/
+		const std::size_t bytes
+			= number_of_items * sizeof(T) + alignment + sizeof(void*);
+		if (bytes < number_of_items * sizeof(T)) {
+			throw std::bad_alloc();
+		}
+
+		void* const original = ::operator new(bytes);
+
+		const std::uintptr_t aligned
+			= (reinterpret_cast<std::uintptr_t>(original) + sizeof(void*) + alignment - 1)
+			& ~std::uintptr_t(alignment - 1);
+
+		reinterpret_cast<void**>(aligned)[-1] = original;
+
+		return reinterpret_cast<T*>(aligned);
+	}
+
+
+	//! Releases memory returned by allocate().
+	void deallocate(T* const items, const std::size_t)
+	{
+		if (items == nullptr) {
+			return;
+		}
+		::operator delete(reinterpret_cast<void**>(items)[-1]);
+	}
+
+
+	template <class U, std::size_t Other_Alignment> bool operator==(
+		const Aligned_Allocator<U, Other_Alignment>&
+	) const {
+		return Other_Alignment == Alignment;
+	}
+
+	template <class U, std::size_t Other_Alignment> bool operator!=(
+		const Aligned_Allocator<U, Other_Alignment>& other
+	) const {
+		return not (*this == other);
+	}
+};
+
+template <class T, std::size_t Alignment>
+constexpr std::size_t Aligned_Allocator<T, Alignment>::alignment;
+
+
+} // namespace gensimcell
+
+#endif // ifndef GENSIMCELL_ALIGNED_ALLOCATOR_HPP
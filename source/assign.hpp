@@ -34,6 +34,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define GENSIMCELL_ASSIGN_HPP
 
 
+#include "cold_storage.hpp"
 #include "type_support.hpp"
 
 #include "boost/mpl/contains.hpp"
@@ -87,8 +88,12 @@ template<
 	Cell<Transfer_Policy1, Variables1...>& target,
 	const Cell<Transfer_Policy2, Variables2...>& source
 ) {
-	using Var1_List = boost::mpl::vector<Variables1...>;
-	using Var2_List = boost::mpl::vector<Variables2...>;
+	using Var1_List = boost::mpl::vector<
+		typename detail::get_variable<Variables1>::type...
+	>;
+	using Var2_List = boost::mpl::vector<
+		typename detail::get_variable<Variables2>::type...
+	>;
 	using Common_Variables
 		= boost::mpl::filter_view<
 			Var1_List,
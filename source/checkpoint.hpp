@@ -0,0 +1,926 @@
+/*
+Checkpoint writer and reader for generic simulation cells.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+mpi.h must be included prior to including this file.
+
+File format, all values are stored in native byte order:
+- uint64_t 0x1234567890abcdef for detecting byte order
+- uint64_t version of the file format
+- uint64_t number of variables saved
+- for each saved variable:
+  - uint64_t length of variable name followed by the name
+  - uint64_t length of variable's data type name followed by the name
+  - uint64_t transfer state of variable when saved as given by
+    get_transfer_all() of the cells' type: 0 for false, 1 for true
+    and 2 if decided by each cell with set_transfer()
+- uint64_t total number of cells
+- for each cell for each saved variable: uint64_t number of bytes
+- for each cell for each saved variable: data of the variable
+*/
+
+#ifndef GENSIMCELL_CHECKPOINT_HPP
+#define GENSIMCELL_CHECKPOINT_HPP
+
+#if defined(MPI_VERSION) && (MPI_VERSION >= 2)
+
+#include "algorithm"
+#include "array"
+#include "cstdint"
+#include "cstring"
+#include "iterator"
+#include "limits"
+#include "string"
+#include "tuple"
+#include "vector"
+
+#include "get_var_mpi_datatype.hpp"
+#include "type_support.hpp"
+
+
+namespace gensimcell {
+namespace detail {
+
+
+constexpr uint64_t checkpoint_endianness = 0x1234567890abcdef;
+constexpr uint64_t checkpoint_version = 2;
+
+
+//! Transfer info of one variable of one cell in a checkpoint file.
+struct Checkpoint_Item
+{
+	uint64_t file_offset;
+	void* address;
+	int count;
+	MPI_Datatype datatype;
+};
+
+
+/*!
+Returns the number of bytes described by given transfer info.
+
+Returns std::numeric_limits<uint64_t>::max() in case of error.
+*/
+inline uint64_t get_number_of_bytes(
+	const int count,
+	const MPI_Datatype datatype
+) {
+	if (count < 0) {
+		return std::numeric_limits<uint64_t>::max();
+	}
+	if (count == 0) {
+		return 0;
+	}
+
+	int datatype_size = -1;
+	if (MPI_Type_size(datatype, &datatype_size) != MPI_SUCCESS) {
+		return std::numeric_limits<uint64_t>::max();
+	}
+
+	return uint64_t(count) * uint64_t(datatype_size);
+}
+
+
+/*!
+Appends the name, type name and transfer state
+of given variable in given cell type to given header.
+*/
+template<class Cell_T, class Variable> void append_checkpoint_header(
+	std::vector<char>& header
+) {
+	for (const auto& name: {
+		get_variable_name<Variable>(),
+		get_variable_name<typename Variable::data_type>()
+	}) {
+		const uint64_t length = name.size();
+		const char* const length_begin
+			= reinterpret_cast<const char*>(&length);
+
+		header.insert(header.end(), length_begin, length_begin + sizeof(length));
+		header.insert(header.end(), name.cbegin(), name.cend());
+	}
+
+	const auto transfer_all = Cell_T::get_transfer_all(Variable());
+	uint64_t transfer = 2;
+	if (transfer_all) {
+		transfer = 1;
+	} else if (not transfer_all) {
+		transfer = 0;
+	}
+	const char* const transfer_begin
+		= reinterpret_cast<const char*>(&transfer);
+	header.insert(header.end(), transfer_begin, transfer_begin + sizeof(transfer));
+}
+
+
+/*!
+Prepares given variable's data for reading given number of bytes into it.
+
+Version for fixed size data which can't be resized,
+whether the sizes match is checked by the caller.
+*/
+template<class Data_T> bool resize_for_checkpoint(Data_T&, const uint64_t)
+{
+	return true;
+}
+
+/*!
+Version for vectors of fixed size items.
+
+Returns false if given number of bytes isn't
+a multiple of the size of one item.
+*/
+template<class Item_T, class Allocator> bool resize_for_checkpoint(
+	std::vector<Item_T, Allocator>& data,
+	const uint64_t number_of_bytes
+) {
+	if (number_of_bytes == 0) {
+		data.clear();
+		return true;
+	}
+
+	const Item_T item{};
+	void* address = nullptr;
+	int count = -1;
+	MPI_Datatype datatype = MPI_DATATYPE_NULL;
+	std::tie(address, count, datatype) = get_var_mpi_datatype(item);
+
+	const uint64_t item_size = get_number_of_bytes(count, datatype);
+	free_derived_datatype(datatype);
+
+	if (
+		item_size == 0
+		or item_size == std::numeric_limits<uint64_t>::max()
+		or number_of_bytes % item_size != 0
+	) {
+		return false;
+	}
+
+	data.resize(number_of_bytes / item_size);
+	return true;
+}
+
+
+/*!
+Creates a datatype with absolute addresses of given items for use with MPI_BOTTOM.
+
+Returns MPI_DATATYPE_NULL in case of error.
+*/
+inline MPI_Datatype get_checkpoint_memory_datatype(
+	const std::vector<Checkpoint_Item>& items
+) {
+	if (items.size() > size_t(std::numeric_limits<int>::max())) {
+		return MPI_DATATYPE_NULL;
+	}
+
+	std::vector<int> counts;
+	std::vector<MPI_Aint> displacements;
+	std::vector<MPI_Datatype> datatypes;
+	counts.reserve(items.size());
+	displacements.reserve(items.size());
+	datatypes.reserve(items.size());
+
+	for (const auto& item: items) {
+		MPI_Aint displacement = 0;
+		if (MPI_Get_address(item.address, &displacement) != MPI_SUCCESS) {
+			return MPI_DATATYPE_NULL;
+		}
+		counts.push_back(item.count);
+		displacements.push_back(displacement);
+		datatypes.push_back(item.datatype);
+	}
+
+	MPI_Datatype final_datatype = MPI_DATATYPE_NULL;
+	if (
+		MPI_Type_create_struct(
+			int(items.size()),
+			counts.data(),
+			displacements.data(),
+			datatypes.data(),
+			&final_datatype
+		) != MPI_SUCCESS
+	) {
+		return MPI_DATATYPE_NULL;
+	}
+
+	if (MPI_Type_commit(&final_datatype) != MPI_SUCCESS) {
+		MPI_Type_free(&final_datatype);
+		return MPI_DATATYPE_NULL;
+	}
+
+	return final_datatype;
+}
+
+
+//! Frees datatypes of given items.
+inline void free_checkpoint_items(std::vector<Checkpoint_Item>& items)
+{
+	for (auto& item: items) {
+		free_derived_datatype(item.datatype);
+	}
+	items.clear();
+}
+
+
+//! Stops the iteration over variables to be saved.
+template<class Cell_T> bool get_checkpoint_items(
+	const Cell_T&,
+	std::vector<Checkpoint_Item>&,
+	std::vector<uint64_t>&
+) {
+	return true;
+}
+
+/*!
+Appends transfer info and number of bytes of given
+variables in given cell to given containers.
+*/
+template<
+	class Cell_T,
+	class First_Variable,
+	class... Rest_Of_Variables
+> bool get_checkpoint_items(
+	const Cell_T& cell,
+	std::vector<Checkpoint_Item>& items,
+	std::vector<uint64_t>& sizes,
+	const First_Variable& first_variable,
+	const Rest_Of_Variables&... rest_of_variables
+) {
+	Checkpoint_Item item{0, nullptr, -1, MPI_DATATYPE_NULL};
+	std::tie(
+		item.address,
+		item.count,
+		item.datatype
+	) = get_var_mpi_datatype(cell[first_variable]);
+
+	const uint64_t number_of_bytes
+		= get_number_of_bytes(item.count, item.datatype);
+	if (number_of_bytes == std::numeric_limits<uint64_t>::max()) {
+		free_derived_datatype(item.datatype);
+		return false;
+	}
+
+	sizes.push_back(number_of_bytes);
+	if (number_of_bytes > 0) {
+		items.push_back(item);
+	} else {
+		free_derived_datatype(item.datatype);
+	}
+
+	return get_checkpoint_items(cell, items, sizes, rest_of_variables...);
+}
+
+
+//! Stops the iteration over variables to be loaded.
+template<class Cell_T> bool get_checkpoint_items(
+	Cell_T&,
+	const std::vector<size_t>::const_iterator,
+	const std::vector<uint64_t>::const_iterator,
+	const std::vector<uint64_t>::const_iterator,
+	std::vector<Checkpoint_Item>&
+) {
+	return true;
+}
+
+/*!
+Appends transfer info and file offset of
+given variables in given cell to given items.
+
+Given file indices are the indices of given variables
+in the file, sizes and offsets are the number of bytes
+of every variable of the cell and their offsets in the file.
+*/
+template<
+	class Cell_T,
+	class First_Variable,
+	class... Rest_Of_Variables
+> bool get_checkpoint_items(
+	Cell_T& cell,
+	const std::vector<size_t>::const_iterator file_index,
+	const std::vector<uint64_t>::const_iterator sizes,
+	const std::vector<uint64_t>::const_iterator offsets,
+	std::vector<Checkpoint_Item>& items,
+	const First_Variable& first_variable,
+	const Rest_Of_Variables&... rest_of_variables
+) {
+	const uint64_t number_of_bytes = *(sizes + *file_index);
+
+	if (not resize_for_checkpoint(cell[first_variable], number_of_bytes)) {
+		return false;
+	}
+
+	Checkpoint_Item item{
+		*(offsets + *file_index),
+		nullptr,
+		-1,
+		MPI_DATATYPE_NULL
+	};
+	std::tie(
+		item.address,
+		item.count,
+		item.datatype
+	) = get_var_mpi_datatype(cell[first_variable]);
+
+	if (get_number_of_bytes(item.count, item.datatype) != number_of_bytes) {
+		free_derived_datatype(item.datatype);
+		return false;
+	}
+
+	if (number_of_bytes > 0) {
+		items.push_back(item);
+	} else {
+		free_derived_datatype(item.datatype);
+	}
+
+	return get_checkpoint_items(
+		cell,
+		file_index + 1,
+		sizes,
+		offsets,
+		items,
+		rest_of_variables...
+	);
+}
+
+
+/*!
+Reads one string of the checkpoint header at given offset.
+
+Increases offset by the number of bytes read.
+*/
+inline bool read_checkpoint_string(
+	MPI_File file,
+	MPI_Offset& offset,
+	std::string& result
+) {
+	uint64_t length = 0;
+	if (
+		MPI_File_read_at(
+			file,
+			offset,
+			&length,
+			1,
+			MPI_UINT64_T,
+			MPI_STATUS_IGNORE
+		) != MPI_SUCCESS
+	) {
+		return false;
+	}
+	offset += sizeof(uint64_t);
+
+	if (length > uint64_t(std::numeric_limits<int>::max())) {
+		return false;
+	}
+
+	std::vector<char> buffer(length);
+	if (
+		length > 0
+		and MPI_File_read_at(
+			file,
+			offset,
+			buffer.data(),
+			int(length),
+			MPI_CHAR,
+			MPI_STATUS_IGNORE
+		) != MPI_SUCCESS
+	) {
+		return false;
+	}
+	offset += length;
+
+	result.assign(buffer.cbegin(), buffer.cend());
+	return true;
+}
+
+
+} // namespace detail
+
+
+
+/*!
+Saves data of given variables of given cells into a checkpoint file.
+
+Cells between begin and end are written in the order given,
+processes of given communicator write their cells in the order of
+their ranks. Data of each variable is written regardless of the
+transfer policy of the cells, therefore also cells that never
+transfer variables (e.g. serial programs using MPI_COMM_SELF) can be
+saved. Data of variables must be supported by get_var_mpi_datatype().
+
+The file starts with a header describing the names, types and
+transfer state of saved variables and the number of bytes of each
+variable in every cell, after which the cells' data are written using collective MPI-IO.
+See the beginning of this file for details.
+
+Must be called by all processes of given communicator.
+Returns true on success and false otherwise.
+
+Example:
+@code
+std::vector<Cell> cells(...);
+gensimcell::save_checkpoint(
+	"restart.gc", MPI_COMM_WORLD,
+	cells.cbegin(), cells.cend(),
+	Density(), Velocity()
+);
+@endcode
+*/
+template<
+	class Cell_Iterator,
+	class... Variables
+> bool save_checkpoint(
+	const std::string& file_name,
+	MPI_Comm comm,
+	const Cell_Iterator begin,
+	const Cell_Iterator end,
+	const Variables&... variables
+) {
+	constexpr size_t number_of_variables = sizeof...(Variables);
+	static_assert(number_of_variables > 0, "At least one variable must be saved");
+
+	int rank = -1;
+	MPI_Comm_rank(comm, &rank);
+
+	// local transfer info and number of bytes of each variable in each cell
+	std::vector<detail::Checkpoint_Item> items;
+	std::vector<uint64_t> sizes;
+
+	bool success = true;
+	uint64_t local_cells = 0, local_bytes = 0;
+	for (auto cell = begin; cell != end; cell++) {
+		local_cells++;
+		if (not detail::get_checkpoint_items(*cell, items, sizes, variables...)) {
+			success = false;
+			break;
+		}
+	}
+	for (const auto size: sizes) {
+		local_bytes += size;
+	}
+
+	int local_success = (success ? 1 : 0), global_success = 0;
+	MPI_Allreduce(&local_success, &global_success, 1, MPI_INT, MPI_MIN, comm);
+	if (global_success == 0) {
+		detail::free_checkpoint_items(items);
+		return false;
+	}
+
+	// location of this process' data in the file
+	uint64_t
+		first_cell = 0,
+		first_byte = 0,
+		total_cells = 0;
+	MPI_Exscan(&local_cells, &first_cell, 1, MPI_UINT64_T, MPI_SUM, comm);
+	MPI_Exscan(&local_bytes, &first_byte, 1, MPI_UINT64_T, MPI_SUM, comm);
+	MPI_Allreduce(&local_cells, &total_cells, 1, MPI_UINT64_T, MPI_SUM, comm);
+	if (rank == 0) {
+		first_cell = first_byte = 0;
+	}
+
+	std::vector<char> header;
+	for (const uint64_t value: {
+		detail::checkpoint_endianness,
+		detail::checkpoint_version,
+		uint64_t(number_of_variables)
+	}) {
+		const char* const begin_value = reinterpret_cast<const char*>(&value);
+		header.insert(header.end(), begin_value, begin_value + sizeof(value));
+	}
+	using Cell_T = typename std::iterator_traits<Cell_Iterator>::value_type;
+	const std::array<int, number_of_variables> header_appends{{
+		(detail::append_checkpoint_header<Cell_T, Variables>(header), 0)...
+	}};
+	(void) header_appends;
+	const char* const begin_total = reinterpret_cast<const char*>(&total_cells);
+	header.insert(header.end(), begin_total, begin_total + sizeof(total_cells));
+
+	const MPI_Offset
+		sizes_start = MPI_Offset(header.size()),
+		data_start
+			= sizes_start
+			+ MPI_Offset(total_cells * number_of_variables * sizeof(uint64_t));
+
+	MPI_Datatype memory_datatype = detail::get_checkpoint_memory_datatype(items);
+	local_success = (memory_datatype == MPI_DATATYPE_NULL ? 0 : 1);
+	MPI_Allreduce(&local_success, &global_success, 1, MPI_INT, MPI_MIN, comm);
+	if (global_success == 0) {
+		if (memory_datatype != MPI_DATATYPE_NULL) {
+			MPI_Type_free(&memory_datatype);
+		}
+		detail::free_checkpoint_items(items);
+		return false;
+	}
+
+	MPI_File file;
+	if (
+		MPI_File_open(
+			comm,
+			const_cast<char*>(file_name.c_str()),
+			MPI_MODE_CREATE | MPI_MODE_WRONLY,
+			MPI_INFO_NULL,
+			&file
+		) != MPI_SUCCESS
+	) {
+		MPI_Type_free(&memory_datatype);
+		detail::free_checkpoint_items(items);
+		return false;
+	}
+
+	// discard possible previous contents
+	success = (MPI_File_set_size(file, 0) == MPI_SUCCESS);
+
+	if (
+		rank == 0
+		and MPI_File_write_at(
+			file,
+			0,
+			header.data(),
+			int(header.size()),
+			MPI_BYTE,
+			MPI_STATUS_IGNORE
+		) != MPI_SUCCESS
+	) {
+		success = false;
+	}
+
+	if (
+		MPI_File_write_at_all(
+			file,
+			sizes_start + MPI_Offset(first_cell * number_of_variables * sizeof(uint64_t)),
+			sizes.data(),
+			int(sizes.size()),
+			MPI_UINT64_T,
+			MPI_STATUS_IGNORE
+		) != MPI_SUCCESS
+	) {
+		success = false;
+	}
+
+	if (
+		MPI_File_write_at_all(
+			file,
+			data_start + MPI_Offset(first_byte),
+			MPI_BOTTOM,
+			(items.size() > 0 ? 1 : 0),
+			memory_datatype,
+			MPI_STATUS_IGNORE
+		) != MPI_SUCCESS
+	) {
+		success = false;
+	}
+
+	MPI_File_close(&file);
+	MPI_Type_free(&memory_datatype);
+	detail::free_checkpoint_items(items);
+
+	local_success = (success ? 1 : 0);
+	MPI_Allreduce(&local_success, &global_success, 1, MPI_INT, MPI_MIN, comm);
+	return global_success > 0;
+}
+
+
+
+/*!
+Loads data of given variables of given cells from a checkpoint file.
+
+Given variables can be any subset of the variables saved
+by save_checkpoint(), other variables of given cells are
+not modified. The total number of cells given by all processes
+must equal the number of cells in the file, cells are assigned
+to processes in the order of their ranks but the number of cells
+on each process can differ from when the file was saved.
+Vectors of fixed size items are resized to hold the data saved
+in the file, all other data must have the same size as when saved.
+Fails if the data type of a given variable differs from the one
+saved in the file. The transfer state of variables in the file is
+informative only, transfer policies of given cells are not modified.
+
+Must be called by all processes of given communicator.
+Returns true on success and false otherwise.
+*/
+template<
+	class Cell_Iterator,
+	class... Variables
+> bool load_checkpoint(
+	const std::string& file_name,
+	MPI_Comm comm,
+	const Cell_Iterator begin,
+	const Cell_Iterator end,
+	const Variables&... variables
+) {
+	constexpr size_t number_of_variables = sizeof...(Variables);
+	static_assert(number_of_variables > 0, "At least one variable must be loaded");
+
+	int rank = -1;
+	MPI_Comm_rank(comm, &rank);
+
+	MPI_File file;
+	if (
+		MPI_File_open(
+			comm,
+			const_cast<char*>(file_name.c_str()),
+			MPI_MODE_RDONLY,
+			MPI_INFO_NULL,
+			&file
+		) != MPI_SUCCESS
+	) {
+		return false;
+	}
+
+	/*
+	Read header
+	*/
+	bool success = true;
+	MPI_Offset offset = 0;
+	std::array<uint64_t, 3> start{{0, 0, 0}};
+	if (
+		MPI_File_read_at(
+			file,
+			offset,
+			start.data(),
+			int(start.size()),
+			MPI_UINT64_T,
+			MPI_STATUS_IGNORE
+		) != MPI_SUCCESS
+		or start[0] != detail::checkpoint_endianness
+		or start[1] != detail::checkpoint_version
+	) {
+		success = false;
+	}
+	offset += MPI_Offset(start.size() * sizeof(uint64_t));
+	const uint64_t variables_in_file = start[2];
+
+	std::vector<std::string> names_in_file, type_names_in_file;
+	for (uint64_t i = 0; success and i < variables_in_file; i++) {
+		std::string name, type_name;
+		uint64_t transfer = 0;
+		if (
+			not detail::read_checkpoint_string(file, offset, name)
+			or not detail::read_checkpoint_string(file, offset, type_name)
+			or MPI_File_read_at(
+				file,
+				offset,
+				&transfer,
+				1,
+				MPI_UINT64_T,
+				MPI_STATUS_IGNORE
+			) != MPI_SUCCESS
+			or transfer > 2
+		) {
+			success = false;
+		}
+		offset += MPI_Offset(sizeof(uint64_t));
+		names_in_file.push_back(name);
+		type_names_in_file.push_back(type_name);
+	}
+
+	uint64_t total_cells = 0;
+	if (
+		success
+		and MPI_File_read_at(
+			file,
+			offset,
+			&total_cells,
+			1,
+			MPI_UINT64_T,
+			MPI_STATUS_IGNORE
+		) != MPI_SUCCESS
+	) {
+		success = false;
+	}
+	offset += MPI_Offset(sizeof(uint64_t));
+
+	// index of each given variable in the file
+	const std::array<std::string, number_of_variables>
+		names{{get_variable_name<Variables>()...}},
+		type_names{{get_variable_name<typename Variables::data_type>()...}};
+	std::vector<size_t> file_indices;
+	for (size_t i = 0; success and i < names.size(); i++) {
+		const auto found
+			= std::find(names_in_file.cbegin(), names_in_file.cend(), names[i]);
+		if (found == names_in_file.cend()) {
+			success = false;
+			break;
+		}
+
+		const size_t file_index = size_t(found - names_in_file.cbegin());
+		if (type_names_in_file[file_index] != type_names[i]) {
+			success = false;
+			break;
+		}
+		file_indices.push_back(file_index);
+	}
+
+	uint64_t local_cells = uint64_t(std::distance(begin, end)), all_cells = 0;
+	MPI_Allreduce(&local_cells, &all_cells, 1, MPI_UINT64_T, MPI_SUM, comm);
+	if (all_cells != total_cells) {
+		success = false;
+	}
+
+	int local_success = (success ? 1 : 0), global_success = 0;
+	MPI_Allreduce(&local_success, &global_success, 1, MPI_INT, MPI_MIN, comm);
+	if (global_success == 0) {
+		MPI_File_close(&file);
+		return false;
+	}
+
+	/*
+	Read number of bytes of all variables in local cells
+	*/
+	uint64_t first_cell = 0;
+	MPI_Exscan(&local_cells, &first_cell, 1, MPI_UINT64_T, MPI_SUM, comm);
+	if (rank == 0) {
+		first_cell = 0;
+	}
+
+	const MPI_Offset
+		sizes_start = offset,
+		data_start
+			= sizes_start
+			+ MPI_Offset(total_cells * variables_in_file * sizeof(uint64_t));
+
+	std::vector<uint64_t> sizes(local_cells * variables_in_file, 0);
+	if (
+		MPI_File_read_at_all(
+			file,
+			sizes_start + MPI_Offset(first_cell * variables_in_file * sizeof(uint64_t)),
+			sizes.data(),
+			int(sizes.size()),
+			MPI_UINT64_T,
+			MPI_STATUS_IGNORE
+		) != MPI_SUCCESS
+	) {
+		success = false;
+	}
+
+	uint64_t local_bytes = 0, first_byte = 0;
+	for (const auto size: sizes) {
+		local_bytes += size;
+	}
+	MPI_Exscan(&local_bytes, &first_byte, 1, MPI_UINT64_T, MPI_SUM, comm);
+	if (rank == 0) {
+		first_byte = 0;
+	}
+
+	/*
+	Prepare cells for reading and get their transfer info
+	*/
+	std::vector<detail::Checkpoint_Item> items;
+	std::vector<uint64_t> offsets(variables_in_file, 0);
+	uint64_t cell_offset = uint64_t(data_start) + first_byte;
+	size_t cell_index = 0;
+	for (auto cell = begin; success and cell != end; cell++, cell_index++) {
+		const auto cell_sizes
+			= sizes.cbegin() + cell_index * variables_in_file;
+
+		for (size_t i = 0; i < variables_in_file; i++) {
+			offsets[i] = cell_offset;
+			cell_offset += *(cell_sizes + i);
+		}
+
+		const size_t first_item = items.size();
+		if (
+			not detail::get_checkpoint_items(
+				*cell,
+				file_indices.cbegin(),
+				cell_sizes,
+				offsets.cbegin(),
+				items,
+				variables...
+			)
+		) {
+			success = false;
+		}
+
+		// file view requires increasing offsets
+		std::sort(
+			items.begin() + first_item,
+			items.end(),
+			[](
+				const detail::Checkpoint_Item& a,
+				const detail::Checkpoint_Item& b
+			) {
+				return a.file_offset < b.file_offset;
+			}
+		);
+	}
+
+	MPI_Datatype
+		memory_datatype = MPI_DATATYPE_NULL,
+		file_datatype = MPI_DATATYPE_NULL;
+
+	if (success and items.size() > 0) {
+		memory_datatype = detail::get_checkpoint_memory_datatype(items);
+
+		std::vector<int> block_lengths;
+		std::vector<MPI_Aint> displacements;
+		for (const auto& item: items) {
+			const uint64_t number_of_bytes
+				= detail::get_number_of_bytes(item.count, item.datatype);
+			if (number_of_bytes > uint64_t(std::numeric_limits<int>::max())) {
+				success = false;
+			}
+			block_lengths.push_back(int(number_of_bytes));
+			displacements.push_back(MPI_Aint(item.file_offset - items[0].file_offset));
+		}
+
+		if (
+			MPI_Type_create_hindexed(
+				int(items.size()),
+				block_lengths.data(),
+				displacements.data(),
+				MPI_BYTE,
+				&file_datatype
+			) != MPI_SUCCESS
+			or MPI_Type_commit(&file_datatype) != MPI_SUCCESS
+		) {
+			file_datatype = MPI_DATATYPE_NULL;
+		}
+
+		if (
+			memory_datatype == MPI_DATATYPE_NULL
+			or file_datatype == MPI_DATATYPE_NULL
+		) {
+			success = false;
+		}
+	}
+
+	local_success = (success ? 1 : 0);
+	MPI_Allreduce(&local_success, &global_success, 1, MPI_INT, MPI_MIN, comm);
+
+	if (global_success > 0) {
+		const bool have_items = (items.size() > 0);
+		if (
+			MPI_File_set_view(
+				file,
+				(have_items ? MPI_Offset(items[0].file_offset) : 0),
+				MPI_BYTE,
+				(have_items ? file_datatype : MPI_BYTE),
+				const_cast<char*>("native"),
+				MPI_INFO_NULL
+			) != MPI_SUCCESS
+			or MPI_File_read_at_all(
+				file,
+				0,
+				MPI_BOTTOM,
+				(have_items ? 1 : 0),
+				(have_items ? memory_datatype : MPI_BYTE),
+				MPI_STATUS_IGNORE
+			) != MPI_SUCCESS
+		) {
+			success = false;
+		}
+	}
+
+	MPI_File_close(&file);
+	if (memory_datatype != MPI_DATATYPE_NULL) {
+		MPI_Type_free(&memory_datatype);
+	}
+	if (file_datatype != MPI_DATATYPE_NULL) {
+		MPI_Type_free(&file_datatype);
+	}
+	detail::free_checkpoint_items(items);
+
+	if (global_success == 0) {
+		return false;
+	}
+
+	local_success = (success ? 1 : 0);
+	MPI_Allreduce(&local_success, &global_success, 1, MPI_INT, MPI_MIN, comm);
+	return global_success > 0;
+}
+
+
+} // namespace gensimcell
+
+#endif // ifdef MPI_VERSION
+
+#endif // ifndef GENSIMCELL_CHECKPOINT_HPP
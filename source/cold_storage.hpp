@@ -0,0 +1,238 @@
+/*
+Storage of rarely used variables outside of generic simulation cells.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef GENSIMCELL_COLD_STORAGE_HPP
+#define GENSIMCELL_COLD_STORAGE_HPP
+
+
+#include "cstddef"
+#include "new"
+#include "utility"
+
+#include "aligned_allocator.hpp"
+#include "type_support.hpp"
+
+
+namespace gensimcell {
+
+
+/*!
+Marks given variable as cold in a generic simulation cell.
+
+Data of cold variables is stored in a separate allocation
+and the cell only stores a pointer to it, so that cells
+with small frequently used (hot) variables and large rarely
+used variables stay compact, and a loop over a container of
+such cells only loads the hot variables and pointers:
+@code
+using Cell = gensimcell::Cell<
+	gensimcell::Optional_Transfer,
+	Density,
+	gensimcell::Cold<Particles>
+>;
+@endcode
+Cold variables are accessed with the original variable
+as usual, e.g. cell[Particles()], and their data is copied
+when the cell is copied and moved without copying when the
+cell is moved. Transfers of cold variables are
+also switched on and off with the original variable.
+*/
+template <class Variable> struct Cold : public Variable {};
+
+
+namespace detail {
+
+//! Returns the variable with which data of given variable is accessed.
+template <class Variable> struct get_variable {
+	using type = Variable;
+};
+
+template <class Variable> struct get_variable<Cold<Variable>> {
+	using type = Variable;
+};
+
+
+/*!
+Owns one heap allocated instance of Data_T.
+
+Copying copies the data, moving transfers ownership of
+it. A moved-from instance owns no data until accessed
+through get() which then allocates its own default data,
+also when const, so that e.g. MPI can receive data into
+a moved-from instance.
+*/
+template <
+	class Data_T,
+	std::size_t Alignment
+> class Cold_Storage
+{
+public:
+
+	Cold_Storage() :
+		data(allocate())
+	{}
+
+	Cold_Storage(const Cold_Storage& other) :
+		data(allocate(other.get()))
+	{}
+
+	Cold_Storage(Cold_Storage&& other) noexcept :
+		data(other.data)
+	{
+		other.data = nullptr;
+	}
+
+	Cold_Storage& operator=(const Cold_Storage& other)
+	{
+		if (this->data == nullptr) {
+			this->data = allocate(other.get());
+		} else {
+			*this->data = other.get();
+		}
+		return *this;
+	}
+
+	Cold_Storage& operator=(Cold_Storage&& other) noexcept
+	{
+		this->swap(other);
+		return *this;
+	}
+
+	~Cold_Storage()
+	{
+		if (this->data == nullptr) {
+			return;
+		}
+		this->data->~Data_T();
+		Allocator().deallocate(this->data, 1);
+	}
+
+	void swap(Cold_Storage& other) noexcept
+	{
+		Data_T* const temp = this->data;
+		this->data = other.data;
+		other.data = temp;
+	}
+
+	Data_T& get()
+	{
+		if (this->data == nullptr) {
+			this->data = allocate();
+		}
+		return *this->data;
+	}
+
+	const Data_T& get() const
+	{
+		if (this->data == nullptr) {
+			this->data = allocate();
+		}
+		return *this->data;
+	}
+
+
+private:
+
+	using Allocator = Aligned_Allocator<Data_T, Alignment>;
+
+	//! Allocated on access after being moved from
+	mutable Data_T* data;
+
+	//! Returns new data constructed from given arguments.
+	template <class... Arguments> static Data_T* allocate(
+		Arguments&&... arguments
+	) {
+		Data_T* const new_data = Allocator().allocate(1);
+		try {
+			new (new_data) Data_T(std::forward<Arguments>(arguments)...);
+		} catch (...) {
+			Allocator().deallocate(new_data, 1);
+			throw;
+		}
+		return new_data;
+	}
+};
+
+
+template <
+	class Data_T,
+	std::size_t Alignment
+> void swap(
+	Cold_Storage<Data_T, Alignment>& a,
+	Cold_Storage<Data_T, Alignment>& b
+) noexcept {
+	a.swap(b);
+}
+
+
+/*!
+Type and alignment of the member storing given variable's data in cells.
+*/
+template <class Variable> struct get_storage {
+	using type = typename Variable::data_type;
+	static constexpr std::size_t alignment = get_variable_alignment<Variable>::value;
+};
+
+template <class Variable> struct get_storage<Cold<Variable>> {
+	using type = Cold_Storage<
+		typename Variable::data_type,
+		get_variable_alignment<Variable>::value
+	>;
+	static constexpr std::size_t alignment = alignof(type);
+};
+
+
+//! Returns the data of a variable stored in a cell.
+template <class Data_T> Data_T& get_data(Data_T& data)
+{
+	return data;
+}
+
+template <class Data_T, std::size_t Alignment> Data_T& get_data(
+	Cold_Storage<Data_T, Alignment>& data
+) {
+	return data.get();
+}
+
+template <class Data_T, std::size_t Alignment> const Data_T& get_data(
+	const Cold_Storage<Data_T, Alignment>& data
+) {
+	return data.get();
+}
+
+} // namespace detail
+
+
+} // namespace gensimcell
+
+#endif // ifndef GENSIMCELL_COLD_STORAGE_HPP
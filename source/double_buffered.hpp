@@ -0,0 +1,148 @@
+/*
+Variable data with current and next buffers.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef GENSIMCELL_DOUBLE_BUFFERED_HPP
+#define GENSIMCELL_DOUBLE_BUFFERED_HPP
+
+
+#include "array"
+#include "cstddef"
+
+#if defined(MPI_VERSION) && (MPI_VERSION >= 2)
+#include "tuple"
+
+#include "get_var_mpi_datatype.hpp"
+#endif
+
+
+namespace gensimcell {
+
+
+/*!
+Stores two instances of Data_T, the current one and the next one.
+
+Allows a solver to compute the next state of a variable from
+the current state of neighboring cells and write it directly
+into each cell without a separate pass over the grid that copies
+the result and clears temporary variables. Which one of the
+buffers is current is shared by all instances with the same
+Tag so starting the next step with swap() is O(1) regardless
+of the number of cells:
+@code
+struct Is_Alive {
+	using data_type = gensimcell::Double_Buffered<bool, Is_Alive>;
+};
+...
+for (auto& cell: cells) {
+	cell[Is_Alive()].next() = f(neighbors' cell[Is_Alive()].current());
+}
+Is_Alive::data_type::swap();
+@endcode
+Only the current buffer is transferred between processes
+by get_mpi_datatype(), so in a cell that transfers such a
+variable swap() must be called at the same step on all
+processes. Not thread safe, swap() must not be called while
+other threads access the buffers.
+*/
+template <
+	class Data_T,
+	class Tag = void
+> class Double_Buffered
+{
+public:
+
+	using value_type = Data_T;
+
+
+	Data_T& current()
+	{
+		return this->buffers[current_index];
+	}
+
+	const Data_T& current() const
+	{
+		return this->buffers[current_index];
+	}
+
+	Data_T& next()
+	{
+		return this->buffers[1 - current_index];
+	}
+
+	const Data_T& next() const
+	{
+		return this->buffers[1 - current_index];
+	}
+
+
+	/*!
+	Makes next buffers current and current buffers next
+	in all instances with the same template arguments.
+	*/
+	static void swap()
+	{
+		current_index = 1 - current_index;
+	}
+
+	//! Returns 0 or 1, the index of the current buffer.
+	static std::size_t get_current_index()
+	{
+		return current_index;
+	}
+
+
+	#if defined(MPI_VERSION) && (MPI_VERSION >= 2)
+
+	//! Returns the MPI transfer info of the current buffer.
+	std::tuple<void*, int, MPI_Datatype> get_mpi_datatype() const
+	{
+		return detail::get_var_mpi_datatype(this->current());
+	}
+
+	#endif
+
+
+private:
+
+	std::array<Data_T, 2> buffers;
+
+	static std::size_t current_index;
+};
+
+template <class Data_T, class Tag>
+std::size_t Double_Buffered<Data_T, Tag>::current_index = 0;
+
+
+} // namespace gensimcell
+
+#endif // ifndef GENSIMCELL_DOUBLE_BUFFERED_HPP
@@ -34,10 +34,16 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define GENSIMCELL_HPP
 
 
+#include "cstddef"
 #include "tuple"
+#include "type_traits"
 
+#include "aligned_allocator.hpp"
 #include "assign.hpp"
+#include "double_buffered.hpp"
 #include "operators.hpp"
+#include "pool_allocator.hpp"
+#include "reflection.hpp"
 #include "type_support.hpp"
 #include "gensimcell_impl.hpp"
 #include "gensimcell_transfer_policy.hpp"
@@ -166,6 +172,78 @@ public:
 	>;
 
 
+	//! Number of variables in this cell type.
+	static constexpr std::size_t variable_count = sizeof...(Variables);
+
+	/*!
+	Returns the index of given variable in this cell type's variables.
+
+	The first variable has index 0. Cold variables are given
+	without gensimcell::Cold. For example:
+	@code
+	using Cell_T = gensimcell::Cell<Never_Transfer, Is_Alive, Live_Neighbors>;
+	static_assert(Cell_T::index_of<Live_Neighbors>() == 1, "");
+	@endcode
+	*/
+	template<class Variable> static constexpr std::size_t index_of()
+	{
+		return detail::index_of<
+			Variable,
+			typename detail::get_variable<Variables>::type...
+		>::value;
+	}
+
+	/*!
+	Variable at given index in this cell type's variables.
+
+	For example Cell_T::variable_at<1> is Live_Neighbors.
+	*/
+	template<std::size_t Index> using variable_at
+		= typename detail::variable_at<
+			Index,
+			typename detail::get_variable<Variables>::type...
+		>::type;
+
+	//! Returns the size of given variable's data in bytes.
+	template<class Variable> static constexpr std::size_t size_of()
+	{
+		return sizeof(typename Variable::data_type);
+	}
+
+	/*!
+	Returns the offset of given variable's data in cells of this type.
+
+	The offset is in bytes from the address of a cell and is
+	the same for all cells of this type. Isn't constexpr because
+	cells aren't standard layout types so the offset is measured
+	from a default constructed cell on the first call.
+	Cold variables aren't supported as their data isn't stored
+	inside of cells.
+	*/
+	template<class Variable> static std::size_t offset_of()
+	{
+		static_assert(
+			std::is_same<
+				Variable,
+				typename detail::variable_at<
+					index_of<Variable>(),
+					Variables...
+				>::type
+			>::value,
+			"Data of cold variables isn't stored in cells"
+		);
+
+		static const std::size_t offset = [](){
+			Cell cell;
+			return std::size_t(
+				reinterpret_cast<const char*>(&cell[Variable()])
+				- reinterpret_cast<const char*>(&cell)
+			);
+		}();
+		return offset;
+	}
+
+
 	/*!
 	*/
 	template<class Other> void assign(const Other& other)
@@ -200,6 +278,11 @@ public:
 	#endif // ifdef MPI_VERSION
 };
 
+template <
+	template<class> class Transfer_Policy,
+	class... Variables
+> constexpr std::size_t Cell<Transfer_Policy, Variables...>::variable_count;
+
 
 namespace detail {
 
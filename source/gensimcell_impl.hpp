@@ -41,6 +41,8 @@ Author(s): Ilja Honkonen
 #include "cstdlib"
 #include "limits"
 #include "tuple"
+#include "type_traits"
+#include "utility"
 #include "vector"
 
 
@@ -51,7 +53,10 @@ Author(s): Ilja Honkonen
 #endif // ifdef MPI_VERSION
 
 
+#include "cold_storage.hpp"
 #include "get_var_mpi_datatype.hpp"
+#include "statistics.hpp"
+#include "type_support.hpp"
 
 
 namespace gensimcell {
@@ -71,6 +76,9 @@ template <
 public:
 	Cell_impl() = default;
 	Cell_impl(const Cell_impl&) = default;
+	Cell_impl(Cell_impl&&) = default;
+	Cell_impl& operator=(const Cell_impl&) = default;
+	Cell_impl& operator=(Cell_impl&&) = default;
 };
 
 
@@ -91,12 +99,17 @@ template <
 	Rest_Of_Variables...
 > :
 	public Cell_impl<Transfer_Policy, number_of_variables, Rest_Of_Variables...>,
-	public Transfer_Policy<Current_Variable>
+	public Transfer_Policy<typename get_variable<Current_Variable>::type>
 {
 
 private:
 
-	typename Current_Variable::data_type data;
+	//! Variable with which data of current variable is accessed.
+	using Current_Var = typename get_variable<Current_Variable>::type;
+
+	alignas(
+		get_storage<Current_Variable>::alignment
+	) typename get_storage<Current_Variable>::type data;
 
 
 protected:
@@ -104,8 +117,8 @@ protected:
 
 	#if defined(MPI_VERSION) && (MPI_VERSION >= 2)
 
-	using Transfer_Policy<Current_Variable>::set_transfer_all_impl;
-	using Transfer_Policy<Current_Variable>::set_transfer_impl;
+	using Transfer_Policy<Current_Var>::set_transfer_all_impl;
+	using Transfer_Policy<Current_Var>::set_transfer_impl;
 
 	using Cell_impl<
 		Transfer_Policy,
@@ -138,15 +151,33 @@ protected:
 	) const {
 
 		size_t nr_transferred = 0;
-		if (this->is_transferred(Current_Variable())) {
+		if (this->is_transferred(Current_Var())) {
+			#ifdef GENSIMCELL_STATISTICS
+			const auto start = std::chrono::steady_clock::now();
+			#endif
+
 			std::tie(
 				addresses[index],
 				counts[index],
 				datatypes[index]
-			) = get_var_mpi_datatype(this->data);
+			) = get_var_mpi_datatype(detail::get_data(this->data));
+
+			#ifdef GENSIMCELL_STATISTICS
+			record_inclusion<Current_Var>(
+				counts[index],
+				datatypes[index],
+				start
+			);
+			#endif
+
 			index++;
 			nr_transferred++;
 		}
+		#ifdef GENSIMCELL_STATISTICS
+		else {
+			record_exclusion<Current_Var>();
+		}
+		#endif
 
 		/*
 		Make the order of variables in the final data type
@@ -179,10 +210,10 @@ protected:
 	>::NAME; \
 	\
 	template<class Other_T> void NAME( \
-		const Current_Variable& GENSIMCELL_COMMA \
+		const Current_Var& GENSIMCELL_COMMA \
 		const Other_T& rhs \
 	) { \
-		this->data OPERATOR rhs; \
+		detail::get_data(this->data) OPERATOR rhs; \
 	}
 
 	GENSIMCELL_MAKE_OPERATOR_IMPLEMENTATION(equal_impl, =)
@@ -196,6 +227,29 @@ protected:
 public:
 	Cell_impl() = default;
 	Cell_impl(const Cell_impl&) = default;
+	Cell_impl(Cell_impl&&) = default;
+
+	/*!
+	Moves data of variables from given cell.
+
+	Like copy assignment doesn't modify the transfer info of this cell.
+	*/
+	Cell_impl& operator=(Cell_impl&& rhs) noexcept(
+		std::is_nothrow_move_assignable<
+			typename get_storage<Current_Variable>::type
+		>::value
+		and std::is_nothrow_move_assignable<
+			Cell_impl<Transfer_Policy, number_of_variables, Rest_Of_Variables...>
+		>::value
+	) {
+		this->data = std::move(rhs.data);
+		Cell_impl<
+			Transfer_Policy,
+			number_of_variables,
+			Rest_Of_Variables...
+		>::operator=(std::move(rhs));
+		return *this;
+	}
 
 
 	/*!
@@ -210,15 +264,15 @@ public:
 
 
 	//! Returns a reference to the data of given variable.
-	typename Current_Variable::data_type& operator[](const Current_Variable&)
+	typename Current_Var::data_type& operator[](const Current_Var&)
 	{
-		return this->data;
+		return detail::get_data(this->data);
 	}
 
 	//! Returns a const reference to the data of given variable.
-	const typename Current_Variable::data_type& operator[](const Current_Variable&) const
+	const typename Current_Var::data_type& operator[](const Current_Var&) const
 	{
-		return this->data;
+		return detail::get_data(this->data);
 	}
 
 	//! Returns references to the data of given variables.
@@ -305,7 +359,7 @@ public:
 	) { \
 		this->NAME( \
 			rhs GENSIMCELL_COMMA \
-			Current_Variable() GENSIMCELL_COMMA \
+			Current_Var() GENSIMCELL_COMMA \
 			Rest_Of_Variables()... \
 		); \
 		return *this; \
@@ -359,7 +413,7 @@ public:
 	) { \
 		this->NAME( \
 			rhs GENSIMCELL_COMMA \
-			Current_Variable() GENSIMCELL_COMMA \
+			Current_Var() GENSIMCELL_COMMA \
 			Rest_Of_Variables()... \
 		); \
 		return *this; \
@@ -461,9 +515,9 @@ public:
 
 	#if defined(MPI_VERSION) && (MPI_VERSION >= 2)
 
-	using Transfer_Policy<Current_Variable>::get_transfer_all;
-	using Transfer_Policy<Current_Variable>::get_transfer;
-	using Transfer_Policy<Current_Variable>::is_transferred;
+	using Transfer_Policy<Current_Var>::get_transfer_all;
+	using Transfer_Policy<Current_Var>::get_transfer;
+	using Transfer_Policy<Current_Var>::is_transferred;
 
 	using Cell_impl<
 		Transfer_Policy,
@@ -667,14 +721,19 @@ template <
 	number_of_variables,
 	Variable
 > :
-	public Transfer_Policy<Variable>
+	public Transfer_Policy<typename get_variable<Variable>::type>
 {
 
 
 private:
 
 
-	typename Variable::data_type data;
+	//! See the variadic version of Cell_impl for documentation
+	using Current_Var = typename get_variable<Variable>::type;
+
+	alignas(
+		get_storage<Variable>::alignment
+	) typename get_storage<Variable>::type data;
 
 
 
@@ -683,10 +742,10 @@ protected:
 
 	#define GENSIMCELL_MAKE_OPERATOR_IMPLEMENTATION_LAST(NAME, OPERATOR) \
 	template<class Other_T> void NAME( \
-		const Variable& GENSIMCELL_COMMA \
+		const Current_Var& GENSIMCELL_COMMA \
 		const Other_T& rhs \
 	) { \
-		this->data OPERATOR rhs; \
+		detail::get_data(this->data) OPERATOR rhs; \
 	}
 
 	GENSIMCELL_MAKE_OPERATOR_IMPLEMENTATION_LAST(equal_impl, =)
@@ -699,8 +758,8 @@ protected:
 
 	#if defined(MPI_VERSION) && (MPI_VERSION >= 2)
 
-	using Transfer_Policy<Variable>::set_transfer_all_impl;
-	using Transfer_Policy<Variable>::set_transfer_impl;
+	using Transfer_Policy<Current_Var>::set_transfer_all_impl;
+	using Transfer_Policy<Current_Var>::set_transfer_impl;
 
 	//! See the variadic version of Cell_impl for documentation
 	size_t get_mpi_datatype_impl(
@@ -710,16 +769,32 @@ protected:
 		std::array<MPI_Datatype, number_of_variables>& datatypes
 	) const {
 
-		if (this->is_transferred(Variable())) {
+		if (this->is_transferred(Current_Var())) {
+			#ifdef GENSIMCELL_STATISTICS
+			const auto start = std::chrono::steady_clock::now();
+			#endif
+
 			std::tie(
 				addresses[index],
 				counts[index],
 				datatypes[index]
-			) = get_var_mpi_datatype(this->data);
+			) = get_var_mpi_datatype(detail::get_data(this->data));
+
+			#ifdef GENSIMCELL_STATISTICS
+			record_inclusion<Current_Var>(
+				counts[index],
+				datatypes[index],
+				start
+			);
+			#endif
 
 			return 1;
 		}
 
+		#ifdef GENSIMCELL_STATISTICS
+		record_exclusion<Current_Var>();
+		#endif
+
 		return 0;
 	}
 
@@ -730,29 +805,40 @@ protected:
 public:
 	Cell_impl() = default;
 	Cell_impl(const Cell_impl&) = default;
+	Cell_impl(Cell_impl&&) = default;
+
+	//! See the variadic version of Cell_impl for documentation
+	Cell_impl& operator=(Cell_impl&& rhs) noexcept(
+		std::is_nothrow_move_assignable<
+			typename get_storage<Variable>::type
+		>::value
+	) {
+		this->data = std::move(rhs.data);
+		return *this;
+	}
 
 	//! See the variadic version of Cell_impl for documentation
-	typename Variable::data_type& operator[](const Variable&)
+	typename Current_Var::data_type& operator[](const Current_Var&)
 	{
-		return this->data;
+		return detail::get_data(this->data);
 	}
 
 	//! See the variadic version of Cell_impl for documentation
-	const typename Variable::data_type& operator[](const Variable&) const
+	const typename Current_Var::data_type& operator[](const Current_Var&) const
 	{
-		return this->data;
+		return detail::get_data(this->data);
 	}
 
 	//! See the variadic version of Cell_impl for documentation
-	std::tuple<typename Variable::data_type&> operator()(const Variable&)
+	std::tuple<typename Current_Var::data_type&> operator()(const Current_Var&)
 	{
-		return std::forward_as_tuple(this->data);
+		return std::forward_as_tuple(detail::get_data(this->data));
 	}
 
 	//! See the variadic version of Cell_impl for documentation
-	std::tuple<const typename Variable::data_type&> operator()(const Variable&) const
+	std::tuple<const typename Current_Var::data_type&> operator()(const Current_Var&) const
 	{
-		return std::forward_as_tuple(this->data);
+		return std::forward_as_tuple(detail::get_data(this->data));
 	}
 
 
@@ -768,7 +854,7 @@ public:
 			Variable \
 		>& rhs \
 	) { \
-		this->NAME(Variable() GENSIMCELL_COMMA rhs[Variable()]); \
+		this->NAME(Current_Var() GENSIMCELL_COMMA rhs[Current_Var()]); \
 		return *this; \
 	}
 
@@ -789,7 +875,7 @@ public:
 	>& operator OPERATOR( \
 		const OTHER_TYPE& rhs \
 	) { \
-		this->NAME(Variable() GENSIMCELL_COMMA rhs); \
+		this->NAME(Current_Var() GENSIMCELL_COMMA rhs); \
 		return *this; \
 	}
 
@@ -890,9 +976,9 @@ public:
 
 	#if defined(MPI_VERSION) && (MPI_VERSION >= 2)
 
-	using Transfer_Policy<Variable>::get_transfer_all;
-	using Transfer_Policy<Variable>::get_transfer;
-	using Transfer_Policy<Variable>::is_transferred;
+	using Transfer_Policy<Current_Var>::get_transfer_all;
+	using Transfer_Policy<Current_Var>::get_transfer;
+	using Transfer_Policy<Current_Var>::is_transferred;
 
 
 	//! See the variadic version of Cell_impl for documentation
@@ -204,14 +204,18 @@ GENSIMCELL_GET_ARRAY_VAR_MPI_DATATYPE(std::complex<long double>, MPI_CXX_LONG_DO
 /*!
 Specializations of get_var_mpi_datatype for standard
 C++ types with an MPI equivalent inside a vector.
+
+Any allocator is accepted, e.g. gensimcell::Aligned_Allocator.
 */
 #define GENSIMCELL_GET_VECTOR_VAR_MPI_DATATYPE(GIVEN_CPP_TYPE, GIVEN_MPI_TYPE) \
-std::tuple< \
+template < \
+	class Allocator \
+> std::tuple< \
 	void*, \
 	int, \
 	MPI_Datatype \
 > get_var_mpi_datatype( \
-	const std::vector<GIVEN_CPP_TYPE>& variable \
+	const std::vector<GIVEN_CPP_TYPE, Allocator>& variable \
 ) { \
 	return std::make_tuple( \
 		(void*) variable.data(), \
@@ -785,6 +789,26 @@ template <
 }
 
 
+/*!
+Frees given datatype unless it is a predefined MPI datatype.
+
+Datatypes returned by get_var_mpi_datatype() are either
+predefined or created for the caller, this releases the
+latter once the caller doesn't need them anymore.
+*/
+inline void free_derived_datatype(MPI_Datatype& datatype)
+{
+	if (datatype == MPI_DATATYPE_NULL) {
+		return;
+	}
+	int combiner = -1, tmp1 = -1, tmp2 = -1, tmp3 = -1;
+	MPI_Type_get_envelope(datatype, &tmp1, &tmp2, &tmp3, &combiner);
+	if (combiner != MPI_COMBINER_NAMED) {
+		MPI_Type_free(&datatype);
+	}
+}
+
+
 } // namespace detail
 } // namespace gensimcell
 
@@ -0,0 +1,1237 @@
+/*
+Exchange of cell data between neighboring processes.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+mpi.h must be included prior to including this file.
+*/
+
+#ifndef GENSIMCELL_HALO_HPP
+#define GENSIMCELL_HALO_HPP
+
+#if defined(MPI_VERSION) && (MPI_VERSION >= 2)
+
+#include "algorithm"
+#include "cstddef"
+#include "tuple"
+#include "utility"
+#include "vector"
+
+#include "get_var_mpi_datatype.hpp"
+
+
+namespace gensimcell {
+
+
+//! MPI communication used by gensimcell::Halo to exchange cell data.
+enum class Halo_Transport {
+	//! MPI_Irecv and MPI_Isend for each neighboring process
+	point_to_point,
+	//! one MPI_Ineighbor_alltoallw, requires MPI 3
+	neighbor_collective,
+	/*!
+	MPI_Get from packed data of neighbors' sent cells exposed
+	in a dynamic window, synchronized with post-start-complete-wait
+	only between neighbors, requires MPI 3
+	*/
+	one_sided,
+	/*!
+	Neighbors on the same node unpack packed data of sent cells
+	directly from each other's MPI_Win_allocate_shared memory,
+	others use point_to_point, requires MPI 3
+	*/
+	shared_memory
+};
+
+
+/*!
+Exchanges data of cells between neighboring processes.
+
+Each process adds the cells it sends to and receives from
+other processes, after which initialize() creates an MPI
+distributed graph topology from the neighboring processes.
+At each exchange data of all cells sent to or received from
+a process is described by one datatype built from the cells'
+get_mpi_datatype(), so each pair of processes exchanges one
+message per direction regardless of the number of cells.
+
+Cells of each neighbor are ordered by the tag given when
+adding them and then by the order in which they were added,
+so a cell sent with a tag arrives in the cell received from
+that process with the same tag. With e.g. a periodic
+Cartesian decomposition on 2 processes both neighbors of a
+process are the same process, in which case the tags can be
+the direction in which data travels:
+@code
+enum {positive, negative};
+gensimcell::Halo<Cell_T> halo;
+halo.add_send(next, positive, cells.back());
+halo.add_send(previous, negative, cells.front());
+halo.add_receive(previous, positive, ghost_cells.front());
+halo.add_receive(next, negative, ghost_cells.back());
+halo.initialize(comm);
+...
+halo.exchange(gensimcell::Halo_Transport::neighbor_collective);
+@endcode
+Neighbors can be obtained e.g. from an MPI_Cart_create
+communicator using MPI_Cart_shift.
+
+With Halo_Transport::one_sided start() packs data of sent
+cells into a buffer attached to an MPI window after which
+each process gets the location of its data from neighbors'
+windows and then the data itself, which wait() unpacks into
+received cells. Senders don't take part in the transfer
+apart from synchronization so all transports can be chosen
+at run time for each exchange.
+
+With Halo_Transport::shared_memory processes sharing memory
+are found with MPI_Comm_split_type, each of them packs data
+sent to neighbors on the same node into its own segment of
+a shared window and wait() unpacks received data straight
+from neighbors' segments. Such exchanges are collective over
+all processes of a node, regardless of whether they're
+neighbors, and data of other neighbors is exchanged as with
+Halo_Transport::point_to_point. Cells must not move
+in memory after they're added and their transfer info,
+e.g. size of receiving vectors, must be correct when an
+exchange starts.
+*/
+template<class Cell_T> class Halo
+{
+public:
+
+	Halo() = default;
+	Halo(const Halo&) = delete;
+	Halo& operator=(const Halo&) = delete;
+
+	~Halo()
+	{
+		this->wait();
+		this->free_communicator();
+	}
+
+
+	//! Adds a cell whose data is sent to given process.
+	void add_send(const int process, const int tag, const Cell_T& cell)
+	{
+		this->sends.push_back({process, tag, &cell});
+		this->initialized = false;
+	}
+
+	//! Adds a cell whose data is received from given process.
+	void add_receive(const int process, const int tag, Cell_T& cell)
+	{
+		this->receives.push_back({process, tag, &cell});
+		this->initialized = false;
+	}
+
+	//! Removes all cells, initialize() must be called again.
+	void clear()
+	{
+		this->sends.clear();
+		this->receives.clear();
+		this->initialized = false;
+	}
+
+
+	/*!
+	Prepares exchanges of cells added so far between processes in comm.
+
+	Must be called by all processes of given communicator, which
+	isn't used afterwards. Returns true on success and false
+	otherwise, e.g. if an exchange is in progress.
+	*/
+	bool initialize(MPI_Comm comm)
+	{
+		if (this->active) {
+			return false;
+		}
+		this->free_communicator();
+
+		this->send_processes = sort_items(this->sends, this->send_ranges);
+		this->receive_processes = sort_items(this->receives, this->receive_ranges);
+
+		if (
+			MPI_Dist_graph_create_adjacent(
+				comm,
+				int(this->receive_processes.size()),
+				this->receive_processes.data(),
+				MPI_UNWEIGHTED,
+				int(this->send_processes.size()),
+				this->send_processes.data(),
+				MPI_UNWEIGHTED,
+				MPI_INFO_NULL,
+				0,
+				&this->graph_comm
+			) != MPI_SUCCESS
+		) {
+			this->graph_comm = MPI_COMM_NULL;
+			return false;
+		}
+
+		this->send_types.assign(this->send_processes.size(), MPI_DATATYPE_NULL);
+		this->receive_types.assign(this->receive_processes.size(), MPI_DATATYPE_NULL);
+		this->send_counts.assign(this->send_processes.size(), 1);
+		this->receive_counts.assign(this->receive_processes.size(), 1);
+		this->send_displacements.assign(this->send_processes.size(), 0);
+		this->receive_displacements.assign(this->receive_processes.size(), 0);
+
+		#if MPI_VERSION >= 3
+		if (not this->initialize_window()) {
+			this->free_window();
+		}
+		if (not this->initialize_shared_memory()) {
+			this->free_shared_memory();
+		}
+		#endif
+
+		this->initialized = true;
+		return true;
+	}
+
+
+	/*!
+	Starts sending and receiving data of added cells.
+
+	Data of sent and received cells must not be accessed
+	before wait() returns. Returns true on success, false
+	otherwise e.g. if initialize() hasn't been called after
+	adding cells or given transport isn't supported.
+	*/
+	bool start(const Halo_Transport transport = Halo_Transport::neighbor_collective)
+	{
+		if (not this->initialized or this->active) {
+			return false;
+		}
+
+		if (not this->create_datatypes()) {
+			this->free_datatypes();
+			return false;
+		}
+
+		this->requests.clear();
+
+		switch (transport) {
+
+		case Halo_Transport::point_to_point:
+			if (not this->start_point_to_point(false)) {
+				this->abort_start();
+				return false;
+			}
+			break;
+
+		case Halo_Transport::neighbor_collective:
+			#if MPI_VERSION >= 3
+			this->requests.push_back(MPI_REQUEST_NULL);
+			if (
+				MPI_Ineighbor_alltoallw(
+					MPI_BOTTOM,
+					this->send_counts.data(),
+					this->send_displacements.data(),
+					this->send_types.data(),
+					MPI_BOTTOM,
+					this->receive_counts.data(),
+					this->receive_displacements.data(),
+					this->receive_types.data(),
+					this->graph_comm,
+					&this->requests.back()
+				) != MPI_SUCCESS
+			) {
+				this->abort_start();
+				return false;
+			}
+			break;
+			#else
+			this->free_datatypes();
+			return false;
+			#endif
+
+		case Halo_Transport::one_sided:
+			#if MPI_VERSION >= 3
+			if (this->window == MPI_WIN_NULL or not this->start_one_sided()) {
+				this->free_datatypes();
+				return false;
+			}
+			break;
+			#else
+			this->free_datatypes();
+			return false;
+			#endif
+
+		case Halo_Transport::shared_memory:
+			#if MPI_VERSION >= 3
+			if (
+				this->shared_window == MPI_WIN_NULL
+				or not this->start_shared_memory()
+			) {
+				this->abort_start();
+				return false;
+			}
+			break;
+			#else
+			this->free_datatypes();
+			return false;
+			#endif
+
+		default:
+			this->free_datatypes();
+			return false;
+		}
+
+		this->transport = transport;
+		this->active = true;
+		return true;
+	}
+
+
+	/*!
+	Waits until the exchange started by start() completes.
+
+	Returns true on success or if no exchange is in progress.
+	*/
+	bool wait()
+	{
+		if (not this->active) {
+			return true;
+		}
+		this->active = false;
+
+		#if MPI_VERSION >= 3
+		if (this->transport == Halo_Transport::one_sided) {
+			const bool success = this->wait_one_sided();
+			this->free_datatypes();
+			return success;
+		}
+		#endif
+
+		bool success
+			= MPI_Waitall(
+				int(this->requests.size()),
+				this->requests.data(),
+				MPI_STATUSES_IGNORE
+			) == MPI_SUCCESS;
+		this->requests.clear();
+
+		#if MPI_VERSION >= 3
+		if (this->transport == Halo_Transport::shared_memory) {
+			success = this->unpack_shared_memory() and success;
+		}
+		#endif
+
+		this->free_datatypes();
+
+		return success;
+	}
+
+
+	/*!
+	Returns true if given transport can be used after initialize().
+
+	Halo_Transport::one_sided and shared_memory aren't supported
+	if e.g. the MPI implementation can't create their windows.
+	*/
+	bool is_supported(const Halo_Transport transport) const
+	{
+		switch (transport) {
+		case Halo_Transport::point_to_point:
+			return true;
+		#if MPI_VERSION >= 3
+		case Halo_Transport::neighbor_collective:
+			return true;
+		case Halo_Transport::one_sided:
+			return this->window != MPI_WIN_NULL;
+		case Halo_Transport::shared_memory:
+			return this->shared_window != MPI_WIN_NULL;
+		#endif
+		default:
+			return false;
+		}
+	}
+
+
+	//! Exchanges data of added cells, same as start() followed by wait().
+	bool exchange(const Halo_Transport transport = Halo_Transport::neighbor_collective)
+	{
+		return this->start(transport) and this->wait();
+	}
+
+
+	//! Processes to which data is sent in order of the graph topology.
+	const std::vector<int>& get_send_processes() const
+	{
+		return this->send_processes;
+	}
+
+	//! Processes from which data is received in order of the graph topology.
+	const std::vector<int>& get_receive_processes() const
+	{
+		return this->receive_processes;
+	}
+
+	/*!
+	Communicator with the distributed graph topology of
+	neighboring processes, MPI_COMM_NULL before initialize().
+	*/
+	MPI_Comm get_communicator() const
+	{
+		return this->graph_comm;
+	}
+
+
+private:
+
+	template<class Pointer_T> struct Item {
+		int process, tag;
+		Pointer_T cell;
+	};
+
+	std::vector<Item<const Cell_T*>> sends;
+	std::vector<Item<Cell_T*>> receives;
+
+	// neighbor processes and their cells' [begin, end) in sends and receives
+	std::vector<int> send_processes, receive_processes;
+	std::vector<std::pair<std::size_t, std::size_t>> send_ranges, receive_ranges;
+
+	MPI_Comm graph_comm = MPI_COMM_NULL;
+	bool initialized = false, active = false;
+	Halo_Transport transport = Halo_Transport::neighbor_collective;
+
+	// arguments of MPI calls that must stay valid during an exchange
+	std::vector<MPI_Datatype> send_types, receive_types;
+	std::vector<int> send_counts, receive_counts;
+	std::vector<MPI_Aint> send_displacements, receive_displacements;
+	std::vector<MPI_Request> requests;
+
+	#if MPI_VERSION >= 3
+	/*
+	Variables of one-sided transport. Window of each process
+	exposes address and size of packed data sent to each
+	neighbor, in order of send_processes, and the packed data.
+	*/
+	MPI_Win window = MPI_WIN_NULL;
+	MPI_Group send_group = MPI_GROUP_NULL, receive_group = MPI_GROUP_NULL;
+	std::vector<MPI_Aint> locations;
+	std::vector<char> packed_sends;
+	// packed_sends' memory currently attached to window
+	char* attached = nullptr;
+	std::size_t attached_size = 0;
+	// addresses of own locations in windows of receive_processes
+	std::vector<MPI_Aint> remote_locations;
+	// locations obtained from receive_processes and their data
+	std::vector<MPI_Aint> received_locations;
+	std::vector<std::vector<char>> packed_receives;
+
+	/*
+	Variables of shared memory transport. Segment of each process
+	starts with offset and size of packed data sent to each
+	neighbor, in order of send_processes, followed by the data.
+	*/
+	MPI_Comm node_comm = MPI_COMM_NULL;
+	MPI_Win shared_window = MPI_WIN_NULL;
+	char* segment = nullptr;
+	MPI_Aint segment_size = 0;
+	// ranks of neighbors in node_comm, MPI_UNDEFINED if on other nodes
+	std::vector<int> send_node_ranks, receive_node_ranks;
+	// own index in send_processes of each receive process
+	std::vector<int> remote_indices;
+	// segments of receive_processes on the same node
+	std::vector<const char*> neighbor_segments;
+	#endif
+
+
+	/*!
+	Sorts given items by process and tag keeping the order
+	of items with the same process and tag.
+
+	Returns processes of items without duplicates and sets
+	ranges to the first and one past last item of each process.
+	*/
+	template<class Pointer_T> static std::vector<int> sort_items(
+		std::vector<Item<Pointer_T>>& items,
+		std::vector<std::pair<std::size_t, std::size_t>>& ranges
+	) {
+		std::stable_sort(
+			items.begin(),
+			items.end(),
+			[](const Item<Pointer_T>& a, const Item<Pointer_T>& b){
+				return std::make_pair(a.process, a.tag) < std::make_pair(b.process, b.tag);
+			}
+		);
+
+		std::vector<int> processes;
+		ranges.clear();
+		for (std::size_t i = 0; i < items.size(); i++) {
+			if (processes.size() == 0 or processes.back() != items[i].process) {
+				processes.push_back(items[i].process);
+				ranges.emplace_back(i, i);
+			}
+			ranges.back().second = i + 1;
+		}
+
+		return processes;
+	}
+
+
+	/*!
+	Returns a committed datatype of given cells
+	relative to MPI_BOTTOM or MPI_DATATYPE_NULL on error.
+	*/
+	template<class Pointer_T> static MPI_Datatype get_datatype(
+		const std::vector<Item<Pointer_T>>& items,
+		const std::pair<std::size_t, std::size_t>& range
+	) {
+		std::vector<int> counts;
+		std::vector<MPI_Aint> addresses;
+		std::vector<MPI_Datatype> datatypes;
+		counts.reserve(range.second - range.first);
+		addresses.reserve(range.second - range.first);
+		datatypes.reserve(range.second - range.first);
+
+		bool success = true;
+		for (std::size_t i = range.first; i < range.second; i++) {
+			void* address = nullptr;
+			int count = -1;
+			MPI_Datatype datatype = MPI_DATATYPE_NULL;
+			std::tie(address, count, datatype) = items[i].cell->get_mpi_datatype();
+
+			if (count < 0 or datatype == MPI_DATATYPE_NULL) {
+				success = false;
+				break;
+			}
+			if (count == 0) {
+				detail::free_derived_datatype(datatype);
+				continue;
+			}
+
+			MPI_Aint absolute_address = 0;
+			MPI_Get_address(address, &absolute_address);
+			counts.push_back(count);
+			addresses.push_back(absolute_address);
+			datatypes.push_back(datatype);
+		}
+
+		MPI_Datatype final_datatype = MPI_DATATYPE_NULL;
+		if (
+			success
+			and (
+				MPI_Type_create_struct(
+					int(counts.size()),
+					counts.data(),
+					addresses.data(),
+					datatypes.data(),
+					&final_datatype
+				) != MPI_SUCCESS
+				or MPI_Type_commit(&final_datatype) != MPI_SUCCESS
+			)
+		) {
+			final_datatype = MPI_DATATYPE_NULL;
+		}
+
+		for (auto& datatype: datatypes) {
+			detail::free_derived_datatype(datatype);
+		}
+
+		return final_datatype;
+	}
+
+
+	//! Returns true if datatypes of all neighbors were created.
+	bool create_datatypes()
+	{
+		for (std::size_t i = 0; i < this->send_processes.size(); i++) {
+			this->send_types[i] = get_datatype(this->sends, this->send_ranges[i]);
+			if (this->send_types[i] == MPI_DATATYPE_NULL) {
+				return false;
+			}
+		}
+		for (std::size_t i = 0; i < this->receive_processes.size(); i++) {
+			this->receive_types[i] = get_datatype(this->receives, this->receive_ranges[i]);
+			if (this->receive_types[i] == MPI_DATATYPE_NULL) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/*!
+	Starts Irecv and Isend of data of neighbors, of only
+	those on other nodes if only_other_nodes is true.
+	*/
+	bool start_point_to_point(const bool only_other_nodes)
+	{
+		for (std::size_t i = 0; i < this->receive_processes.size(); i++) {
+			#if MPI_VERSION >= 3
+			if (only_other_nodes and this->receive_node_ranks[i] != MPI_UNDEFINED) {
+				continue;
+			}
+			#endif
+			this->requests.push_back(MPI_REQUEST_NULL);
+			if (
+				MPI_Irecv(
+					MPI_BOTTOM,
+					1,
+					this->receive_types[i],
+					this->receive_processes[i],
+					0,
+					this->graph_comm,
+					&this->requests.back()
+				) != MPI_SUCCESS
+			) {
+				return false;
+			}
+		}
+		for (std::size_t i = 0; i < this->send_processes.size(); i++) {
+			#if MPI_VERSION >= 3
+			if (only_other_nodes and this->send_node_ranks[i] != MPI_UNDEFINED) {
+				continue;
+			}
+			#endif
+			this->requests.push_back(MPI_REQUEST_NULL);
+			if (
+				MPI_Isend(
+					MPI_BOTTOM,
+					1,
+					this->send_types[i],
+					this->send_processes[i],
+					0,
+					this->graph_comm,
+					&this->requests.back()
+				) != MPI_SUCCESS
+			) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void free_datatypes()
+	{
+		for (auto& datatype: this->send_types) {
+			if (datatype != MPI_DATATYPE_NULL) {
+				MPI_Type_free(&datatype);
+			}
+		}
+		for (auto& datatype: this->receive_types) {
+			if (datatype != MPI_DATATYPE_NULL) {
+				MPI_Type_free(&datatype);
+			}
+		}
+	}
+
+	//! Cancels requests of a partially started exchange.
+	void abort_start()
+	{
+		for (auto& request: this->requests) {
+			if (request != MPI_REQUEST_NULL) {
+				MPI_Cancel(&request);
+				MPI_Request_free(&request);
+			}
+		}
+		this->requests.clear();
+		this->free_datatypes();
+	}
+
+	#if MPI_VERSION >= 3
+	/*!
+	Creates the window of one-sided transport and exchanges
+	addresses of locations of packed data with neighbors.
+	*/
+	bool initialize_window()
+	{
+		// e.g. some implementations don't support dynamic windows on one process
+		MPI_Errhandler error_handler;
+		MPI_Comm_get_errhandler(this->graph_comm, &error_handler);
+		MPI_Comm_set_errhandler(this->graph_comm, MPI_ERRORS_RETURN);
+		const int result = MPI_Win_create_dynamic(
+			MPI_INFO_NULL,
+			this->graph_comm,
+			&this->window
+		);
+		MPI_Comm_set_errhandler(this->graph_comm, error_handler);
+		MPI_Errhandler_free(&error_handler);
+		if (result != MPI_SUCCESS) {
+			this->window = MPI_WIN_NULL;
+			return false;
+		}
+
+		// never empty so that it can always be attached
+		this->locations.assign(2 * this->send_processes.size() + 1, 0);
+		if (
+			MPI_Win_attach(
+				this->window,
+				this->locations.data(),
+				MPI_Aint(this->locations.size() * sizeof(MPI_Aint))
+			) != MPI_SUCCESS
+		) {
+			MPI_Win_free(&this->window);
+			this->window = MPI_WIN_NULL;
+			return false;
+		}
+
+		MPI_Group comm_group = MPI_GROUP_NULL;
+		MPI_Comm_group(this->graph_comm, &comm_group);
+		MPI_Group_incl(
+			comm_group,
+			int(this->send_processes.size()),
+			this->send_processes.data(),
+			&this->send_group
+		);
+		MPI_Group_incl(
+			comm_group,
+			int(this->receive_processes.size()),
+			this->receive_processes.data(),
+			&this->receive_group
+		);
+		MPI_Group_free(&comm_group);
+
+		// tell each process where its data is described
+		std::vector<MPI_Aint> own_locations(this->send_processes.size(), 0);
+		for (std::size_t i = 0; i < own_locations.size(); i++) {
+			MPI_Get_address(&this->locations[2 * i], &own_locations[i]);
+		}
+		this->remote_locations.assign(this->receive_processes.size(), 0);
+		this->received_locations.assign(2 * this->receive_processes.size(), 0);
+		this->packed_receives.resize(this->receive_processes.size());
+
+		std::vector<MPI_Request> location_requests;
+		for (std::size_t i = 0; i < this->receive_processes.size(); i++) {
+			location_requests.push_back(MPI_REQUEST_NULL);
+			MPI_Irecv(
+				&this->remote_locations[i],
+				1,
+				MPI_AINT,
+				this->receive_processes[i],
+				0,
+				this->graph_comm,
+				&location_requests.back()
+			);
+		}
+		for (std::size_t i = 0; i < this->send_processes.size(); i++) {
+			location_requests.push_back(MPI_REQUEST_NULL);
+			MPI_Isend(
+				&own_locations[i],
+				1,
+				MPI_AINT,
+				this->send_processes[i],
+				0,
+				this->graph_comm,
+				&location_requests.back()
+			);
+		}
+
+		return
+			MPI_Waitall(
+				int(location_requests.size()),
+				location_requests.data(),
+				MPI_STATUSES_IGNORE
+			) == MPI_SUCCESS;
+	}
+
+
+	/*!
+	Starts the exposure epoch of neighbors getting data from
+	this process and the access epoch of getting their data.
+
+	Leaves no epoch open on failure.
+	*/
+	bool start_epochs()
+	{
+		if (MPI_Win_post(this->send_group, MPI_MODE_NOPUT, this->window) != MPI_SUCCESS) {
+			return false;
+		}
+		if (MPI_Win_start(this->receive_group, 0, this->window) != MPI_SUCCESS) {
+			MPI_Win_wait(this->window);
+			return false;
+		}
+		return true;
+	}
+
+
+	//! Closes both epochs started by start_epochs(), also on failure.
+	bool complete_epochs()
+	{
+		const bool completed = MPI_Win_complete(this->window) == MPI_SUCCESS;
+		const bool waited = MPI_Win_wait(this->window) == MPI_SUCCESS;
+		return completed and waited;
+	}
+
+
+	/*!
+	Packs data of sent cells into the window, gets locations
+	of data from neighbors and starts getting the data.
+
+	Epochs are open only on success, so on failure the caller
+	only has to free datatypes.
+	*/
+	bool start_one_sided()
+	{
+		std::vector<int> sizes(this->send_processes.size(), 0);
+		std::size_t total_size = 0;
+		for (std::size_t i = 0; i < this->send_processes.size(); i++) {
+			MPI_Pack_size(1, this->send_types[i], this->graph_comm, &sizes[i]);
+			total_size += std::size_t(sizes[i]);
+		}
+
+		// reattach packed data only if its memory changes
+		this->packed_sends.resize(std::max(total_size, std::size_t(1)));
+		if (
+			this->attached != this->packed_sends.data()
+			or this->attached_size != this->packed_sends.capacity()
+		) {
+			if (this->attached != nullptr) {
+				MPI_Win_detach(this->window, this->attached);
+				this->attached = nullptr;
+			}
+			if (
+				MPI_Win_attach(
+					this->window,
+					this->packed_sends.data(),
+					MPI_Aint(this->packed_sends.capacity())
+				) != MPI_SUCCESS
+			) {
+				return false;
+			}
+			this->attached = this->packed_sends.data();
+			this->attached_size = this->packed_sends.capacity();
+		}
+
+		int position = 0;
+		for (std::size_t i = 0; i < this->send_processes.size(); i++) {
+			const int begin = position;
+			if (
+				MPI_Pack(
+					MPI_BOTTOM,
+					1,
+					this->send_types[i],
+					this->packed_sends.data(),
+					int(this->packed_sends.size()),
+					&position,
+					this->graph_comm
+				) != MPI_SUCCESS
+			) {
+				return false;
+			}
+			MPI_Get_address(this->packed_sends.data() + begin, &this->locations[2 * i]);
+			this->locations[2 * i + 1] = position - begin;
+		}
+
+		// locations
+		if (not this->start_epochs()) {
+			return false;
+		}
+		for (std::size_t i = 0; i < this->receive_processes.size(); i++) {
+			MPI_Get(
+				&this->received_locations[2 * i],
+				2,
+				MPI_AINT,
+				this->receive_processes[i],
+				this->remote_locations[i],
+				2,
+				MPI_AINT,
+				this->window
+			);
+		}
+		if (not this->complete_epochs()) {
+			return false;
+		}
+
+		// data, completed in wait_one_sided()
+		if (not this->start_epochs()) {
+			return false;
+		}
+		for (std::size_t i = 0; i < this->receive_processes.size(); i++) {
+			const int size = int(this->received_locations[2 * i + 1]);
+			this->packed_receives[i].resize(std::max(size, 1));
+			if (size == 0) {
+				continue;
+			}
+			MPI_Get(
+				this->packed_receives[i].data(),
+				size,
+				MPI_BYTE,
+				this->receive_processes[i],
+				this->received_locations[2 * i],
+				size,
+				MPI_BYTE,
+				this->window
+			);
+		}
+
+		return true;
+	}
+
+
+	//! Completes gets started by start_one_sided() and unpacks data.
+	bool wait_one_sided()
+	{
+		if (not this->complete_epochs()) {
+			return false;
+		}
+
+		for (std::size_t i = 0; i < this->receive_processes.size(); i++) {
+			int position = 0;
+			if (
+				MPI_Unpack(
+					this->packed_receives[i].data(),
+					int(this->received_locations[2 * i + 1]),
+					&position,
+					MPI_BOTTOM,
+					1,
+					this->receive_types[i],
+					this->graph_comm
+				) != MPI_SUCCESS
+			) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+
+	void free_window()
+	{
+		if (this->window != MPI_WIN_NULL) {
+			if (this->attached != nullptr) {
+				MPI_Win_detach(this->window, this->attached);
+			}
+			MPI_Win_detach(this->window, this->locations.data());
+			MPI_Win_free(&this->window);
+		}
+		this->window = MPI_WIN_NULL;
+		this->attached = nullptr;
+		this->attached_size = 0;
+
+		for (auto* group: {&this->send_group, &this->receive_group}) {
+			if (*group != MPI_GROUP_NULL and *group != MPI_GROUP_EMPTY) {
+				MPI_Group_free(group);
+			}
+			*group = MPI_GROUP_NULL;
+		}
+	}
+
+
+	/*!
+	Creates node communicator and an initial shared window
+	and exchanges indices of neighbors' data with them.
+	*/
+	bool initialize_shared_memory()
+	{
+		if (
+			MPI_Comm_split_type(
+				this->graph_comm,
+				MPI_COMM_TYPE_SHARED,
+				0,
+				MPI_INFO_NULL,
+				&this->node_comm
+			) != MPI_SUCCESS
+		) {
+			this->node_comm = MPI_COMM_NULL;
+			return false;
+		}
+
+		MPI_Group comm_group = MPI_GROUP_NULL, node_group = MPI_GROUP_NULL;
+		MPI_Comm_group(this->graph_comm, &comm_group);
+		MPI_Comm_group(this->node_comm, &node_group);
+		this->send_node_ranks.assign(this->send_processes.size(), MPI_UNDEFINED);
+		this->receive_node_ranks.assign(this->receive_processes.size(), MPI_UNDEFINED);
+		MPI_Group_translate_ranks(
+			comm_group,
+			int(this->send_processes.size()),
+			this->send_processes.data(),
+			node_group,
+			this->send_node_ranks.data()
+		);
+		MPI_Group_translate_ranks(
+			comm_group,
+			int(this->receive_processes.size()),
+			this->receive_processes.data(),
+			node_group,
+			this->receive_node_ranks.data()
+		);
+		MPI_Group_free(&comm_group);
+		MPI_Group_free(&node_group);
+
+		std::vector<int> own_indices(this->send_processes.size());
+		for (std::size_t i = 0; i < own_indices.size(); i++) {
+			own_indices[i] = int(i);
+		}
+		this->remote_indices.assign(this->receive_processes.size(), -1);
+
+		std::vector<MPI_Request> index_requests;
+		for (std::size_t i = 0; i < this->receive_processes.size(); i++) {
+			index_requests.push_back(MPI_REQUEST_NULL);
+			MPI_Irecv(
+				&this->remote_indices[i],
+				1,
+				MPI_INT,
+				this->receive_processes[i],
+				0,
+				this->graph_comm,
+				&index_requests.back()
+			);
+		}
+		for (std::size_t i = 0; i < this->send_processes.size(); i++) {
+			index_requests.push_back(MPI_REQUEST_NULL);
+			MPI_Isend(
+				&own_indices[i],
+				1,
+				MPI_INT,
+				this->send_processes[i],
+				0,
+				this->graph_comm,
+				&index_requests.back()
+			);
+		}
+		if (
+			MPI_Waitall(
+				int(index_requests.size()),
+				index_requests.data(),
+				MPI_STATUSES_IGNORE
+			) != MPI_SUCCESS
+		) {
+			return false;
+		}
+
+		return this->allocate_segment(this->get_segment_header_size());
+	}
+
+
+	MPI_Aint get_segment_header_size() const
+	{
+		return MPI_Aint(2 * this->send_processes.size() * sizeof(MPI_Aint));
+	}
+
+
+	/*!
+	Replaces the shared window with one in which the segment
+	of this process is at least given size.
+
+	Collective over node_comm.
+	*/
+	bool allocate_segment(MPI_Aint size)
+	{
+		this->free_shared_window();
+
+		// keep all segments, which are contiguous by default, aligned
+		constexpr MPI_Aint alignment = 64;
+		size = std::max(size, MPI_Aint(1));
+		size = (size + alignment - 1) / alignment * alignment;
+
+		char* new_segment = nullptr;
+		if (
+			MPI_Win_allocate_shared(
+				size,
+				1,
+				MPI_INFO_NULL,
+				this->node_comm,
+				&new_segment,
+				&this->shared_window
+			) != MPI_SUCCESS
+		) {
+			this->shared_window = MPI_WIN_NULL;
+			return false;
+		}
+		this->segment = new_segment;
+		this->segment_size = size;
+		std::fill(this->segment, this->segment + this->get_segment_header_size(), 0);
+
+		this->neighbor_segments.assign(this->receive_processes.size(), nullptr);
+		for (std::size_t i = 0; i < this->receive_processes.size(); i++) {
+			if (this->receive_node_ranks[i] == MPI_UNDEFINED) {
+				continue;
+			}
+			MPI_Aint neighbor_size = 0;
+			int displacement_unit = 0;
+			char* neighbor_segment = nullptr;
+			MPI_Win_shared_query(
+				this->shared_window,
+				this->receive_node_ranks[i],
+				&neighbor_size,
+				&displacement_unit,
+				&neighbor_segment
+			);
+			this->neighbor_segments[i] = neighbor_segment;
+		}
+
+		return MPI_Win_lock_all(MPI_MODE_NOCHECK, this->shared_window) == MPI_SUCCESS;
+	}
+
+
+	/*!
+	Packs data sent to neighbors on the same node into
+	own segment and starts exchanges with other neighbors.
+
+	Segments are only written after all processes of the node
+	have entered this function and thus finished unpacking
+	previous exchange, and only read after all have written.
+	*/
+	bool start_shared_memory()
+	{
+		std::vector<int> sizes(this->send_processes.size(), 0);
+		MPI_Aint required_size = this->get_segment_header_size();
+		for (std::size_t i = 0; i < this->send_processes.size(); i++) {
+			if (this->send_node_ranks[i] == MPI_UNDEFINED) {
+				continue;
+			}
+			MPI_Pack_size(1, this->send_types[i], this->graph_comm, &sizes[i]);
+			required_size += sizes[i];
+		}
+
+		int grow = (required_size > this->segment_size ? 1 : 0);
+		if (
+			MPI_Allreduce(
+				MPI_IN_PLACE, &grow, 1, MPI_INT, MPI_MAX, this->node_comm
+			) != MPI_SUCCESS
+		) {
+			return false;
+		}
+		if (
+			grow > 0
+			and not this->allocate_segment(
+				std::max(required_size + required_size / 2, this->segment_size)
+			)
+		) {
+			return false;
+		}
+
+		MPI_Aint* const header = reinterpret_cast<MPI_Aint*>(this->segment);
+		int position = int(this->get_segment_header_size());
+		for (std::size_t i = 0; i < this->send_processes.size(); i++) {
+			if (this->send_node_ranks[i] == MPI_UNDEFINED) {
+				continue;
+			}
+			const int begin = position;
+			if (
+				MPI_Pack(
+					MPI_BOTTOM,
+					1,
+					this->send_types[i],
+					this->segment,
+					int(this->segment_size),
+					&position,
+					this->graph_comm
+				) != MPI_SUCCESS
+			) {
+				return false;
+			}
+			header[2 * i] = begin;
+			header[2 * i + 1] = position - begin;
+		}
+
+		if (
+			MPI_Win_sync(this->shared_window) != MPI_SUCCESS
+			or MPI_Barrier(this->node_comm) != MPI_SUCCESS
+			or MPI_Win_sync(this->shared_window) != MPI_SUCCESS
+		) {
+			return false;
+		}
+
+		return this->start_point_to_point(true);
+	}
+
+
+	//! Unpacks data of neighbors on the same node from their segments.
+	bool unpack_shared_memory()
+	{
+		for (std::size_t i = 0; i < this->receive_processes.size(); i++) {
+			if (this->neighbor_segments[i] == nullptr) {
+				continue;
+			}
+			const MPI_Aint* const header
+				= reinterpret_cast<const MPI_Aint*>(this->neighbor_segments[i]);
+			const std::size_t index = std::size_t(this->remote_indices[i]);
+
+			int position = 0;
+			if (
+				MPI_Unpack(
+					this->neighbor_segments[i] + header[2 * index],
+					int(header[2 * index + 1]),
+					&position,
+					MPI_BOTTOM,
+					1,
+					this->receive_types[i],
+					this->graph_comm
+				) != MPI_SUCCESS
+			) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+
+	void free_shared_window()
+	{
+		if (this->shared_window != MPI_WIN_NULL) {
+			MPI_Win_unlock_all(this->shared_window);
+			MPI_Win_free(&this->shared_window);
+		}
+		this->shared_window = MPI_WIN_NULL;
+		this->segment = nullptr;
+		this->segment_size = 0;
+		this->neighbor_segments.clear();
+	}
+
+	void free_shared_memory()
+	{
+		this->free_shared_window();
+		if (this->node_comm != MPI_COMM_NULL) {
+			MPI_Comm_free(&this->node_comm);
+		}
+		this->node_comm = MPI_COMM_NULL;
+	}
+	#endif
+
+	void free_communicator()
+	{
+		int finalized = 0;
+		MPI_Finalized(&finalized);
+		#if MPI_VERSION >= 3
+		if (not finalized) {
+			this->free_window();
+			this->free_shared_memory();
+		}
+		#endif
+		if (this->graph_comm != MPI_COMM_NULL and not finalized) {
+			MPI_Comm_free(&this->graph_comm);
+		}
+		this->graph_comm = MPI_COMM_NULL;
+		this->initialized = false;
+	}
+};
+
+
+} // namespace gensimcell
+
+#endif // if defined(MPI_VERSION) && (MPI_VERSION >= 2)
+
+#endif // ifndef GENSIMCELL_HALO_HPP
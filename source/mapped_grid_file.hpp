@@ -0,0 +1,417 @@
+/*
+Read-only memory mapped access to files saved by dccrg.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+Requires a POSIX system but not MPI, for example files
+saved by dccrg's save_grid_data() can be post-processed
+without initializing MPI. Data in the file is accessed
+directly through the memory mapping without copying it
+into separate buffers.
+*/
+
+#ifndef GENSIMCELL_MAPPED_GRID_FILE_HPP
+#define GENSIMCELL_MAPPED_GRID_FILE_HPP
+
+
+#include "algorithm"
+#include "array"
+#include "cstdint"
+#include "cstring"
+#include "fcntl.h"
+#include "string"
+#include "sys/mman.h"
+#include "sys/stat.h"
+#include "unistd.h"
+#include "unordered_map"
+#include "utility"
+#include "vector"
+
+
+namespace gensimcell {
+
+
+/*!
+Memory maps a file saved by dccrg for reading.
+
+The cell list read by read_cells() is assumed to be in the
+format used by dccrg: uint64_t number of cells followed by
+uint64_t cell id and uint64_t file offset of cell's data for
+each cell. Data of cells is assumed to be stored without gaps
+between cells, but not necessarily in the order of the list.
+
+Example:
+@code
+gensimcell::Mapped_Grid_File file;
+if (not file.open("gol_0000.dc")) {
+	...
+}
+if (not file.read_cells(offset_of_cell_list)) {
+	...
+}
+for (size_t i = 0; i < file.get_cells().size(); i++) {
+	bool is_alive;
+	file.read(file.get_cell_data_offset(i), is_alive);
+	...
+}
+@endcode
+*/
+class Mapped_Grid_File
+{
+public:
+
+	Mapped_Grid_File() = default;
+	Mapped_Grid_File(const Mapped_Grid_File&) = delete;
+	Mapped_Grid_File& operator=(const Mapped_Grid_File&) = delete;
+
+	~Mapped_Grid_File()
+	{
+		this->close();
+	}
+
+
+	/*!
+	Maps given file into memory for reading.
+
+	Closes previously opened file if any.
+	Returns true on success and false otherwise.
+	*/
+	bool open(const std::string& file_name)
+	{
+		this->close();
+
+		const int file_descriptor = ::open(file_name.c_str(), O_RDONLY);
+		if (file_descriptor < 0) {
+			return false;
+		}
+
+		struct stat file_status;
+		if (fstat(file_descriptor, &file_status) != 0) {
+			::close(file_descriptor);
+			return false;
+		}
+
+		if (file_status.st_size > 0) {
+			void* const mapped = mmap(
+				nullptr,
+				size_t(file_status.st_size),
+				PROT_READ,
+				MAP_PRIVATE,
+				file_descriptor,
+				0
+			);
+			if (mapped == MAP_FAILED) {
+				::close(file_descriptor);
+				return false;
+			}
+
+			// data is usually read sequentially from start to end
+			madvise(mapped, size_t(file_status.st_size), MADV_SEQUENTIAL);
+
+			this->mapped_data = static_cast<const char*>(mapped);
+			this->mapped_size = uint64_t(file_status.st_size);
+		}
+
+		// mapping stays valid after closing the file
+		::close(file_descriptor);
+		this->is_opened = true;
+
+		return true;
+	}
+
+
+	//! Unmaps the file mapped by open(), if any.
+	void close()
+	{
+		if (this->mapped_data != nullptr) {
+			munmap(const_cast<char*>(this->mapped_data), size_t(this->mapped_size));
+		}
+
+		this->mapped_data = nullptr;
+		this->mapped_size = 0;
+		this->is_opened = false;
+		this->close_cells();
+	}
+
+
+	bool is_open() const
+	{
+		return this->is_opened;
+	}
+
+
+	//! Returns the beginning of the mapped file, nullptr if file is empty.
+	const char* data() const
+	{
+		return this->mapped_data;
+	}
+
+
+	//! Returns the size of the mapped file in bytes.
+	uint64_t size() const
+	{
+		return this->mapped_size;
+	}
+
+
+	/*!
+	Copies data starting at given offset in the file into given variable.
+
+	Data in the file is not necessarily aligned for T so it
+	is copied instead of accessed through a pointer to T.
+	Returns false if data would be read beyond the end of file.
+	*/
+	template<class T> bool read(const uint64_t offset, T& result) const
+	{
+		return this->read(offset, &result, 1);
+	}
+
+	//! Copies given number of items of type T into given address.
+	template<class T> bool read(
+		const uint64_t offset,
+		T* const result,
+		const uint64_t number_of_items
+	) const {
+		if (
+			number_of_items > this->mapped_size / sizeof(T)
+			or not this->is_inside(offset, number_of_items * sizeof(T))
+		) {
+			return false;
+		}
+
+		if (number_of_items > 0) {
+			std::memcpy(
+				static_cast<void*>(result),
+				this->mapped_data + offset,
+				number_of_items * sizeof(T)
+			);
+		}
+
+		return true;
+	}
+
+
+	/*!
+	Reads the list of cells and offsets of their data starting at given offset.
+
+	Returns false if the list or data of any cell would
+	be outside of the file, in which case the cell list
+	is empty.
+	*/
+	bool read_cells(uint64_t offset)
+	{
+		this->close_cells();
+
+		uint64_t total_cells = 0;
+		if (not this->read(offset, total_cells)) {
+			return false;
+		}
+		offset += sizeof(uint64_t);
+
+		if (
+			total_cells > this->mapped_size / (2 * sizeof(uint64_t))
+			or not this->is_inside(offset, total_cells * 2 * sizeof(uint64_t))
+		) {
+			return false;
+		}
+
+		this->cells.resize(total_cells);
+		this->cell_data_offsets.resize(total_cells);
+		this->cell_data_sizes.resize(total_cells);
+		this->cell_indices.reserve(total_cells);
+
+		std::vector<std::pair<uint64_t, size_t>> sorted_offsets;
+		sorted_offsets.reserve(total_cells);
+
+		for (size_t i = 0; i < total_cells; i++) {
+			this->read(offset, this->cells[i]);
+			offset += sizeof(uint64_t);
+			this->read(offset, this->cell_data_offsets[i]);
+			offset += sizeof(uint64_t);
+
+			if (this->cell_data_offsets[i] > this->mapped_size) {
+				this->close_cells();
+				return false;
+			}
+
+			this->cell_indices[this->cells[i]] = i;
+			sorted_offsets.emplace_back(this->cell_data_offsets[i], i);
+		}
+
+		// data of each cell ends where data of next cell starts
+		std::sort(sorted_offsets.begin(), sorted_offsets.end());
+		for (size_t i = 0; i < sorted_offsets.size(); i++) {
+			const uint64_t end
+				= (i + 1 < sorted_offsets.size())
+				? sorted_offsets[i + 1].first
+				: this->mapped_size;
+
+			this->cell_data_sizes[sorted_offsets[i].second]
+				= end - sorted_offsets[i].first;
+		}
+
+		return true;
+	}
+
+
+	/*!
+	Sets given cell id mapping from the file's header saved by dccrg.
+
+	Given offset must point to the start of the mapping's data
+	after any user header, on success it is increased to the start
+	of the cell list for read_cells(). Given topology and geometry
+	are only used for skipping their data in the file.
+	Returns false if the mapping couldn't be read or set.
+
+	Example:
+	@code
+	dccrg::Mapping mapping;
+	dccrg::Grid_Topology topology;
+	dccrg::Cartesian_Geometry geometry(mapping.length, mapping, topology);
+	uint64_t offset = user_header_size;
+	if (
+		not file.read_mapping(offset, mapping, topology, geometry)
+		or not file.read_cells(offset)
+	) {
+		...
+	}
+	@endcode
+	*/
+	template<
+		class Mapping_T,
+		class Topology_T,
+		class Geometry_T
+	> bool read_mapping(
+		uint64_t& offset,
+		Mapping_T& mapping,
+		const Topology_T& topology,
+		const Geometry_T& geometry
+	) const {
+		// grid's length and maximum refinement level
+		std::array<uint64_t, 3> length{{0, 0, 0}};
+		int max_refinement_level = -1;
+		if (
+			not this->read(offset, length)
+			or not this->read(offset + sizeof(length), max_refinement_level)
+			or not mapping.length.set(length)
+			or not mapping.set_maximum_refinement_level(max_refinement_level)
+		) {
+			return false;
+		}
+
+		offset
+			+= mapping.data_size()
+			+ sizeof(unsigned int)
+			+ topology.data_size()
+			+ geometry.data_size();
+
+		return true;
+	}
+
+
+	//! Returns ids of cells read by read_cells() in the order they were listed.
+	const std::vector<uint64_t>& get_cells() const
+	{
+		return this->cells;
+	}
+
+
+	/*!
+	Returns the index of given cell in get_cells().
+
+	Returns get_cells().size() if given cell doesn't exist.
+	*/
+	size_t get_cell_index(const uint64_t cell_id) const
+	{
+		const auto iter = this->cell_indices.find(cell_id);
+		if (iter == this->cell_indices.cend()) {
+			return this->cells.size();
+		}
+		return iter->second;
+	}
+
+
+	//! Returns the offset in file of data of cell with given index in get_cells().
+	uint64_t get_cell_data_offset(const size_t index) const
+	{
+		return this->cell_data_offsets[index];
+	}
+
+
+	/*!
+	Returns the beginning and size in bytes of data
+	of cell with given index in get_cells().
+
+	Returned data is not copied and is valid until
+	the file is closed.
+	*/
+	std::pair<const char*, uint64_t> get_cell_data(const size_t index) const
+	{
+		return std::make_pair(
+			this->mapped_data + this->cell_data_offsets[index],
+			this->cell_data_sizes[index]
+		);
+	}
+
+
+private:
+
+	const char* mapped_data = nullptr;
+	uint64_t mapped_size = 0;
+	bool is_opened = false;
+
+	std::vector<uint64_t>
+		cells,
+		cell_data_offsets,
+		cell_data_sizes;
+	std::unordered_map<uint64_t, size_t> cell_indices;
+
+
+	bool is_inside(const uint64_t offset, const uint64_t number_of_bytes) const
+	{
+		return
+			offset <= this->mapped_size
+			and number_of_bytes <= this->mapped_size - offset;
+	}
+
+	void close_cells()
+	{
+		this->cells.clear();
+		this->cell_data_offsets.clear();
+		this->cell_data_sizes.clear();
+		this->cell_indices.clear();
+	}
+};
+
+
+} // namespace gensimcell
+
+#endif // ifndef GENSIMCELL_MAPPED_GRID_FILE_HPP
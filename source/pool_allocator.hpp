@@ -0,0 +1,346 @@
+/*
+Allocator reusing memory of freed containers.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef GENSIMCELL_POOL_ALLOCATOR_HPP
+#define GENSIMCELL_POOL_ALLOCATOR_HPP
+
+
+#include "array"
+#include "cstddef"
+#include "limits"
+#include "new"
+
+
+namespace gensimcell {
+
+
+/*!
+Keeps memory freed by Pool_Allocator<..., Tag> for reuse.
+
+Memory is handed out in blocks of power of 2 bytes and
+freed blocks are kept in a list of the same size from
+which later allocations of that size are served without
+calling the global operator new. Blocks larger than
+max_pooled_bytes are allocated and freed directly.
+
+Each thread has its own pool so no locking is needed,
+a block freed in another thread than where it was
+allocated is reused by the freeing thread. At most
+get_max_cached_bytes() are kept in each thread's pool
+and the pool is released when its thread exits, after
+which memory is freed directly with the global delete.
+*/
+template <class Tag = void> class Pool
+{
+public:
+
+	//! Largest block kept in the pool.
+	static constexpr std::size_t max_pooled_bytes = std::size_t(1) << 24;
+
+	//! Default maximum number of unused bytes kept in each thread's pool.
+	static constexpr std::size_t default_max_cached_bytes = std::size_t(1) << 28;
+
+
+	//! Returns at least given number of bytes aligned as std::max_align_t.
+	static void* allocate(const std::size_t bytes)
+	{
+		const std::size_t size_class = get_size_class(bytes);
+		if (size_class >= number_of_size_classes) {
+			return ::operator new(bytes);
+		}
+
+		Storage* const storage = get_storage();
+		if (storage == nullptr or storage->free_blocks[size_class] == nullptr) {
+			return ::operator new(get_block_size(size_class));
+		}
+
+		Free_Block*& first = storage->free_blocks[size_class];
+		Free_Block* const block = first;
+		first = block->next;
+		storage->cached_bytes -= get_block_size(size_class);
+		return block;
+	}
+
+
+	//! Returns to the pool memory given by allocate() with the same bytes.
+	static void deallocate(void* const memory, const std::size_t bytes)
+	{
+		if (memory == nullptr) {
+			return;
+		}
+
+		const std::size_t size_class = get_size_class(bytes);
+		if (size_class >= number_of_size_classes) {
+			::operator delete(memory);
+			return;
+		}
+
+		Storage* const storage = get_storage();
+		if (
+			storage == nullptr
+			or storage->cached_bytes + get_block_size(size_class)
+				> storage->max_cached_bytes
+		) {
+			::operator delete(memory);
+			return;
+		}
+
+		Free_Block* const block = static_cast<Free_Block*>(memory);
+		block->next = storage->free_blocks[size_class];
+		storage->free_blocks[size_class] = block;
+		storage->cached_bytes += get_block_size(size_class);
+	}
+
+
+	/*!
+	Returns unused memory of the calling thread's pool to the system.
+
+	Memory in use by containers is not affected. Can be called
+	e.g. at the end of a time step or after load balancing if the
+	number of particles per process has decreased substantially.
+	*/
+	static void release()
+	{
+		Storage* const storage = get_storage();
+		if (storage != nullptr) {
+			storage->release();
+		}
+	}
+
+
+	//! Returns the number of bytes in the calling thread's pool not in use.
+	static std::size_t get_cached_bytes()
+	{
+		const Storage* const storage = get_storage();
+		return storage == nullptr ? 0 : storage->cached_bytes;
+	}
+
+
+	//! Returns the maximum number of unused bytes kept in the calling thread's pool.
+	static std::size_t get_max_cached_bytes()
+	{
+		const Storage* const storage = get_storage();
+		return storage == nullptr ? 0 : storage->max_cached_bytes;
+	}
+
+	/*!
+	Sets the maximum number of unused bytes kept in the calling thread's pool.
+
+	Memory freed while the pool is full is returned to the system,
+	already cached memory is released if it exceeds given maximum.
+	*/
+	static void set_max_cached_bytes(const std::size_t bytes)
+	{
+		Storage* const storage = get_storage();
+		if (storage == nullptr) {
+			return;
+		}
+		storage->max_cached_bytes = bytes;
+		if (storage->cached_bytes > bytes) {
+			storage->release();
+		}
+	}
+
+
+private:
+
+	static constexpr std::size_t
+		min_block_bytes = alignof(std::max_align_t) > sizeof(void*)
+			? alignof(std::max_align_t)
+			: sizeof(void*),
+		number_of_size_classes = 25;
+
+	struct Free_Block {
+		Free_Block* next;
+	};
+
+	struct Storage {
+		std::array<Free_Block*, number_of_size_classes> free_blocks{{}};
+		std::size_t
+			cached_bytes = 0,
+			max_cached_bytes = default_max_cached_bytes;
+
+		Storage() = default;
+		Storage(const Storage&) = delete;
+		Storage& operator=(const Storage&) = delete;
+
+		~Storage()
+		{
+			this->release();
+			is_destroyed() = true;
+		}
+
+		void release()
+		{
+			for (std::size_t i = 0; i < number_of_size_classes; i++) {
+				while (this->free_blocks[i] != nullptr) {
+					Free_Block* const block = this->free_blocks[i];
+					this->free_blocks[i] = block->next;
+					::operator delete(block);
+				}
+			}
+			this->cached_bytes = 0;
+		}
+	};
+
+
+	static std::size_t get_block_size(const std::size_t size_class)
+	{
+		return std::size_t(1) << size_class;
+	}
+
+	/*!
+	Returns the smallest size class that fits given bytes.
+
+	Size classes >= number_of_size_classes aren't pooled.
+	*/
+	static std::size_t get_size_class(const std::size_t bytes)
+	{
+		if (bytes > max_pooled_bytes) {
+			return number_of_size_classes;
+		}
+
+		std::size_t size_class = 0;
+		while (get_block_size(size_class) < bytes or get_block_size(size_class) < min_block_bytes) {
+			size_class++;
+		}
+		return size_class;
+	}
+
+	/*
+	Whether the calling thread's pool has been destroyed.
+
+	Trivially destructible so it stays usable while
+	other thread local objects are destroyed.
+	*/
+	static bool& is_destroyed()
+	{
+		thread_local bool destroyed = false;
+		return destroyed;
+	}
+
+	/*!
+	Returns the calling thread's pool or nullptr if it has
+	been destroyed, in which case e.g. containers destroyed
+	after the end of main use the global new and delete.
+	*/
+	static Storage* get_storage()
+	{
+		if (is_destroyed()) {
+			return nullptr;
+		}
+		thread_local Storage storage;
+		return &storage;
+	}
+};
+
+
+/*!
+Standard library compatible allocator using gensimcell::Pool.
+
+Allows e.g. vectors of particles in cells to reuse memory
+released by other cells instead of calling global new and
+delete every time particles move between cells:
+@code
+struct Particle_Pool {};
+struct Particles {
+	using data_type = std::vector<
+		std::array<double, 3>,
+		gensimcell::Pool_Allocator<std::array<double, 3>, Particle_Pool>
+	>;
+};
+@endcode
+All allocators with the same Tag share a pool. Vectors
+using this allocator are transferred with MPI in the same
+way as vectors using the default allocator.
+*/
+template <
+	class T,
+	class Tag = void
+> class Pool_Allocator
+{
+	static_assert(
+		alignof(T) <= alignof(std::max_align_t),
+		"Over-aligned types aren't supported, use Aligned_Allocator instead"
+	);
+
+public:
+
+	using value_type = T;
+	using pointer = T*;
+	using const_pointer = const T*;
+	using reference = T&;
+	using const_reference = const T&;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+
+	template <class U> struct rebind {
+		using other = Pool_Allocator<U, Tag>;
+	};
+
+
+	Pool_Allocator() = default;
+
+	template <class U> Pool_Allocator(const Pool_Allocator<U, Tag>&) {}
+
+
+	//! Throws std::bad_alloc if memory couldn't be allocated.
+	T* allocate(const std::size_t number_of_items)
+	{
+		if (number_of_items > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+			throw std::bad_alloc();
+		}
+		return static_cast<T*>(Pool<Tag>::allocate(number_of_items * sizeof(T)));
+	}
+
+	void deallocate(T* const items, const std::size_t number_of_items)
+	{
+		Pool<Tag>::deallocate(items, number_of_items * sizeof(T));
+	}
+
+
+	template <class U> bool operator==(const Pool_Allocator<U, Tag>&) const
+	{
+		return true;
+	}
+
+	template <class U> bool operator!=(const Pool_Allocator<U, Tag>&) const
+	{
+		return false;
+	}
+};
+
+
+} // namespace gensimcell
+
+#endif // ifndef GENSIMCELL_POOL_ALLOCATOR_HPP
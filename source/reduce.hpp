@@ -0,0 +1,472 @@
+/*
+Reductions of variables over cells.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef GENSIMCELL_REDUCE_HPP
+#define GENSIMCELL_REDUCE_HPP
+
+
+#include "algorithm"
+#include "cstddef"
+#include "cstdlib"
+#include "iostream"
+#include "iterator"
+#include "limits"
+#include "thread"
+#include "tuple"
+#include "type_traits"
+#include "vector"
+
+
+namespace gensimcell {
+
+
+/*!
+Reduction operations for gensimcell::reduce().
+
+Each operation defines the type of the result of reducing
+a variable with given data type, the initial value of the
+result and how a data or partial result is combined into
+a result.
+*/
+
+//! Adds up data, e.g. bools are counted into an int.
+struct Sum {
+	template<class Data_T> using result = decltype(Data_T() + Data_T());
+
+	template<class Result_T> static Result_T identity()
+	{
+		return Result_T(0);
+	}
+
+	template<class Result_T, class Data_T> static void combine(
+		Result_T& result,
+		const Data_T& data
+	) {
+		result += data;
+	}
+};
+
+//! Smallest value of data.
+struct Min {
+	template<class Data_T> using result = Data_T;
+
+	template<class Result_T> static Result_T identity()
+	{
+		return std::numeric_limits<Result_T>::max();
+	}
+
+	template<class Result_T, class Data_T> static void combine(
+		Result_T& result,
+		const Data_T& data
+	) {
+		result = std::min<Result_T>(result, data);
+	}
+};
+
+//! Largest value of data.
+struct Max {
+	template<class Data_T> using result = Data_T;
+
+	template<class Result_T> static Result_T identity()
+	{
+		return std::numeric_limits<Result_T>::lowest();
+	}
+
+	template<class Result_T, class Data_T> static void combine(
+		Result_T& result,
+		const Data_T& data
+	) {
+		result = std::max<Result_T>(result, data);
+	}
+};
+
+
+namespace detail {
+
+//! Type of the result of reducing Variable's data with Operation.
+template<class Operation, class Variable> using reduction_result
+	= typename Operation::template result<typename Variable::data_type>;
+
+
+//! Returns a cell given either a cell or a pointer to one.
+template<class Cell_T> const Cell_T& get_cell(const Cell_T& cell)
+{
+	return cell;
+}
+
+template<class Cell_T> const Cell_T& get_cell(const Cell_T* const cell)
+{
+	return *cell;
+}
+
+template<class Cell_T> const Cell_T& get_cell(Cell_T* const cell)
+{
+	return *cell;
+}
+
+
+/*!
+Combines each item of given tuple into corresponding item of result.
+
+Applies to items starting from Index.
+*/
+template<
+	std::size_t Index,
+	class Operation,
+	class... Results
+> typename std::enable_if<
+	Index == sizeof...(Results)
+>::type combine_tuple(
+	std::tuple<Results...>&,
+	const std::tuple<Results...>&
+) {}
+
+template<
+	std::size_t Index,
+	class Operation,
+	class... Results
+> typename std::enable_if<
+	Index < sizeof...(Results)
+>::type combine_tuple(
+	std::tuple<Results...>& result,
+	const std::tuple<Results...>& other
+) {
+	Operation::combine(std::get<Index>(result), std::get<Index>(other));
+	combine_tuple<Index + 1, Operation>(result, other);
+}
+
+
+//! Combines given variables of given cell into result starting at Index.
+template<
+	std::size_t Index,
+	class Operation,
+	class Cell_T,
+	class... Results
+> void combine_cell(
+	std::tuple<Results...>&,
+	const Cell_T&
+) {}
+
+template<
+	std::size_t Index,
+	class Operation,
+	class Cell_T,
+	class... Results,
+	class First_Variable,
+	class... Rest_Of_Variables
+> void combine_cell(
+	std::tuple<Results...>& result,
+	const Cell_T& cell,
+	const First_Variable& first,
+	const Rest_Of_Variables&... rest
+) {
+	Operation::combine(std::get<Index>(result), cell[first]);
+	combine_cell<Index + 1, Operation>(result, cell, rest...);
+}
+
+
+/*!
+Reduces given variables of cells in given range in one pass.
+
+Cells in the range can also be pointers to cells.
+*/
+template<
+	class Iterator,
+	class Operation,
+	class... Variables
+> std::tuple<
+	reduction_result<Operation, Variables>...
+> reduce_range(
+	const Iterator begin,
+	const Iterator end,
+	const Operation&,
+	const Variables&... variables
+) {
+	static_assert(
+		sizeof...(Variables) > 0,
+		"At least one variable must be given"
+	);
+
+	std::tuple<reduction_result<Operation, Variables>...> result(
+		Operation::template identity<reduction_result<Operation, Variables>>()...
+	);
+
+	for (auto item = begin; item != end; item++) {
+		combine_cell<0, Operation>(result, get_cell(*item), variables...);
+	}
+
+	return result;
+}
+
+} // namespace detail
+
+
+/*!
+Reduces given variables over cells in the range [begin, end).
+
+Returns the result of each variable in the same order as
+variables are given. Cells can also be given as a range of
+pointers to cells. Data of all variables must be arithmetic
+and all variables are reduced in one pass over the cells.
+For example the number of live cells and largest density:
+@code
+std::vector<Cell_T> cells;
+...
+const auto live_cells = std::get<0>(
+	gensimcell::reduce(cells.cbegin(), cells.cend(), gensimcell::Sum(), Is_Alive())
+);
+@endcode
+*/
+template<
+	class Iterator,
+	class Operation,
+	class... Variables
+> std::tuple<
+	detail::reduction_result<Operation, Variables>...
+> reduce(
+	const Iterator begin,
+	const Iterator end,
+	const Operation& operation,
+	const Variables&... variables
+) {
+	return detail::reduce_range(begin, end, operation, variables...);
+}
+
+
+/*!
+Same as the other version of reduce() but uses given number of threads.
+
+The range is split evenly between threads each of which
+reduces its part, partial results are combined in order
+of the parts.
+*/
+template<
+	class Iterator,
+	class Operation,
+	class... Variables
+> std::tuple<
+	detail::reduction_result<Operation, Variables>...
+> reduce(
+	const std::size_t number_of_threads,
+	const Iterator begin,
+	const Iterator end,
+	const Operation& operation,
+	const Variables&... variables
+) {
+	using Result_T = std::tuple<detail::reduction_result<Operation, Variables>...>;
+
+	const std::size_t
+		number_of_cells = std::size_t(std::distance(begin, end)),
+		number_of_parts = std::max<std::size_t>(
+			1,
+			std::min(number_of_cells, number_of_threads)
+		);
+	if (number_of_parts <= 1) {
+		return detail::reduce_range(begin, end, operation, variables...);
+	}
+
+	std::vector<Result_T> partial_results(number_of_parts);
+	std::vector<std::thread> threads;
+	threads.reserve(number_of_parts - 1);
+
+	auto part_begin = begin;
+	for (std::size_t part = 0; part < number_of_parts; part++) {
+		auto part_end = part_begin;
+		std::advance(
+			part_end,
+			number_of_cells / number_of_parts
+				+ (part < number_of_cells % number_of_parts ? 1 : 0)
+		);
+
+		// reduce last part in calling thread
+		if (part == number_of_parts - 1) {
+			partial_results[part] = detail::reduce_range(
+				part_begin, part_end, operation, variables...
+			);
+		} else {
+			threads.emplace_back(
+				[&partial_results, part, part_begin, part_end, &operation](){
+					partial_results[part] = detail::reduce_range(
+						part_begin, part_end, operation, Variables()...
+					);
+				}
+			);
+		}
+
+		part_begin = part_end;
+	}
+
+	for (auto& thread: threads) {
+		thread.join();
+	}
+
+	Result_T result = partial_results[0];
+	for (std::size_t part = 1; part < partial_results.size(); part++) {
+		detail::combine_tuple<0, Operation>(result, partial_results[part]);
+	}
+
+	return result;
+}
+
+
+#if defined(MPI_VERSION) && (MPI_VERSION >= 2)
+
+namespace detail {
+
+//! MPI_User_function combining tuples of results with Operation.
+template<class Operation, class Result_T> void combine_mpi(
+	void* const in,
+	void* const inout,
+	int* const count,
+	MPI_Datatype*
+) {
+	const Result_T* const others = static_cast<const Result_T*>(in);
+	Result_T* const results = static_cast<Result_T*>(inout);
+	for (int i = 0; i < *count; i++) {
+		combine_tuple<0, Operation>(results[i], others[i]);
+	}
+}
+
+
+/*!
+Combines given results from all processes of given communicator.
+
+All variables are reduced in a single MPI_Allreduce using a
+datatype of the whole tuple. Aborts if an MPI call fails.
+*/
+template<
+	class Operation,
+	class Result_T
+> Result_T all_reduce_results(
+	const Result_T& local_result,
+	MPI_Comm comm
+) {
+	MPI_Datatype datatype = MPI_DATATYPE_NULL;
+	if (
+		MPI_Type_contiguous(sizeof(Result_T), MPI_BYTE, &datatype) != MPI_SUCCESS
+		or MPI_Type_commit(&datatype) != MPI_SUCCESS
+	) {
+		std::cerr << __FILE__ << ":" << __LINE__
+			<< " Couldn't create datatype for reduction"
+			<< std::endl;
+		abort();
+	}
+
+	MPI_Op op = MPI_OP_NULL;
+	if (MPI_Op_create(&combine_mpi<Operation, Result_T>, 1, &op) != MPI_SUCCESS) {
+		std::cerr << __FILE__ << ":" << __LINE__
+			<< " Couldn't create operation for reduction"
+			<< std::endl;
+		abort();
+	}
+
+	Result_T result(local_result);
+	if (
+		MPI_Allreduce(
+			const_cast<Result_T*>(&local_result),
+			&result,
+			1,
+			datatype,
+			op,
+			comm
+		) != MPI_SUCCESS
+	) {
+		std::cerr << __FILE__ << ":" << __LINE__
+			<< " Couldn't reduce variables"
+			<< std::endl;
+		abort();
+	}
+
+	MPI_Op_free(&op);
+	MPI_Type_free(&datatype);
+
+	return result;
+}
+
+} // namespace detail
+
+
+/*!
+Same as reduce() but also over cells of all processes in given communicator.
+
+Must be called by all processes of the communicator with
+the same operation and variables. All variables are combined
+between processes with a single collective so reducing e.g.
+several diagnostics of a step costs one MPI_Allreduce.
+*/
+template<
+	class Iterator,
+	class Operation,
+	class... Variables
+> std::tuple<
+	detail::reduction_result<Operation, Variables>...
+> all_reduce(
+	MPI_Comm comm,
+	const Iterator begin,
+	const Iterator end,
+	const Operation& operation,
+	const Variables&... variables
+) {
+	return detail::all_reduce_results<Operation>(
+		gensimcell::reduce(begin, end, operation, variables...),
+		comm
+	);
+}
+
+//! Same as the other all_reduce() but uses given number of threads.
+template<
+	class Iterator,
+	class Operation,
+	class... Variables
+> std::tuple<
+	detail::reduction_result<Operation, Variables>...
+> all_reduce(
+	MPI_Comm comm,
+	const std::size_t number_of_threads,
+	const Iterator begin,
+	const Iterator end,
+	const Operation& operation,
+	const Variables&... variables
+) {
+	return detail::all_reduce_results<Operation>(
+		gensimcell::reduce(number_of_threads, begin, end, operation, variables...),
+		comm
+	);
+}
+
+#endif // ifdef MPI_VERSION
+
+
+} // namespace gensimcell
+
+#endif // ifndef GENSIMCELL_REDUCE_HPP
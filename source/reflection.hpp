@@ -0,0 +1,171 @@
+/*
+Compile time information about variables of generic simulation cells.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef GENSIMCELL_REFLECTION_HPP
+#define GENSIMCELL_REFLECTION_HPP
+
+
+#include "cstddef"
+#include "type_traits"
+
+#include "cold_storage.hpp"
+
+
+namespace gensimcell {
+namespace detail {
+
+/*!
+index_of::value is the index of Variable among Variables.
+
+Fails to compile if Variable isn't in Variables.
+*/
+template <class Variable, class... Variables> struct index_of;
+
+template <
+	class Variable,
+	class... Rest_Of_Variables
+> struct index_of<Variable, Variable, Rest_Of_Variables...> :
+	std::integral_constant<std::size_t, 0>
+{};
+
+template <
+	class Variable,
+	class First_Variable,
+	class... Rest_Of_Variables
+> struct index_of<Variable, First_Variable, Rest_Of_Variables...> :
+	std::integral_constant<
+		std::size_t,
+		1 + index_of<Variable, Rest_Of_Variables...>::value
+	>
+{};
+
+
+//! variable_at::type is the variable at Index in Variables.
+template <std::size_t Index, class... Variables> struct variable_at;
+
+template <
+	class First_Variable,
+	class... Rest_Of_Variables
+> struct variable_at<0, First_Variable, Rest_Of_Variables...> {
+	using type = First_Variable;
+};
+
+template <
+	std::size_t Index,
+	class First_Variable,
+	class... Rest_Of_Variables
+> struct variable_at<Index, First_Variable, Rest_Of_Variables...> {
+	using type = typename variable_at<Index - 1, Rest_Of_Variables...>::type;
+};
+
+} // namespace detail
+
+
+// forward declare Cell type used in for_each_variable
+template<template<class> class Transfer_Policy, class... Variables> class Cell;
+
+
+/*!
+Calls given function with each variable of given cell and its data.
+
+Variables are given in the same order as in the cell's template
+arguments, as default constructed instances, and the call for
+each variable V is f(V(), cell[V()]). Works e.g. with a lambda
+with auto parameters in C++14 or with a function object with
+templated operator() in C++11:
+@code
+struct Printer {
+	template<class Variable, class Data> void operator()(
+		const Variable&,
+		const Data& data
+	) const {
+		std::cout << gensimcell::get_variable_name<Variable>()
+			<< ": " << data << std::endl;
+	}
+};
+gensimcell::for_each_variable(cell, Printer());
+@endcode
+Returns given function.
+*/
+template<
+	template<class> class Transfer_Policy,
+	class... Variables,
+	class Function
+> Function for_each_variable(
+	Cell<Transfer_Policy, Variables...>& cell,
+	Function f
+) {
+	// elements of a braced list are evaluated in order
+	const int in_order[] = {
+		0,
+		(
+			void(f(
+				typename detail::get_variable<Variables>::type(),
+				cell[typename detail::get_variable<Variables>::type()]
+			)),
+			0
+		)...
+	};
+	(void) in_order;
+	return f;
+}
+
+//! Const version of for_each_variable.
+template<
+	template<class> class Transfer_Policy,
+	class... Variables,
+	class Function
+> Function for_each_variable(
+	const Cell<Transfer_Policy, Variables...>& cell,
+	Function f
+) {
+	// elements of a braced list are evaluated in order
+	const int in_order[] = {
+		0,
+		(
+			void(f(
+				typename detail::get_variable<Variables>::type(),
+				cell[typename detail::get_variable<Variables>::type()]
+			)),
+			0
+		)...
+	};
+	(void) in_order;
+	return f;
+}
+
+
+} // namespace gensimcell
+
+
+#endif // ifndef GENSIMCELL_REFLECTION_HPP
@@ -0,0 +1,245 @@
+/*
+Ordering of cells along space-filling curves.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+*/
+
+#ifndef GENSIMCELL_SPACE_FILLING_CURVE_HPP
+#define GENSIMCELL_SPACE_FILLING_CURVE_HPP
+
+
+#include "algorithm"
+#include "array"
+#include "cstddef"
+#include "cstdint"
+#include "type_traits"
+#include "utility"
+#include "vector"
+
+
+namespace gensimcell {
+
+
+//! Space-filling curves supported by get_curve_order().
+enum class Curve {
+	//! Z-order, interleaved bits of indices
+	morton,
+	//! consecutive cells are always face neighbors
+	hilbert
+};
+
+
+namespace detail {
+
+//! Returns the number of bits needed to represent given value.
+inline std::size_t get_bits(std::uint64_t value)
+{
+	std::size_t bits = 0;
+	while (value > 0) {
+		bits++;
+		value >>= 1;
+	}
+	return bits;
+}
+
+
+/*!
+Returns position along given curve of given indices
+of which bits lowest bits are used.
+
+Hilbert curve is from J. Skilling, Programming the Hilbert
+curve, AIP Conf. Proc. 707, 381 (2004).
+*/
+template<std::size_t Dimensions> std::uint64_t get_curve_key(
+	std::array<std::uint64_t, Dimensions> indices,
+	const std::size_t bits,
+	const Curve curve
+) {
+	static_assert(Dimensions > 0, "At least one dimension required");
+
+	if (bits == 0) {
+		return 0;
+	}
+
+	if (curve == Curve::hilbert) {
+		const std::uint64_t most_significant = std::uint64_t(1) << (bits - 1);
+
+		// inverse undo
+		for (std::uint64_t q = most_significant; q > 1; q >>= 1) {
+			const std::uint64_t p = q - 1;
+			for (std::size_t i = 0; i < Dimensions; i++) {
+				if ((indices[i] & q) > 0) {
+					indices[0] ^= p;
+				} else {
+					const std::uint64_t t = (indices[0] ^ indices[i]) & p;
+					indices[0] ^= t;
+					indices[i] ^= t;
+				}
+			}
+		}
+
+		// Gray encode
+		for (std::size_t i = 1; i < Dimensions; i++) {
+			indices[i] ^= indices[i - 1];
+		}
+		std::uint64_t t = 0;
+		for (std::uint64_t q = most_significant; q > 1; q >>= 1) {
+			if ((indices[Dimensions - 1] & q) > 0) {
+				t ^= q - 1;
+			}
+		}
+		for (auto& index: indices) {
+			index ^= t;
+		}
+	}
+
+	// interleave bits, first dimension least significant for morton
+	std::uint64_t key = 0;
+	for (std::size_t bit = bits; bit > 0; bit--) {
+		for (std::size_t i = 0; i < Dimensions; i++) {
+			const std::size_t dimension
+				= (curve == Curve::hilbert ? i : Dimensions - 1 - i);
+			key = (key << 1) | ((indices[dimension] >> (bit - 1)) & 1);
+		}
+	}
+
+	return key;
+}
+
+} // namespace detail
+
+
+/*!
+Returns the order of given cell indices along given curve.
+
+Returned vector has the position in given indices of the
+first cell along the curve, then the second and so on.
+Indices are integer coordinates of cells, e.g. from
+dccrg's mapping.get_indices(). If they don't fit into
+64 bits when interleaved their lowest bits are ignored
+in which case nearby cells are in arbitrary order.
+*/
+template<
+	class Integer_T,
+	std::size_t Dimensions
+> std::vector<std::size_t> get_curve_order(
+	const std::vector<std::array<Integer_T, Dimensions>>& indices,
+	const Curve curve = Curve::hilbert
+) {
+	std::uint64_t max_index = 0;
+	for (const auto& index: indices) {
+		for (const auto i: index) {
+			max_index = std::max(max_index, std::uint64_t(i));
+		}
+	}
+
+	const std::size_t
+		bits = detail::get_bits(max_index),
+		max_bits = 64 / Dimensions,
+		shift = (bits > max_bits ? bits - max_bits : 0);
+
+	std::vector<std::pair<std::uint64_t, std::size_t>> keys;
+	keys.reserve(indices.size());
+	for (std::size_t i = 0; i < indices.size(); i++) {
+		std::array<std::uint64_t, Dimensions> shifted;
+		for (std::size_t d = 0; d < Dimensions; d++) {
+			shifted[d] = std::uint64_t(indices[i][d]) >> shift;
+		}
+		keys.emplace_back(
+			detail::get_curve_key(shifted, bits - shift, curve),
+			i
+		);
+	}
+	std::sort(keys.begin(), keys.end());
+
+	std::vector<std::size_t> order;
+	order.reserve(keys.size());
+	for (const auto& key: keys) {
+		order.push_back(key.second);
+	}
+	return order;
+}
+
+
+/*!
+Reorders given items into given order from e.g. get_curve_order().
+
+Can be used to relocate cells stored in a vector so that
+cells close to each other along a curve are also close in
+memory, references to items are invalidated.
+*/
+template<class Item_T, class Allocator_T> void apply_order(
+	std::vector<Item_T, Allocator_T>& items,
+	const std::vector<std::size_t>& order
+) {
+	std::vector<Item_T, Allocator_T> ordered(items.get_allocator());
+	ordered.reserve(items.size());
+	for (const auto i: order) {
+		ordered.push_back(std::move(items[i]));
+	}
+	items.swap(ordered);
+}
+
+
+/*!
+Returns given items, e.g. ids of cells, sorted along given curve.
+
+get_indices(item) must return std::array of integer indices
+of item. For example local cells of a dccrg grid can be
+solved in Hilbert order with:
+@code
+const auto cells = gensimcell::sort_along_curve(
+	grid.get_local_cells_not_on_process_boundary(),
+	[&grid](const uint64_t cell) { return grid.mapping.get_indices(cell); }
+);
+@endcode
+*/
+template<class Item_T, class Get_Indices> std::vector<Item_T> sort_along_curve(
+	std::vector<Item_T> items,
+	Get_Indices get_indices,
+	const Curve curve = Curve::hilbert
+) {
+	std::vector<
+		typename std::decay<decltype(get_indices(items.front()))>::type
+	> indices;
+	indices.reserve(items.size());
+	for (const auto& item: items) {
+		indices.push_back(get_indices(item));
+	}
+
+	apply_order(items, get_curve_order(indices, curve));
+	return items;
+}
+
+
+} // namespace gensimcell
+
+#endif // ifndef GENSIMCELL_SPACE_FILLING_CURVE_HPP
@@ -0,0 +1,263 @@
+/*
+Exchange of data between processes that don't know who sends to them.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+mpi.h must be included prior to including this file.
+*/
+
+#ifndef GENSIMCELL_SPARSE_EXCHANGE_HPP
+#define GENSIMCELL_SPARSE_EXCHANGE_HPP
+
+#if defined(MPI_VERSION) && (MPI_VERSION >= 3)
+
+#include "cstddef"
+#include "limits"
+#include "type_traits"
+#include "utility"
+#include "vector"
+
+
+namespace gensimcell {
+
+
+/*!
+Sends items to processes chosen by the sender each of which
+receives them without knowing beforehand who sends to it.
+
+Uses the nonblocking consensus algorithm (NBX) of Hoefler et al.,
+Scalable communication protocols for dynamic sparse data exchange,
+PPoPP 2010: each process sends its messages with MPI_Issend and
+receives any messages that arrive until all of its messages have
+been received after which it enters an MPI_Ibarrier, an exchange
+is complete when the barrier is. Only processes that have items
+for each other exchange messages, so there are no empty messages
+e.g. to neighbors without anything to send.
+
+Items are sent as bytes so they must be trivially copyable
+and processes must have the same representation of them.
+
+Example:
+@code
+gensimcell::Sparse_Exchange<Particle> exchange;
+for (const auto& particle: leaving_particles) {
+	exchange.get_send_items(owner(particle)).push_back(particle);
+}
+exchange.exchange(
+	comm,
+	[&](const int sender, const std::vector<Particle>& particles) {
+		...
+	}
+);
+@endcode
+*/
+template<class Item_T> class Sparse_Exchange
+{
+	static_assert(
+		std::is_trivially_copyable<Item_T>::value,
+		"Items must be trivially copyable"
+	);
+
+public:
+
+	/*!
+	Returns items sent to given process by next exchange().
+
+	Items are cleared by exchange(), memory is retained.
+	*/
+	std::vector<Item_T>& get_send_items(const int process)
+	{
+		for (auto& send: this->sends) {
+			if (send.first == process) {
+				return send.second;
+			}
+		}
+		this->sends.emplace_back(process, std::vector<Item_T>());
+		return this->sends.back().second;
+	}
+
+
+	/*!
+	Sends items given to get_send_items() and calls
+	receive(sender, items) for each received message.
+
+	Must be called by all processes of given communicator.
+	Uses given tag and tag + 1 on alternate exchanges which
+	must not be used by other messages of given communicator
+	during an exchange. Returns true on success and false if
+	a message was too large or an MPI function failed.
+	*/
+	template<class Receive_T> bool exchange(
+		MPI_Comm comm,
+		Receive_T receive,
+		const int tag = 0
+	) {
+		// a process can start next exchange before others finish this one
+		const int current_tag = tag + int(this->exchanges % 2);
+		this->exchanges++;
+		this->sent_messages = 0;
+		this->received_messages = 0;
+
+		bool success = true;
+
+		this->requests.clear();
+		for (const auto& send: this->sends) {
+			if (send.second.size() == 0) {
+				continue;
+			}
+			if (
+				send.second.size()
+				> size_t(std::numeric_limits<int>::max()) / sizeof(Item_T)
+			) {
+				success = false;
+				continue;
+			}
+
+			this->requests.push_back(MPI_REQUEST_NULL);
+			if (
+				MPI_Issend(
+					send.second.data(),
+					int(send.second.size() * sizeof(Item_T)),
+					MPI_BYTE,
+					send.first,
+					current_tag,
+					comm,
+					&this->requests.back()
+				) != MPI_SUCCESS
+			) {
+				return false;
+			}
+			this->sent_messages++;
+		}
+
+		bool barrier_started = false;
+		MPI_Request barrier = MPI_REQUEST_NULL;
+		while (true) {
+			int arrived = 0;
+			MPI_Status status;
+			if (
+				MPI_Iprobe(MPI_ANY_SOURCE, current_tag, comm, &arrived, &status)
+				!= MPI_SUCCESS
+			) {
+				return false;
+			}
+
+			if (arrived != 0) {
+				int bytes = -1;
+				MPI_Get_count(&status, MPI_BYTE, &bytes);
+				this->received.resize(size_t(bytes) / sizeof(Item_T));
+				if (
+					MPI_Recv(
+						this->received.data(),
+						bytes,
+						MPI_BYTE,
+						status.MPI_SOURCE,
+						current_tag,
+						comm,
+						MPI_STATUS_IGNORE
+					) != MPI_SUCCESS
+				) {
+					return false;
+				}
+				this->received_messages++;
+
+				const auto& items = this->received;
+				receive(status.MPI_SOURCE, items);
+			}
+
+			int done = 0;
+			if (barrier_started) {
+				if (MPI_Test(&barrier, &done, MPI_STATUS_IGNORE) != MPI_SUCCESS) {
+					return false;
+				}
+				if (done != 0) {
+					break;
+				}
+			} else {
+				// synchronous sends complete once received
+				if (
+					MPI_Testall(
+						int(this->requests.size()),
+						this->requests.data(),
+						&done,
+						MPI_STATUSES_IGNORE
+					) != MPI_SUCCESS
+				) {
+					return false;
+				}
+				if (done != 0) {
+					if (MPI_Ibarrier(comm, &barrier) != MPI_SUCCESS) {
+						return false;
+					}
+					barrier_started = true;
+				}
+			}
+		}
+
+		for (auto& send: this->sends) {
+			send.second.clear();
+		}
+
+		return success;
+	}
+
+
+	//! Returns the number of messages sent by latest exchange().
+	size_t get_sent_messages() const
+	{
+		return this->sent_messages;
+	}
+
+	//! Returns the number of messages received by latest exchange().
+	size_t get_received_messages() const
+	{
+		return this->received_messages;
+	}
+
+
+private:
+
+	std::vector<std::pair<int, std::vector<Item_T>>> sends;
+	std::vector<MPI_Request> requests;
+	std::vector<Item_T> received;
+
+	size_t
+		exchanges = 0,
+		sent_messages = 0,
+		received_messages = 0;
+};
+
+
+} // namespace gensimcell
+
+#endif // if defined(MPI_VERSION) && (MPI_VERSION >= 3)
+
+#endif // ifndef GENSIMCELL_SPARSE_EXCHANGE_HPP
@@ -0,0 +1,379 @@
+/*
+Optional statistics of variables included in MPI transfers of cells.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+Statistics are gathered only if GENSIMCELL_STATISTICS is defined
+before including gensimcell.hpp, in which case every call to a
+cell's get_mpi_datatype() records for each variable whether it
+was included in the returned datatype, how many bytes it contributed
+and how long creating its datatype took. Statistics are kept per
+variable type and per process, and GENSIMCELL_STATISTICS must be
+defined identically in all translation units of a program.
+
+Example:
+@code
+#define GENSIMCELL_STATISTICS
+#include "mpi.h"
+#include "gensimcell.hpp"
+...
+gensimcell::report_statistics(std::cout, MPI_COMM_WORLD);
+@endcode
+*/
+
+#ifndef GENSIMCELL_STATISTICS_HPP
+#define GENSIMCELL_STATISTICS_HPP
+
+#if defined(MPI_VERSION) && (MPI_VERSION >= 2) && defined(GENSIMCELL_STATISTICS)
+
+#include "algorithm"
+#include "chrono"
+#include "cstdint"
+#include "iomanip"
+#include "map"
+#include "ostream"
+#include "string"
+#include "utility"
+#include "vector"
+
+#include "type_support.hpp"
+
+
+namespace gensimcell {
+
+
+//! Statistics of one variable of cells.
+struct Variable_Statistics
+{
+	//! number of times the variable was included in a cell's MPI datatype
+	uint64_t inclusions = 0;
+	//! number of times the variable was excluded from a cell's MPI datatype
+	uint64_t exclusions = 0;
+	//! total number of bytes the variable contributed to cells' MPI datatypes
+	uint64_t bytes = 0;
+	//! total time spent creating the variable's MPI datatype in seconds
+	double construction_time = 0;
+};
+
+
+namespace detail {
+
+
+//! Returns names and statistics of all variables recorded so far.
+inline std::vector<std::pair<std::string, Variable_Statistics*>>& get_statistics_registry()
+{
+	static std::vector<std::pair<std::string, Variable_Statistics*>> registry;
+	return registry;
+}
+
+
+//! Returns statistics of given variable, registering them on first call.
+template<class Variable> Variable_Statistics& get_variable_statistics()
+{
+	static Variable_Statistics statistics;
+	static const bool registered = (
+		get_statistics_registry().emplace_back(
+			get_variable_name<Variable>(),
+			&statistics
+		),
+		true
+	);
+	(void) registered;
+
+	return statistics;
+}
+
+
+//! Records that given variable was excluded from a cell's datatype.
+template<class Variable> void record_exclusion()
+{
+	get_variable_statistics<Variable>().exclusions++;
+}
+
+
+/*!
+Records that given variable was included into a cell's
+datatype with given transfer info whose construction
+started at given time.
+*/
+template<class Variable> void record_inclusion(
+	const int count,
+	const MPI_Datatype datatype,
+	const std::chrono::steady_clock::time_point& start
+) {
+	const auto end = std::chrono::steady_clock::now();
+
+	auto& statistics = get_variable_statistics<Variable>();
+	statistics.inclusions++;
+	statistics.construction_time
+		+= std::chrono::duration<double>(end - start).count();
+
+	if (count > 0 and datatype != MPI_DATATYPE_NULL) {
+		int datatype_size = 0;
+		MPI_Type_size(datatype, &datatype_size);
+		if (datatype_size > 0) {
+			statistics.bytes += uint64_t(count) * uint64_t(datatype_size);
+		}
+	}
+}
+
+
+} // namespace detail
+
+
+/*!
+Returns statistics of all variables recorded so far by this process.
+
+Variables are identified by their get_variable_name().
+*/
+inline std::map<std::string, Variable_Statistics> get_statistics()
+{
+	std::map<std::string, Variable_Statistics> statistics;
+	for (const auto& item: detail::get_statistics_registry()) {
+		statistics[item.first] = *item.second;
+	}
+	return statistics;
+}
+
+
+//! Sets statistics of all variables to zero.
+inline void reset_statistics()
+{
+	for (auto& item: detail::get_statistics_registry()) {
+		*item.second = Variable_Statistics();
+	}
+}
+
+
+/*!
+Writes statistics of all processes into given stream.
+
+Statistics of each process are written followed by
+the sum of statistics over all processes.
+Only process 0 writes into given stream.
+
+Must be called by all processes of given communicator.
+*/
+inline void report_statistics(std::ostream& out, MPI_Comm comm)
+{
+	int rank = -1, comm_size = -1;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &comm_size);
+
+	const auto local_statistics = get_statistics();
+
+	/*
+	Processes can have recorded different variables
+	so gather names from all processes to process 0
+	*/
+	std::string local_names;
+	for (const auto& item: local_statistics) {
+		local_names += item.first + '\n';
+	}
+
+	int local_length = int(local_names.size());
+	std::vector<int> lengths(size_t(comm_size), 0), displacements(size_t(comm_size), 0);
+	MPI_Gather(&local_length, 1, MPI_INT, lengths.data(), 1, MPI_INT, 0, comm);
+
+	int total_length = 0;
+	for (size_t i = 0; i < lengths.size(); i++) {
+		displacements[i] = total_length;
+		total_length += lengths[i];
+	}
+
+	std::vector<char> all_names(size_t(std::max(total_length, 1)), '\0');
+	MPI_Gatherv(
+		const_cast<char*>(local_names.data()),
+		local_length,
+		MPI_CHAR,
+		all_names.data(),
+		lengths.data(),
+		displacements.data(),
+		MPI_CHAR,
+		0,
+		comm
+	);
+
+	const auto split_names = [&all_names, &total_length]() {
+		std::vector<std::string> result;
+		std::string name;
+		for (int i = 0; i < total_length; i++) {
+			if (all_names[size_t(i)] == '\n') {
+				result.push_back(name);
+				name.clear();
+			} else {
+				name += all_names[size_t(i)];
+			}
+		}
+		return result;
+	};
+
+	// sorted union of names of all processes
+	std::vector<std::string> names;
+	if (rank == 0) {
+		names = split_names();
+		std::sort(names.begin(), names.end());
+		names.erase(std::unique(names.begin(), names.end()), names.end());
+
+		total_length = 0;
+		for (const auto& item: names) {
+			total_length += int(item.size()) + 1;
+		}
+		all_names.resize(size_t(std::max(total_length, 1)));
+		size_t offset = 0;
+		for (const auto& item: names) {
+			std::copy(item.cbegin(), item.cend(), all_names.begin() + offset);
+			offset += item.size();
+			all_names[offset++] = '\n';
+		}
+	}
+
+	MPI_Bcast(&total_length, 1, MPI_INT, 0, comm);
+	all_names.resize(size_t(std::max(total_length, 1)));
+	MPI_Bcast(all_names.data(), total_length, MPI_CHAR, 0, comm);
+
+	if (rank != 0) {
+		names = split_names();
+	}
+
+	/*
+	Gather statistics of all processes in the order of names
+	*/
+	const size_t number_of_names = names.size();
+	std::vector<uint64_t> local_counts(3 * number_of_names, 0);
+	std::vector<double> local_times(number_of_names, 0);
+	for (size_t i = 0; i < number_of_names; i++) {
+		const auto iter = local_statistics.find(names[i]);
+		if (iter == local_statistics.cend()) {
+			continue;
+		}
+		local_counts[3 * i + 0] = iter->second.inclusions;
+		local_counts[3 * i + 1] = iter->second.exclusions;
+		local_counts[3 * i + 2] = iter->second.bytes;
+		local_times[i] = iter->second.construction_time;
+	}
+
+	std::vector<uint64_t> all_counts, total_counts;
+	std::vector<double> all_times, total_times;
+	if (rank == 0) {
+		all_counts.resize(local_counts.size() * size_t(comm_size));
+		all_times.resize(local_times.size() * size_t(comm_size));
+		total_counts.resize(local_counts.size());
+		total_times.resize(local_times.size());
+	}
+
+	if (number_of_names > 0) {
+		MPI_Gather(
+			local_counts.data(), int(local_counts.size()), MPI_UINT64_T,
+			all_counts.data(), int(local_counts.size()), MPI_UINT64_T,
+			0, comm
+		);
+		MPI_Gather(
+			local_times.data(), int(local_times.size()), MPI_DOUBLE,
+			all_times.data(), int(local_times.size()), MPI_DOUBLE,
+			0, comm
+		);
+		MPI_Reduce(
+			local_counts.data(), total_counts.data(), int(local_counts.size()),
+			MPI_UINT64_T, MPI_SUM, 0, comm
+		);
+		MPI_Reduce(
+			local_times.data(), total_times.data(), int(local_times.size()),
+			MPI_DOUBLE, MPI_SUM, 0, comm
+		);
+	}
+
+	if (rank != 0) {
+		return;
+	}
+
+	const auto write_line = [&out](
+		const std::string& process,
+		const std::string& name,
+		const uint64_t inclusions,
+		const uint64_t exclusions,
+		const uint64_t bytes,
+		const double time
+	) {
+		out << std::setw(8) << process << " "
+			<< std::setw(12) << inclusions << " "
+			<< std::setw(12) << exclusions << " "
+			<< std::setw(14) << bytes << " "
+			<< std::setw(12) << std::scientific << std::setprecision(3) << time << " "
+			<< name << "\n";
+	};
+
+	const auto original_flags = out.flags();
+	const auto original_precision = out.precision();
+
+	out << std::setw(8) << "process" << " "
+		<< std::setw(12) << "included" << " "
+		<< std::setw(12) << "excluded" << " "
+		<< std::setw(14) << "bytes" << " "
+		<< std::setw(12) << "time (s)" << " "
+		<< "variable\n";
+
+	for (size_t process = 0; process < size_t(comm_size); process++) {
+		for (size_t i = 0; i < number_of_names; i++) {
+			const size_t count_i = process * 3 * number_of_names + 3 * i;
+			write_line(
+				std::to_string(process),
+				names[i],
+				all_counts[count_i + 0],
+				all_counts[count_i + 1],
+				all_counts[count_i + 2],
+				all_times[process * number_of_names + i]
+			);
+		}
+	}
+
+	for (size_t i = 0; i < number_of_names; i++) {
+		write_line(
+			"total",
+			names[i],
+			total_counts[3 * i + 0],
+			total_counts[3 * i + 1],
+			total_counts[3 * i + 2],
+			total_times[i]
+		);
+	}
+
+	out.flags(original_flags);
+	out.precision(original_precision);
+	out << std::flush;
+}
+
+
+} // namespace gensimcell
+
+#endif // ifdef GENSIMCELL_STATISTICS
+
+#endif // ifndef GENSIMCELL_STATISTICS_HPP
@@ -0,0 +1,636 @@
+/*
+Cartesian grid of cells with ghost layers.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+*/
+
+#ifndef GENSIMCELL_STRUCTURED_GRID_HPP
+#define GENSIMCELL_STRUCTURED_GRID_HPP
+
+
+#include "algorithm"
+#include "array"
+#include "atomic"
+#include "cassert"
+#include "cstddef"
+#include "initializer_list"
+#include "memory"
+#include "thread"
+#include "vector"
+
+
+namespace gensimcell {
+
+
+/*!
+Cartesian grid of Cell_T with Dimensions dimensions.
+
+Interior cells have indices from 0 to size - 1 in each
+dimension and they're surrounded by ghost_width layers of
+ghost cells with indices from -ghost_width to -1 and from
+size to size + ghost_width - 1. All cells are stored in one
+contiguous vector, first dimension changing fastest, so
+neighbors of any cell are at constant offsets in storage.
+
+Periodic boundaries are implemented by copying interior
+cells to ghost cells with fill_periodic() after which
+solvers can access neighbors of interior cells without
+wrapping indices or checking for boundaries:
+@code
+gensimcell::Structured_Grid<Cell_T, 2> grid({{width, height}}, 1);
+...
+grid.fill_periodic(Is_Alive());
+const auto offsets = grid.get_offsets<2>({{ {{-1, 0}}, {{1, 0}} }});
+grid.for_each_cell(
+	offsets,
+	[](Cell_T& cell, const std::array<Cell_T*, 2>& neighbors, const Index_T&) {
+		for (const auto* neighbor: neighbors) {
+			cell[Live_Neighbors()] += (*neighbor)[Is_Alive()];
+		}
+	}
+);
+@endcode
+*/
+template <
+	class Cell_T,
+	std::size_t Dimensions,
+	class Allocator_T = std::allocator<Cell_T>
+> class Structured_Grid
+{
+	static_assert(Dimensions > 0, "Grid must have at least one dimension");
+
+public:
+
+	using cell_type = Cell_T;
+	//! Number of interior cells in each dimension.
+	using Size_T = std::array<std::size_t, Dimensions>;
+	//! Index of a cell, negative for ghost cells before interior cells.
+	using Index_T = std::array<std::ptrdiff_t, Dimensions>;
+
+	static constexpr std::size_t dimensions = Dimensions;
+
+
+	Structured_Grid() = default;
+
+	/*!
+	Creates a grid of default constructed cells with given
+	number of interior cells and ghost layers in each dimension.
+	*/
+	Structured_Grid(const Size_T& given_size, const std::size_t given_ghost_width = 1)
+	{
+		this->resize(given_size, given_ghost_width);
+	}
+
+
+	/*!
+	Replaces all cells with default constructed ones
+	in a grid of given size and ghost width.
+	*/
+	void resize(const Size_T& given_size, const std::size_t given_ghost_width = 1)
+	{
+		this->size = given_size;
+		this->ghost_width = given_ghost_width;
+
+		std::size_t total = 1;
+		this->origin = 0;
+		for (std::size_t d = 0; d < Dimensions; d++) {
+			this->strides[d] = std::ptrdiff_t(total);
+			total *= this->size[d] + 2 * this->ghost_width;
+			this->origin += std::ptrdiff_t(this->ghost_width) * this->strides[d];
+		}
+
+		this->cells.clear();
+		this->cells.resize(total);
+	}
+
+
+	const Size_T& get_size() const
+	{
+		return this->size;
+	}
+
+	std::size_t get_ghost_width() const
+	{
+		return this->ghost_width;
+	}
+
+	//! Returns offsets in storage between consecutive cells in each dimension.
+	const Index_T& get_strides() const
+	{
+		return this->strides;
+	}
+
+	//! Returns number of interior cells.
+	std::size_t get_number_of_cells() const
+	{
+		std::size_t number = 1;
+		for (const auto s: this->size) {
+			number *= s;
+		}
+		return number;
+	}
+
+
+	//! Storage of all cells including ghost cells.
+	Cell_T* data()
+	{
+		return this->cells.data();
+	}
+
+	const Cell_T* data() const
+	{
+		return this->cells.data();
+	}
+
+	std::size_t get_storage_size() const
+	{
+		return this->cells.size();
+	}
+
+
+	//! Returns offset in storage of cell at given index.
+	std::ptrdiff_t get_offset(const Index_T& index) const
+	{
+		std::ptrdiff_t offset = this->origin;
+		for (std::size_t d = 0; d < Dimensions; d++) {
+			offset += index[d] * this->strides[d];
+		}
+		return offset;
+	}
+
+	//! Returns offset in storage from any cell to its neighbor in given direction.
+	std::ptrdiff_t get_offset_to(const Index_T& direction) const
+	{
+		std::ptrdiff_t offset = 0;
+		for (std::size_t d = 0; d < Dimensions; d++) {
+			offset += direction[d] * this->strides[d];
+		}
+		return offset;
+	}
+
+	//! Returns offsets in storage from any cell to its neighbors in given directions.
+	template<std::size_t N> std::array<std::ptrdiff_t, N> get_offsets(
+		const std::array<Index_T, N>& directions
+	) const {
+		std::array<std::ptrdiff_t, N> offsets;
+		for (std::size_t i = 0; i < N; i++) {
+			offsets[i] = this->get_offset_to(directions[i]);
+		}
+		return offsets;
+	}
+
+
+	/*!
+	Returns cell at given index which must be
+	within interior or ghost cells.
+	*/
+	Cell_T& operator[](const Index_T& index)
+	{
+		return this->cells[std::size_t(this->get_offset(index))];
+	}
+
+	const Cell_T& operator[](const Index_T& index) const
+	{
+		return this->cells[std::size_t(this->get_offset(index))];
+	}
+
+	/*!
+	Returns interior cell at given index after wrapping
+	it periodically into interior cells.
+
+	Intended for irregular accesses, such as moving particles
+	between cells, outside of loops over all cells.
+	*/
+	Cell_T& get_periodic(Index_T index)
+	{
+		return (*this)[this->wrap(index)];
+	}
+
+	const Cell_T& get_periodic(Index_T index) const
+	{
+		return (*this)[this->wrap(index)];
+	}
+
+
+	/*!
+	Calls f(cell, index) for each interior cell.
+
+	Innermost loop is over first dimension and only
+	increments a pointer.
+	*/
+	template<class Function> void for_each_cell(Function f)
+	{
+		for_each_cell_impl(*this, 0, f);
+	}
+
+	template<class Function> void for_each_cell(Function f) const
+	{
+		for_each_cell_impl(*this, 0, f);
+	}
+
+	/*!
+	Same as for_each_cell(f) but also visits given number of
+	ghost cell layers around interior cells.
+
+	Allows e.g. stepping a solver several times after each
+	update of ghost cells by also solving a margin of ghost
+	cells that shrinks by the stencil's width at each step.
+	Margin must not be larger than ghost width.
+	*/
+	template<class Function> void for_each_cell(const std::size_t margin, Function f)
+	{
+		assert(margin <= this->ghost_width);
+		for_each_cell_impl(*this, std::ptrdiff_t(margin), f);
+	}
+
+	template<class Function> void for_each_cell(const std::size_t margin, Function f) const
+	{
+		assert(margin <= this->ghost_width);
+		for_each_cell_impl(*this, std::ptrdiff_t(margin), f);
+	}
+
+	/*!
+	Calls f(cell, neighbors, index) for each interior cell where
+	neighbors are pointers to cells at given offsets from cell.
+
+	Offsets are usually from get_offsets() and must not point
+	further than ghost width from interior cells.
+	*/
+	template<std::size_t N, class Function> void for_each_cell(
+		const std::array<std::ptrdiff_t, N>& offsets,
+		Function f
+	) {
+		this->for_each_cell(0, offsets, f);
+	}
+
+	/*!
+	Same as for_each_cell(offsets, f) but also visits given
+	number of ghost cell layers around interior cells.
+
+	Margin plus the reach of offsets, e.g. 1 for nearest
+	neighbors, must not be larger than ghost width.
+	*/
+	template<std::size_t N, class Function> void for_each_cell(
+		const std::size_t margin,
+		const std::array<std::ptrdiff_t, N>& offsets,
+		Function f
+	) {
+		assert(margin + this->get_reach(offsets) <= this->ghost_width);
+		for_each_cell_impl(
+			*this,
+			std::ptrdiff_t(margin),
+			[&offsets, &f](Cell_T& cell, const Index_T& index) {
+				std::array<Cell_T*, N> neighbors;
+				for (std::size_t i = 0; i < N; i++) {
+					neighbors[i] = &cell + offsets[i];
+				}
+				f(cell, neighbors, index);
+			}
+		);
+	}
+
+
+	/*!
+	Same as for_each_cell(f) but visits interior cells one
+	tile of given size at a time.
+
+	Tiles small enough to stay in cache together with their
+	neighbors avoid reloading neighboring rows of large grids
+	from memory. A tile size of 0 in a dimension spans the
+	whole grid in that dimension. With more than one thread
+	tiles are handed out dynamically to given number of
+	std::threads in which case f must be safe to call
+	concurrently for different cells, e.g. if it only
+	modifies the cell it's given.
+	*/
+	template<class Function> void for_each_cell_tiled(
+		const Size_T& tile_size,
+		Function f,
+		const std::size_t number_of_threads = 1
+	) {
+		this->for_each_tile(tile_size, number_of_threads, f);
+	}
+
+	//! Same as for_each_cell_tiled(tile_size, f) with tile size known at compile time.
+	template<std::size_t... Tile_Size, class Function> void for_each_cell_tiled(
+		Function f,
+		const std::size_t number_of_threads = 1
+	) {
+		static_assert(
+			sizeof...(Tile_Size) == Dimensions,
+			"Tile size must be given for each dimension"
+		);
+		this->for_each_tile(Size_T{{Tile_Size...}}, number_of_threads, f);
+	}
+
+	//! Same as for_each_cell(offsets, f) but visits interior cells one tile at a time.
+	template<std::size_t N, class Function> void for_each_cell_tiled(
+		const Size_T& tile_size,
+		const std::array<std::ptrdiff_t, N>& offsets,
+		Function f,
+		const std::size_t number_of_threads = 1
+	) {
+		assert(this->get_reach(offsets) <= this->ghost_width);
+		this->for_each_tile(
+			tile_size,
+			number_of_threads,
+			[&offsets, &f](Cell_T& cell, const Index_T& index) {
+				std::array<Cell_T*, N> neighbors;
+				for (std::size_t i = 0; i < N; i++) {
+					neighbors[i] = &cell + offsets[i];
+				}
+				f(cell, neighbors, index);
+			}
+		);
+	}
+
+
+	/*!
+	Copies interior cells to ghost cells so that grid is periodic
+	in all dimensions.
+
+	If no variables are given whole cells are copied,
+	otherwise only given variables.
+	*/
+	template<class... Variables> void fill_periodic(const Variables&... variables)
+	{
+		if (this->get_number_of_cells() == 0) {
+			return;
+		}
+
+		const std::ptrdiff_t
+			ghosts = std::ptrdiff_t(this->ghost_width),
+			row_length = std::ptrdiff_t(this->size[0]);
+
+		// iterate over rows of first dimension including ghost rows
+		Index_T row;
+		for (auto& r: row) {
+			r = -ghosts;
+		}
+		row[0] = 0;
+
+		do {
+			bool interior_row = true;
+			for (std::size_t d = 1; d < Dimensions; d++) {
+				if (row[d] < 0 or row[d] >= std::ptrdiff_t(this->size[d])) {
+					interior_row = false;
+				}
+			}
+
+			Cell_T* const destination = this->data() + this->get_offset(row);
+			const Cell_T* const source = this->data() + this->get_offset(this->wrap(row));
+
+			for (std::ptrdiff_t i = -ghosts; i < 0; i++) {
+				copy(destination[i], source[this->wrap(i, 0)], variables...);
+			}
+			if (not interior_row) {
+				for (std::ptrdiff_t i = 0; i < row_length; i++) {
+					copy(destination[i], source[i], variables...);
+				}
+			}
+			for (std::ptrdiff_t i = row_length; i < row_length + ghosts; i++) {
+				copy(destination[i], source[this->wrap(i, 0)], variables...);
+			}
+		} while (this->next_row(row, -ghosts, ghosts));
+	}
+
+
+private:
+
+	Size_T size{};
+	std::size_t ghost_width = 0;
+	Index_T strides{};
+	// offset of cell at index 0 in each dimension
+	std::ptrdiff_t origin = 0;
+	std::vector<Cell_T, Allocator_T> cells;
+
+
+	//! Returns given index in dimension wrapped into [0, size).
+	std::ptrdiff_t wrap(const std::ptrdiff_t index, const std::size_t dimension) const
+	{
+		const std::ptrdiff_t length = std::ptrdiff_t(this->size[dimension]);
+		return ((index % length) + length) % length;
+	}
+
+	Index_T wrap(Index_T index) const
+	{
+		for (std::size_t d = 0; d < Dimensions; d++) {
+			index[d] = this->wrap(index[d], d);
+		}
+		return index;
+	}
+
+
+	/*!
+	Returns the largest number of cells in any dimension
+	between any cell and its neighbors at given offsets.
+
+	Offsets are decomposed from the last dimension to the
+	first into the nearest multiple of each stride.
+	*/
+	template<std::size_t N> std::size_t get_reach(
+		const std::array<std::ptrdiff_t, N>& offsets
+	) const {
+		std::size_t reach = 0;
+		for (auto offset: offsets) {
+			for (std::size_t d = Dimensions; d-- > 0;) {
+				const std::ptrdiff_t stride = this->strides[d];
+				if (stride == 0) {
+					continue;
+				}
+
+				std::ptrdiff_t steps = offset / stride;
+				const std::ptrdiff_t rest = offset - steps * stride;
+				if (2 * rest > stride) {
+					steps++;
+				} else if (2 * rest < -stride) {
+					steps--;
+				}
+				offset -= steps * stride;
+
+				reach = std::max(reach, std::size_t(steps < 0 ? -steps : steps));
+			}
+		}
+		return reach;
+	}
+
+
+	/*!
+	Advances given index to the next row of the first dimension
+	with indices from -before to size + after - 1 in other
+	dimensions. Returns false after the last row.
+	*/
+	bool next_row(
+		Index_T& index,
+		const std::ptrdiff_t before,
+		const std::ptrdiff_t after
+	) const {
+		for (std::size_t d = 1; d < Dimensions; d++) {
+			index[d]++;
+			if (index[d] < std::ptrdiff_t(this->size[d]) + after) {
+				return true;
+			}
+			index[d] = before;
+		}
+		return false;
+	}
+
+
+	template<class Grid_T, class Function> static void for_each_cell_impl(
+		Grid_T& grid,
+		const std::ptrdiff_t margin,
+		Function&& f
+	) {
+		if (grid.get_number_of_cells() == 0) {
+			return;
+		}
+
+		const std::ptrdiff_t row_end = std::ptrdiff_t(grid.size[0]) + margin;
+		Index_T index;
+		for (auto& i: index) {
+			i = -margin;
+		}
+		do {
+			index[0] = 0;
+			auto* const row = grid.data() + grid.get_offset(index);
+			for (index[0] = -margin; index[0] < row_end; index[0]++) {
+				f(row[index[0]], index);
+			}
+		} while (grid.next_row(index, -margin, margin));
+	}
+
+
+	//! Calls f(cell, index) for cells with indices in [begin, end).
+	template<class Function> void for_each_cell_in(
+		const Index_T& begin,
+		const Index_T& end,
+		Function& f
+	) {
+		Index_T index = begin;
+		while (true) {
+			index[0] = 0;
+			Cell_T* const row = this->data() + this->get_offset(index);
+			for (index[0] = begin[0]; index[0] < end[0]; index[0]++) {
+				f(row[index[0]], index);
+			}
+
+			std::size_t d = 1;
+			for ( ; d < Dimensions; d++) {
+				index[d]++;
+				if (index[d] < end[d]) {
+					break;
+				}
+				index[d] = begin[d];
+			}
+			if (d == Dimensions) {
+				break;
+			}
+		}
+	}
+
+
+	template<class Function> void for_each_tile(
+		Size_T tile_size,
+		const std::size_t number_of_threads,
+		Function&& f
+	) {
+		if (this->get_number_of_cells() == 0) {
+			return;
+		}
+
+		Size_T tiles;
+		std::size_t number_of_tiles = 1;
+		for (std::size_t d = 0; d < Dimensions; d++) {
+			if (tile_size[d] == 0 or tile_size[d] > this->size[d]) {
+				tile_size[d] = this->size[d];
+			}
+			tiles[d] = (this->size[d] + tile_size[d] - 1) / tile_size[d];
+			number_of_tiles *= tiles[d];
+		}
+
+		std::atomic<std::size_t> next_tile{0};
+		const auto process_tiles = [&]() {
+			for (
+				std::size_t tile = next_tile++;
+				tile < number_of_tiles;
+				tile = next_tile++
+			) {
+				Index_T begin, end;
+				std::size_t remaining = tile;
+				for (std::size_t d = 0; d < Dimensions; d++) {
+					begin[d] = std::ptrdiff_t((remaining % tiles[d]) * tile_size[d]);
+					end[d] = std::min(
+						begin[d] + std::ptrdiff_t(tile_size[d]),
+						std::ptrdiff_t(this->size[d])
+					);
+					remaining /= tiles[d];
+				}
+				this->for_each_cell_in(begin, end, f);
+			}
+		};
+
+		std::vector<std::thread> threads;
+		const std::size_t extra_threads
+			= std::min(number_of_threads, number_of_tiles) > 1
+			? std::min(number_of_threads, number_of_tiles) - 1
+			: 0;
+		threads.reserve(extra_threads);
+		for (std::size_t i = 0; i < extra_threads; i++) {
+			threads.emplace_back(process_tiles);
+		}
+		// calling thread also processes tiles
+		process_tiles();
+		for (auto& thread: threads) {
+			thread.join();
+		}
+	}
+
+
+	static void copy(Cell_T& destination, const Cell_T& source)
+	{
+		destination = source;
+	}
+
+	template<class... Variables> static void copy(
+		Cell_T& destination,
+		const Cell_T& source,
+		const Variables&... variables
+	) {
+		(void)std::initializer_list<int>{
+			(destination[variables] = source[variables], 0)...
+		};
+	}
+};
+
+
+} // namespace gensimcell
+
+#endif // ifndef GENSIMCELL_STRUCTURED_GRID_HPP
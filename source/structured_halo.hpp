@@ -0,0 +1,241 @@
+/*
+Exchange of ghost cells of structured grids between processes.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+
+mpi.h must be included prior to including this file.
+*/
+
+#ifndef GENSIMCELL_STRUCTURED_HALO_HPP
+#define GENSIMCELL_STRUCTURED_HALO_HPP
+
+#if defined(MPI_VERSION) && (MPI_VERSION >= 2)
+
+#include "array"
+#include "cstddef"
+
+#include "halo.hpp"
+#include "structured_grid.hpp"
+
+
+namespace gensimcell {
+
+
+/*!
+Updates ghost cells of a Structured_Grid decomposed between
+processes of an MPI Cartesian communicator.
+
+All ghost layers of the grid are exchanged so with a ghost
+width of k a solver whose stencil reaches one cell can take
+k steps between exchanges, solving at step s also k - s
+layers of ghost cells, which needs k times fewer messages
+at the cost of redundantly solving some ghost cells:
+@code
+gensimcell::Structured_Grid<Cell_T, 2> grid({{width, height}}, k);
+gensimcell::Structured_Halo<Cell_T, 2> halo;
+halo.initialize(grid, cart_comm);
+for (size_t step = 0; step < steps; step++) {
+	const size_t margin = k - 1 - step % k;
+	if (margin == k - 1) {
+		halo.exchange();
+	}
+	grid.for_each_cell(margin, offsets, solve);
+}
+@endcode
+Dimensions are exchanged one after another with one
+gensimcell::Halo each, ghost cells of earlier dimensions
+are included in later ones so that also edge and corner
+ghost cells are updated without diagonal neighbors. The
+number of interior cells in dimensions other than d must be
+equal on all processes neighboring in dimension d and at
+least ghost width in all dimensions. Periodic dimensions of
+the communicator are periodic in the grid, ghost cells at
+other outer boundaries aren't modified.
+*/
+template <
+	class Cell_T,
+	std::size_t Dimensions,
+	class Allocator_T = std::allocator<Cell_T>
+> class Structured_Halo
+{
+public:
+
+	using Grid_T = Structured_Grid<Cell_T, Dimensions, Allocator_T>;
+
+
+	/*!
+	Prepares exchanges of ghost cells of given grid between
+	processes of given Cartesian communicator.
+
+	Must be called by all processes of the communicator, which
+	must have Dimensions dimensions. Cells of given grid must
+	not move in memory afterwards. Returns true on success.
+	*/
+	bool initialize(Grid_T& grid, MPI_Comm cart_comm)
+	{
+		int cart_dimensions = -1;
+		if (
+			MPI_Cartdim_get(cart_comm, &cart_dimensions) != MPI_SUCCESS
+			or cart_dimensions != int(Dimensions)
+		) {
+			return false;
+		}
+
+		const std::ptrdiff_t width = std::ptrdiff_t(grid.get_ghost_width());
+		for (std::size_t d = 0; d < Dimensions; d++) {
+			if (std::ptrdiff_t(grid.get_size()[d]) < width) {
+				return false;
+			}
+		}
+
+		for (std::size_t d = 0; d < Dimensions; d++) {
+			auto& halo = this->halos[d];
+			halo.clear();
+
+			int previous = MPI_PROC_NULL, next = MPI_PROC_NULL;
+			if (MPI_Cart_shift(cart_comm, int(d), 1, &previous, &next) != MPI_SUCCESS) {
+				return false;
+			}
+
+			const std::ptrdiff_t size = std::ptrdiff_t(grid.get_size()[d]);
+			// tag is direction of travel
+			enum {to_positive, to_negative};
+
+			/*
+			Visit cells in the same order on all processes: ghost
+			cells of earlier dimensions, only interior of later
+			*/
+			Index_T begin, end;
+			for (std::size_t other = 0; other < Dimensions; other++) {
+				const std::ptrdiff_t other_size = std::ptrdiff_t(grid.get_size()[other]);
+				begin[other] = (other < d ? -width : 0);
+				end[other] = (other < d ? other_size + width : other_size);
+			}
+			begin[d] = 0;
+			end[d] = width;
+
+			for_each_index(begin, end, d, [&](Index_T index, const std::ptrdiff_t layer) {
+				if (previous != MPI_PROC_NULL) {
+					index[d] = layer;
+					halo.add_send(previous, to_negative, grid[index]);
+					index[d] = layer - width;
+					halo.add_receive(previous, to_positive, grid[index]);
+				}
+				if (next != MPI_PROC_NULL) {
+					index[d] = size - width + layer;
+					halo.add_send(next, to_positive, grid[index]);
+					index[d] = size + layer;
+					halo.add_receive(next, to_negative, grid[index]);
+				}
+			});
+
+			if (not halo.initialize(cart_comm)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+
+	/*!
+	Exchanges all ghost layers with neighboring processes
+	using given transport for each dimension.
+
+	Returns true on success.
+	*/
+	bool exchange(const Halo_Transport transport = Halo_Transport::neighbor_collective)
+	{
+		for (auto& halo: this->halos) {
+			if (not halo.exchange(transport)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+
+	//! Returns the halo used for given dimension.
+	Halo<Cell_T>& get_halo(const std::size_t dimension)
+	{
+		return this->halos[dimension];
+	}
+
+
+private:
+
+	using Index_T = typename Grid_T::Index_T;
+
+	std::array<Halo<Cell_T>, Dimensions> halos;
+
+
+	/*!
+	Calls f(index, layer) for each index in [begin, end) in other
+	dimensions than given one and each layer in [0, end[dimension]).
+	*/
+	template<class Function> static void for_each_index(
+		const Index_T& begin,
+		const Index_T& end,
+		const std::size_t dimension,
+		Function f
+	) {
+		Index_T index = begin;
+		index[dimension] = 0;
+		while (true) {
+			for (std::ptrdiff_t layer = 0; layer < end[dimension]; layer++) {
+				f(index, layer);
+			}
+
+			std::size_t d = 0;
+			for (; d < Dimensions; d++) {
+				if (d == dimension) {
+					continue;
+				}
+				index[d]++;
+				if (index[d] < end[d]) {
+					break;
+				}
+				index[d] = begin[d];
+			}
+			if (d == Dimensions) {
+				break;
+			}
+		}
+	}
+};
+
+
+} // namespace gensimcell
+
+#endif // if defined(MPI_VERSION) && (MPI_VERSION >= 2)
+
+#endif // ifndef GENSIMCELL_STRUCTURED_HALO_HPP
@@ -34,7 +34,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define GENSIMCELL_TYPE_SUPPORT_HPP
 
 
+#include "cstddef"
+#include "string"
 #include "type_traits"
+#include "typeinfo"
+
+#include "boost/core/demangle.hpp"
 
 
 namespace gensimcell {
@@ -60,6 +65,59 @@ template <
 > struct is_gensimcell<Cell<Transfer_Policy, Variables...>> : std::true_type {};
 
 
+/*!
+Returns a human readable name of given variable.
+
+The name is the demangled name of the variable's type,
+for example advection::Density, and is used e.g. to
+identify variables stored in files.
+*/
+template <class Variable> std::string get_variable_name()
+{
+	return boost::core::demangle(typeid(Variable).name());
+}
+
+
+/*!
+Alignment of given variable's data in generic simulation cells.
+
+By default equal to alignof(Variable::data_type). A variable
+can request stricter alignment of its data by defining e.g.
+@code
+struct Velocity {
+	using data_type = std::array<double, 4>;
+	static constexpr size_t alignment = 32;
+};
+@endcode
+Alignment smaller than the natural alignment of data_type is ignored.
+As a cell's alignment is the largest alignment of its variables
+and the size of a cell is a multiple of its alignment, giving e.g.
+the first variable an alignment of 64 aligns whole cells to cache
+lines so that threads working on different cells don't share them.
+Cells with alignment larger than that of std::max_align_t should
+be stored e.g. in containers using gensimcell::Aligned_Allocator.
+*/
+template <class Variable, class = void> struct get_variable_alignment :
+	std::integral_constant<
+		std::size_t,
+		alignof(typename Variable::data_type)
+	>
+{};
+
+//! Version for variables that define alignment.
+template <class Variable> struct get_variable_alignment<
+	Variable,
+	typename std::enable_if<(Variable::alignment > 0)>::type
+> :
+	std::integral_constant<
+		std::size_t,
+		(Variable::alignment > alignof(typename Variable::data_type))
+		? Variable::alignment
+		: alignof(typename Variable::data_type)
+	>
+{};
+
+
 } // namespace gensimcell
 
 
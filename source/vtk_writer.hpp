@@ -0,0 +1,543 @@
+/*
+Binary VTK output of variables in generic simulation cells.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+mpi.h must be included prior to including this file.
+*/
+
+#ifndef GENSIMCELL_VTK_WRITER_HPP
+#define GENSIMCELL_VTK_WRITER_HPP
+
+#if defined(MPI_VERSION) && (MPI_VERSION >= 2)
+
+#include "array"
+#include "cstdint"
+#include "cstring"
+#include "fstream"
+#include "string"
+#include "type_traits"
+#include "vector"
+
+#include "type_support.hpp"
+
+
+namespace gensimcell {
+namespace detail {
+
+
+/*!
+Describes how data of type T is written into VTK files.
+
+Arithmetic types are written as one component
+and std::arrays of them as one component per item.
+*/
+template<class T, class Enable = void> struct Vtk_Data
+{
+	static_assert(
+		std::is_arithmetic<T>::value,
+		"Only arithmetic types and std::arrays of them can be written into VTK files"
+	);
+};
+
+template<class T> struct Vtk_Data<
+	T,
+	typename std::enable_if<std::is_arithmetic<T>::value>::type
+> {
+	// bool is written as UInt8 so write it as such
+	using component_type = typename std::conditional<
+		std::is_same<T, bool>::value,
+		uint8_t,
+		T
+	>::type;
+
+	static constexpr size_t number_of_components = 1;
+
+	static std::string get_type_name()
+	{
+		if (std::is_floating_point<component_type>::value) {
+			return "Float" + std::to_string(8 * sizeof(component_type));
+		} else if (std::is_signed<component_type>::value) {
+			return "Int" + std::to_string(8 * sizeof(component_type));
+		} else {
+			return "UInt" + std::to_string(8 * sizeof(component_type));
+		}
+	}
+
+	static void append(const T& data, std::vector<char>& buffer)
+	{
+		const component_type component = data;
+		const char* const begin = reinterpret_cast<const char*>(&component);
+		buffer.insert(buffer.end(), begin, begin + sizeof(component));
+	}
+};
+
+template<class T, size_t N> struct Vtk_Data<std::array<T, N>, void>
+{
+	using component_type = typename Vtk_Data<T>::component_type;
+
+	static constexpr size_t number_of_components = N;
+
+	static std::string get_type_name()
+	{
+		return Vtk_Data<T>::get_type_name();
+	}
+
+	static void append(const std::array<T, N>& data, std::vector<char>& buffer)
+	{
+		for (const auto& item: data) {
+			Vtk_Data<T>::append(item, buffer);
+		}
+	}
+};
+
+
+//! Returns the byte order of this system in the format used by VTK.
+inline std::string get_vtk_byte_order()
+{
+	const uint16_t value = 1;
+	uint8_t first_byte = 0;
+	std::memcpy(&first_byte, &value, 1);
+
+	if (first_byte == 1) {
+		return "LittleEndian";
+	} else {
+		return "BigEndian";
+	}
+}
+
+
+/*!
+Returns given string with characters that aren't
+allowed in XML attribute values replaced by entities.
+
+Names of e.g. templated variables contain < and >.
+*/
+inline std::string escape_vtk_attribute(const std::string& value)
+{
+	std::string escaped;
+	escaped.reserve(value.size());
+
+	for (const char c: value) {
+		switch (c) {
+		case '<':
+			escaped += "&lt;";
+			break;
+		case '>':
+			escaped += "&gt;";
+			break;
+		case '&':
+			escaped += "&amp;";
+			break;
+		case '"':
+			escaped += "&quot;";
+			break;
+		case '\'':
+			escaped += "&apos;";
+			break;
+		default:
+			escaped += c;
+			break;
+		}
+	}
+
+	return escaped;
+}
+
+
+//! Description of one array of data in a VTK file.
+struct Vtk_Array
+{
+	// name is escaped for use in XML attributes
+	std::string name, type_name;
+	size_t number_of_components, component_size;
+};
+
+
+/*!
+Prepares given buffer for appended data of one array in a VTK file.
+
+VTK expects the number of bytes of data to precede the data.
+*/
+inline void start_vtk_array(std::vector<char>& buffer, const size_t number_of_bytes)
+{
+	buffer.clear();
+	buffer.reserve(sizeof(uint64_t) + number_of_bytes);
+
+	const uint64_t size = number_of_bytes;
+	const char* const begin = reinterpret_cast<const char*>(&size);
+	buffer.insert(buffer.end(), begin, begin + sizeof(size));
+}
+
+
+//! Stops the iteration over variables.
+template<class Cell_T> void get_vtk_arrays(std::vector<Vtk_Array>&) {}
+
+//! Appends descriptions of given variables to given vector.
+template<
+	class Cell_T,
+	class First_Variable,
+	class... Rest_Of_Variables
+> void get_vtk_arrays(std::vector<Vtk_Array>& arrays)
+{
+	using Data = Vtk_Data<typename First_Variable::data_type>;
+
+	arrays.push_back({
+		escape_vtk_attribute(get_variable_name<First_Variable>()),
+		Data::get_type_name(),
+		Data::number_of_components,
+		sizeof(typename Data::component_type)
+	});
+
+	get_vtk_arrays<Cell_T, Rest_Of_Variables...>(arrays);
+}
+
+
+//! Stops the iteration over variables.
+template<class Cell_T> bool write_vtk_variables(
+	std::ofstream&,
+	std::vector<char>&,
+	const std::vector<const Cell_T*>&
+) {
+	return true;
+}
+
+//! Writes data of given variables from given cells into given file.
+template<
+	class Cell_T,
+	class First_Variable,
+	class... Rest_Of_Variables
+> bool write_vtk_variables(
+	std::ofstream& file,
+	std::vector<char>& buffer,
+	const std::vector<const Cell_T*>& cells,
+	const First_Variable& first_variable,
+	const Rest_Of_Variables&... rest_of_variables
+) {
+	using Data = Vtk_Data<typename First_Variable::data_type>;
+
+	start_vtk_array(
+		buffer,
+		cells.size()
+			* Data::number_of_components
+			* sizeof(typename Data::component_type)
+	);
+	for (const auto* const cell: cells) {
+		Data::append((*cell)[first_variable], buffer);
+	}
+
+	file.write(buffer.data(), std::streamsize(buffer.size()));
+	if (not file.good()) {
+		return false;
+	}
+
+	return write_vtk_variables(file, buffer, cells, rest_of_variables...);
+}
+
+
+/*!
+Writes given cells into a .vtu file.
+
+See gensimcell::save_vtk() for details.
+*/
+template<
+	class Cell_T,
+	class... Variables
+> bool write_vtu(
+	const std::string& file_name,
+	const std::vector<const Cell_T*>& cells,
+	const std::vector<std::array<double, 3>>& cell_min,
+	const std::vector<std::array<double, 3>>& cell_max,
+	const Variables&... variables
+) {
+	constexpr uint8_t vtk_voxel = 11;
+	const size_t number_of_cells = cells.size();
+
+	std::vector<Vtk_Array> arrays;
+	get_vtk_arrays<Cell_T, Variables...>(arrays);
+
+	std::ofstream file(file_name, std::ios::binary);
+	if (not file.good()) {
+		return false;
+	}
+
+	file
+		<< "<?xml version=\"1.0\"?>\n"
+		<< "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\""
+		<< get_vtk_byte_order() << "\" header_type=\"UInt64\">\n"
+		<< "<UnstructuredGrid>\n"
+		<< "<Piece NumberOfPoints=\"" << 8 * number_of_cells
+		<< "\" NumberOfCells=\"" << number_of_cells << "\">\n";
+
+	// offsets of arrays in appended data
+	uint64_t offset = 0;
+
+	file
+		<< "<Points>\n"
+		<< "<DataArray type=\"Float64\" NumberOfComponents=\"3\" "
+		<< "format=\"appended\" offset=\"" << offset << "\"/>\n"
+		<< "</Points>\n";
+	offset += sizeof(uint64_t) + 8 * 3 * number_of_cells * sizeof(double);
+
+	file
+		<< "<Cells>\n"
+		<< "<DataArray type=\"Int64\" Name=\"connectivity\" "
+		<< "format=\"appended\" offset=\"" << offset << "\"/>\n";
+	offset += sizeof(uint64_t) + 8 * number_of_cells * sizeof(int64_t);
+
+	file
+		<< "<DataArray type=\"Int64\" Name=\"offsets\" "
+		<< "format=\"appended\" offset=\"" << offset << "\"/>\n";
+	offset += sizeof(uint64_t) + number_of_cells * sizeof(int64_t);
+
+	file
+		<< "<DataArray type=\"UInt8\" Name=\"types\" "
+		<< "format=\"appended\" offset=\"" << offset << "\"/>\n"
+		<< "</Cells>\n";
+	offset += sizeof(uint64_t) + number_of_cells * sizeof(uint8_t);
+
+	file << "<CellData>\n";
+	for (const auto& array: arrays) {
+		file
+			<< "<DataArray type=\"" << array.type_name
+			<< "\" Name=\"" << array.name
+			<< "\" NumberOfComponents=\"" << array.number_of_components
+			<< "\" format=\"appended\" offset=\"" << offset << "\"/>\n";
+		offset
+			+= sizeof(uint64_t)
+			+ number_of_cells
+				* array.number_of_components
+				* array.component_size;
+	}
+	file
+		<< "</CellData>\n"
+		<< "</Piece>\n"
+		<< "</UnstructuredGrid>\n"
+		<< "<AppendedData encoding=\"raw\">\n_";
+
+	std::vector<char> buffer;
+
+	// corners of voxels with x changing fastest
+	start_vtk_array(buffer, 8 * 3 * number_of_cells * sizeof(double));
+	for (size_t i = 0; i < number_of_cells; i++) {
+		const auto& min = cell_min[i];
+		const auto& max = cell_max[i];
+		for (size_t corner = 0; corner < 8; corner++) {
+			const std::array<double, 3> point{{
+				(corner & 1) ? max[0] : min[0],
+				(corner & 2) ? max[1] : min[1],
+				(corner & 4) ? max[2] : min[2]
+			}};
+			const char* const begin = reinterpret_cast<const char*>(point.data());
+			buffer.insert(buffer.end(), begin, begin + sizeof(point));
+		}
+	}
+	file.write(buffer.data(), std::streamsize(buffer.size()));
+
+	start_vtk_array(buffer, 8 * number_of_cells * sizeof(int64_t));
+	for (int64_t i = 0; i < int64_t(8 * number_of_cells); i++) {
+		const char* const begin = reinterpret_cast<const char*>(&i);
+		buffer.insert(buffer.end(), begin, begin + sizeof(i));
+	}
+	file.write(buffer.data(), std::streamsize(buffer.size()));
+
+	start_vtk_array(buffer, number_of_cells * sizeof(int64_t));
+	for (int64_t i = 1; i <= int64_t(number_of_cells); i++) {
+		const int64_t cell_end = 8 * i;
+		const char* const begin = reinterpret_cast<const char*>(&cell_end);
+		buffer.insert(buffer.end(), begin, begin + sizeof(cell_end));
+	}
+	file.write(buffer.data(), std::streamsize(buffer.size()));
+
+	start_vtk_array(buffer, number_of_cells * sizeof(uint8_t));
+	buffer.insert(buffer.end(), number_of_cells, char(vtk_voxel));
+	file.write(buffer.data(), std::streamsize(buffer.size()));
+
+	if (not write_vtk_variables(file, buffer, cells, variables...)) {
+		return false;
+	}
+
+	file << "\n</AppendedData>\n</VTKFile>\n";
+
+	return file.good();
+}
+
+
+/*!
+Writes a .pvtu file which refers to given number of .vtu files.
+
+See gensimcell::save_vtk() for details.
+*/
+template<
+	class Cell_T,
+	class... Variables
+> bool write_pvtu(
+	const std::string& file_name_prefix,
+	const int number_of_pieces
+) {
+	std::vector<Vtk_Array> arrays;
+	get_vtk_arrays<Cell_T, Variables...>(arrays);
+
+	std::ofstream file(file_name_prefix + ".pvtu");
+	if (not file.good()) {
+		return false;
+	}
+
+	// pieces are given relative to the .pvtu file
+	const auto directory_end = file_name_prefix.find_last_of('/');
+	const std::string piece_prefix
+		= (directory_end == std::string::npos)
+		? file_name_prefix
+		: file_name_prefix.substr(directory_end + 1);
+
+	file
+		<< "<?xml version=\"1.0\"?>\n"
+		<< "<VTKFile type=\"PUnstructuredGrid\" version=\"1.0\" byte_order=\""
+		<< get_vtk_byte_order() << "\" header_type=\"UInt64\">\n"
+		<< "<PUnstructuredGrid GhostLevel=\"0\">\n"
+		<< "<PPoints>\n"
+		<< "<PDataArray type=\"Float64\" NumberOfComponents=\"3\"/>\n"
+		<< "</PPoints>\n"
+		<< "<PCellData>\n";
+	for (const auto& array: arrays) {
+		file
+			<< "<PDataArray type=\"" << array.type_name
+			<< "\" Name=\"" << array.name
+			<< "\" NumberOfComponents=\"" << array.number_of_components
+			<< "\"/>\n";
+	}
+	file << "</PCellData>\n";
+
+	for (int i = 0; i < number_of_pieces; i++) {
+		file
+			<< "<Piece Source=\"" << escape_vtk_attribute(piece_prefix)
+			<< "_" << i << ".vtu\"/>\n";
+	}
+
+	file
+		<< "</PUnstructuredGrid>\n"
+		<< "</VTKFile>\n";
+
+	return file.good();
+}
+
+
+} // namespace detail
+
+
+/*!
+Saves given variables of given cells into binary VTK files.
+
+Each process writes its cells into file_name_prefix_<rank>.vtu
+as voxels using raw appended binary data without converting
+anything to text. Process 0 also writes file_name_prefix.pvtu
+which can be opened e.g. in ParaView or VisIt to visualize
+the data of all processes.
+
+Bounding boxes of cells are given by cell_min and cell_max
+in the same order as cells. Data of variables must be an
+arithmetic type or std::array of arithmetic types, in which
+case each item is written as one component. Variables are named
+in the file by get_variable_name(). Data is written regardless
+of the transfer policy of the cells.
+
+Must be called by all processes of given communicator.
+Returns true on success and false otherwise.
+
+Example:
+@code
+std::vector<const Cell*> cells;
+std::vector<std::array<double, 3>> cell_min, cell_max;
+for (const auto& cell_id: grid.get_cells()) {
+	cells.push_back(grid[cell_id]);
+	cell_min.push_back(grid.geometry.get_min(cell_id));
+	cell_max.push_back(grid.geometry.get_max(cell_id));
+}
+gensimcell::save_vtk(
+	"advection_0000", comm, cells, cell_min, cell_max,
+	Density(), Velocity()
+);
+@endcode
+*/
+template<
+	class Cell_T,
+	class... Variables
+> bool save_vtk(
+	const std::string& file_name_prefix,
+	MPI_Comm comm,
+	const std::vector<const Cell_T*>& cells,
+	const std::vector<std::array<double, 3>>& cell_min,
+	const std::vector<std::array<double, 3>>& cell_max,
+	const Variables&... variables
+) {
+	int rank = -1, comm_size = -1;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &comm_size);
+
+	bool success = true;
+	if (cells.size() != cell_min.size() or cells.size() != cell_max.size()) {
+		success = false;
+	}
+
+	if (
+		success
+		and not detail::write_vtu(
+			file_name_prefix + "_" + std::to_string(rank) + ".vtu",
+			cells,
+			cell_min,
+			cell_max,
+			variables...
+		)
+	) {
+		success = false;
+	}
+
+	if (
+		rank == 0
+		and not detail::write_pvtu<Cell_T, Variables...>(
+			file_name_prefix,
+			comm_size
+		)
+	) {
+		success = false;
+	}
+
+	int local_success = (success ? 1 : 0), global_success = 0;
+	MPI_Allreduce(&local_success, &global_success, 1, MPI_INT, MPI_MIN, comm);
+	return global_success > 0;
+}
+
+
+} // namespace gensimcell
+
+#endif // ifdef MPI_VERSION
+
+#endif // ifndef GENSIMCELL_VTK_WRITER_HPP
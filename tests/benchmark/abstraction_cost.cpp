@@ -0,0 +1,146 @@
+/*
+Benchmark of the cost of gensimcell's abstraction.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+For several sets of variables prints the size of a cell, the time
+per cell spent accessing all variables and creating and freeing the
+cell's MPI datatype, and the bandwidth of transferring all cells
+between processes both for gensimcell::Cell and an equivalent plain
+cell from abstraction_cost.hpp. Run e.g. with make benchmark.
+*/
+
+#include "array"
+#include "cstdlib"
+#include "iostream"
+#include "mpi.h"
+#include "vector"
+
+#include "abstraction_cost.hpp"
+
+using namespace std;
+
+
+constexpr size_t
+	number_of_cells = 1 << 14,
+	repetitions = 20;
+
+
+struct Density { using data_type = double; };
+struct Pressure { using data_type = double; };
+struct Is_Alive { using data_type = int; };
+struct Velocity { using data_type = array<double, 3>; };
+struct Magnetic_Field { using data_type = array<double, 3>; };
+struct Flux { using data_type = array<double, 8>; };
+struct Number_Of_Particles { using data_type = unsigned long long int; };
+struct Particles { using data_type = vector<array<double, 3>>; };
+struct Coordinates { using data_type = vector<double>; };
+
+
+//! Leaves cells as they are.
+struct Keep_Cell {
+	template<class Cell_T> void operator()(Cell_T&) const {}
+};
+
+//! Gives each cell a few particles similarly to the particle example.
+struct Add_Particles {
+	template<class Cell_T> void operator()(Cell_T& cell) const
+	{
+		cell[Number_Of_Particles()] = 4;
+		cell[Particles()].resize(4);
+		cell[Coordinates()].resize(12);
+	}
+};
+
+
+int main(int argc, char* argv[])
+{
+	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
+		cerr << "Couldn't initialize MPI." << endl;
+		abort();
+	}
+
+	int rank = -1;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	if (rank == 0) {
+		abstraction_cost::print_abstraction_cost_header(cout);
+	}
+
+	abstraction_cost::compare_abstraction_cost<Density>(
+		"scalar",
+		number_of_cells,
+		repetitions,
+		Keep_Cell(),
+		cout,
+		MPI_COMM_WORLD
+	);
+
+	abstraction_cost::compare_abstraction_cost<Density, Pressure, Is_Alive>(
+		"scalars",
+		number_of_cells,
+		repetitions,
+		Keep_Cell(),
+		cout,
+		MPI_COMM_WORLD
+	);
+
+	abstraction_cost::compare_abstraction_cost<
+		Density,
+		Velocity,
+		Pressure,
+		Magnetic_Field,
+		Flux
+	>(
+		"arrays",
+		number_of_cells,
+		repetitions,
+		Keep_Cell(),
+		cout,
+		MPI_COMM_WORLD
+	);
+
+	abstraction_cost::compare_abstraction_cost<
+		Number_Of_Particles,
+		Particles,
+		Coordinates
+	>(
+		"particles",
+		number_of_cells,
+		repetitions,
+		Add_Particles(),
+		cout,
+		MPI_COMM_WORLD
+	);
+
+	MPI_Finalize();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,426 @@
+/*
+Compares generic simulation cells with equivalent hand-written cells.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+For a list of variables Reference_Cell stores their data in a plain
+std::tuple, keeps transfer switches in a bitmask and builds its MPI
+datatype with one flat loop without the recursion of gensimcell::Cell,
+the way e.g. tests/parallel/particle_propagation/reference_cell.hpp
+is written by hand. compare_abstraction_cost() then measures both
+cell types for any set of variables.
+
+mpi.h must be included prior to including this file.
+*/
+
+#ifndef ABSTRACTION_COST_HPP
+#define ABSTRACTION_COST_HPP
+
+#include "array"
+#include "chrono"
+#include "cstdint"
+#include "iomanip"
+#include "iostream"
+#include "string"
+#include "tuple"
+#include "type_traits"
+#include "vector"
+
+#include "gensimcell.hpp"
+
+namespace abstraction_cost {
+
+
+//! Index of Variable in the list of variables.
+template<class Variable, class... Variables> struct Index_Of;
+
+template<class Variable, class... Rest> struct Index_Of<Variable, Variable, Rest...>
+	: std::integral_constant<size_t, 0> {};
+
+template<class Variable, class First, class... Rest> struct Index_Of<Variable, First, Rest...>
+	: std::integral_constant<size_t, 1 + Index_Of<Variable, Rest...>::value> {};
+
+
+/*!
+Plain cell equivalent to gensimcell::Cell<Optional_Transfer, Variables...>
+with transfer of variables switched on and off for all cells.
+*/
+template<class... Variables> class Reference_Cell
+{
+public:
+
+	static constexpr size_t number_of_variables = sizeof...(Variables);
+
+	static_assert(
+		number_of_variables <= 64,
+		"Reference cell supports at most 64 variables"
+	);
+
+	// bit i is set if variable i is transferred
+	static uint64_t transfers;
+
+
+	template<class Variable> typename Variable::data_type& operator[](const Variable&)
+	{
+		return std::get<Index_Of<Variable, Variables...>::value>(this->data);
+	}
+
+	template<class Variable> const typename Variable::data_type& operator[](const Variable&) const
+	{
+		return std::get<Index_Of<Variable, Variables...>::value>(this->data);
+	}
+
+
+	std::tuple<void*, int, MPI_Datatype> get_mpi_datatype() const
+	{
+		std::array<void*, number_of_variables> addresses;
+		std::array<int, number_of_variables> counts;
+		std::array<MPI_Aint, number_of_variables> displacements;
+		std::array<MPI_Datatype, number_of_variables> datatypes;
+
+		size_t nr_vars_to_transfer = 0;
+		this->append_transfer_info<0>(
+			nr_vars_to_transfer,
+			addresses,
+			counts,
+			datatypes
+		);
+
+		if (nr_vars_to_transfer == 0) {
+			return std::make_tuple((void*) NULL, 0, MPI_BYTE);
+		}
+
+		if (nr_vars_to_transfer == 1) {
+			return std::make_tuple(addresses[0], counts[0], datatypes[0]);
+		}
+
+		for (size_t i = 0; i < nr_vars_to_transfer; i++) {
+			displacements[i]
+				= static_cast<char*>(addresses[i])
+				- static_cast<char*>(addresses[0]);
+		}
+
+		MPI_Datatype final_datatype = MPI_DATATYPE_NULL;
+		if (
+			MPI_Type_create_struct(
+				int(nr_vars_to_transfer),
+				counts.data(),
+				displacements.data(),
+				datatypes.data(),
+				&final_datatype
+			) != MPI_SUCCESS
+		) {
+			return std::make_tuple((void*) NULL, -1, MPI_DATATYPE_NULL);
+		}
+
+		for (size_t i = 0; i < nr_vars_to_transfer; i++) {
+			gensimcell::detail::free_derived_datatype(datatypes[i]);
+		}
+
+		return std::make_tuple(addresses[0], 1, final_datatype);
+	}
+
+
+private:
+
+	std::tuple<typename Variables::data_type...> data;
+
+
+	template<size_t Index> typename std::enable_if<
+		(Index < number_of_variables)
+	>::type append_transfer_info(
+		size_t& nr_vars_to_transfer,
+		std::array<void*, number_of_variables>& addresses,
+		std::array<int, number_of_variables>& counts,
+		std::array<MPI_Datatype, number_of_variables>& datatypes
+	) const {
+		if ((transfers & (uint64_t(1) << Index)) > 0) {
+			std::tie(
+				addresses[nr_vars_to_transfer],
+				counts[nr_vars_to_transfer],
+				datatypes[nr_vars_to_transfer]
+			) = gensimcell::detail::get_var_mpi_datatype(std::get<Index>(this->data));
+			nr_vars_to_transfer++;
+		}
+
+		this->append_transfer_info<Index + 1>(
+			nr_vars_to_transfer,
+			addresses,
+			counts,
+			datatypes
+		);
+	}
+
+	template<size_t Index> typename std::enable_if<
+		(Index == number_of_variables)
+	>::type append_transfer_info(
+		size_t&,
+		std::array<void*, number_of_variables>&,
+		std::array<int, number_of_variables>&,
+		std::array<MPI_Datatype, number_of_variables>&
+	) const {}
+};
+
+template<class... Variables> uint64_t Reference_Cell<Variables...>::transfers = 0;
+
+
+//! Modifies arithmetic data so that the access can't be optimized away.
+template<class Data_T> typename std::enable_if<
+	std::is_arithmetic<Data_T>::value
+>::type touch(Data_T& data)
+{
+	data += 1;
+}
+
+//! Reads the first byte of other data, e.g. part of std::vector's pointer.
+template<class Data_T> typename std::enable_if<
+	not std::is_arithmetic<Data_T>::value
+>::type touch(Data_T& data)
+{
+	volatile unsigned char first = reinterpret_cast<const unsigned char&>(data);
+	(void) first;
+}
+
+
+template<class Cell_T> void touch_variables(Cell_T&) {}
+
+//! Accesses given variables of given cell.
+template<
+	class Cell_T,
+	class First_Variable,
+	class... Rest_Of_Variables
+> void touch_variables(Cell_T& cell)
+{
+	touch(cell[First_Variable()]);
+	touch_variables<Cell_T, Rest_Of_Variables...>(cell);
+}
+
+
+//! Measured costs of one cell type in nanoseconds per cell and bytes per second.
+struct Cost
+{
+	size_t size = 0;
+	double access = 0, datatype = 0, bandwidth = 0;
+};
+
+
+/*!
+Measures the costs of using given cells in which
+given variables are set to be transferred.
+*/
+template<class Cell_T, class... Variables> Cost measure(
+	std::vector<Cell_T>& cells,
+	std::vector<Cell_T>& received_cells,
+	const size_t repetitions,
+	MPI_Comm comm
+) {
+	using std::chrono::duration;
+	using std::chrono::steady_clock;
+
+	int rank = -1, comm_size = -1;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &comm_size);
+
+	Cost cost;
+	cost.size = sizeof(Cell_T);
+
+	// access
+	auto start = steady_clock::now();
+	for (size_t repetition = 0; repetition < repetitions; repetition++) {
+		for (auto& cell: cells) {
+			touch_variables<Cell_T, Variables...>(cell);
+		}
+	}
+	cost.access
+		= 1e9 * duration<double>(steady_clock::now() - start).count()
+		/ (repetitions * cells.size());
+
+	// datatype creation, commit and free
+	start = steady_clock::now();
+	for (size_t repetition = 0; repetition < repetitions; repetition++) {
+		for (const auto& cell: cells) {
+			MPI_Datatype datatype = std::get<2>(cell.get_mpi_datatype());
+			gensimcell::detail::free_derived_datatype(datatype);
+		}
+	}
+	cost.datatype
+		= 1e9 * duration<double>(steady_clock::now() - start).count()
+		/ (repetitions * cells.size());
+
+	/*
+	Transfer all cells between pairs of processes, or to
+	self if there's no pair, with one datatype using absolute
+	addresses of cells
+	*/
+	const auto get_all_cells_datatype = [](const std::vector<Cell_T>& given_cells) {
+		std::vector<int> counts;
+		std::vector<MPI_Aint> addresses;
+		std::vector<MPI_Datatype> datatypes;
+		for (const auto& cell: given_cells) {
+			void* address = nullptr;
+			int count = -1;
+			MPI_Datatype datatype = MPI_DATATYPE_NULL;
+			std::tie(address, count, datatype) = cell.get_mpi_datatype();
+			MPI_Aint absolute_address = 0;
+			MPI_Get_address(address, &absolute_address);
+			counts.push_back(count);
+			addresses.push_back(absolute_address);
+			datatypes.push_back(datatype);
+		}
+
+		MPI_Datatype all_cells = MPI_DATATYPE_NULL;
+		MPI_Type_create_struct(
+			int(counts.size()),
+			counts.data(),
+			addresses.data(),
+			datatypes.data(),
+			&all_cells
+		);
+		MPI_Type_commit(&all_cells);
+		for (auto& datatype: datatypes) {
+			gensimcell::detail::free_derived_datatype(datatype);
+		}
+		return all_cells;
+	};
+
+	MPI_Datatype
+		send_datatype = get_all_cells_datatype(cells),
+		receive_datatype = get_all_cells_datatype(received_cells);
+
+	int datatype_size = 0;
+	MPI_Type_size(send_datatype, &datatype_size);
+
+	int other = rank ^ 1;
+	if (other >= comm_size) {
+		other = rank;
+	}
+
+	MPI_Barrier(comm);
+	start = steady_clock::now();
+	for (size_t repetition = 0; repetition < repetitions; repetition++) {
+		MPI_Sendrecv(
+			MPI_BOTTOM, 1, send_datatype, other, 0,
+			MPI_BOTTOM, 1, receive_datatype, other, 0,
+			comm, MPI_STATUS_IGNORE
+		);
+	}
+	cost.bandwidth
+		= double(datatype_size) * repetitions
+		/ duration<double>(steady_clock::now() - start).count();
+
+	MPI_Type_free(&send_datatype);
+	MPI_Type_free(&receive_datatype);
+
+	return cost;
+}
+
+
+/*!
+Prints the costs of gensimcell::Cell and Reference_Cell
+holding given variables into given stream.
+
+Given function is called for each cell of both types
+before measuring and should e.g. resize vectors.
+Must be called by all processes of given communicator,
+only process 0 prints.
+*/
+template<class... Variables, class Initializer> void compare_abstraction_cost(
+	const std::string& name,
+	const size_t number_of_cells,
+	const size_t repetitions,
+	Initializer initialize,
+	std::ostream& out,
+	MPI_Comm comm
+) {
+	using Generic_Cell = gensimcell::Cell<gensimcell::Optional_Transfer, Variables...>;
+	using Plain_Cell = Reference_Cell<Variables...>;
+
+	std::vector<Generic_Cell> generic_cells(number_of_cells), generic_received(number_of_cells);
+	std::vector<Plain_Cell> plain_cells(number_of_cells), plain_received(number_of_cells);
+	for (size_t i = 0; i < number_of_cells; i++) {
+		initialize(generic_cells[i]);
+		initialize(generic_received[i]);
+		initialize(plain_cells[i]);
+		initialize(plain_received[i]);
+	}
+
+	Generic_Cell::set_transfer_all(true, Variables()...);
+	Plain_Cell::transfers = ~uint64_t(0);
+
+	const Cost
+		generic = measure<Generic_Cell, Variables...>(
+			generic_cells, generic_received, repetitions, comm
+		),
+		plain = measure<Plain_Cell, Variables...>(
+			plain_cells, plain_received, repetitions, comm
+		);
+
+	Generic_Cell::set_transfer_all(false, Variables()...);
+	Plain_Cell::transfers = 0;
+
+	int rank = -1;
+	MPI_Comm_rank(comm, &rank);
+	if (rank != 0) {
+		return;
+	}
+
+	for (const auto& item: {
+		std::make_pair(std::string("gensimcell"), generic),
+		std::make_pair(std::string("reference"), plain)
+	}) {
+		out << std::setw(16) << std::left << name << std::right
+			<< std::setw(12) << item.first
+			<< std::setw(8) << item.second.size
+			<< std::fixed << std::setprecision(2)
+			<< std::setw(12) << item.second.access
+			<< std::setw(12) << item.second.datatype
+			<< std::setw(12) << item.second.bandwidth / 1e6
+			<< std::endl;
+	}
+}
+
+
+//! Prints the header of compare_abstraction_cost() output.
+inline void print_abstraction_cost_header(std::ostream& out)
+{
+	out << std::setw(16) << std::left << "variables" << std::right
+		<< std::setw(12) << "cell"
+		<< std::setw(8) << "sizeof"
+		<< std::setw(12) << "access ns"
+		<< std::setw(12) << "datatype ns"
+		<< std::setw(12) << "MB/s"
+		<< std::endl;
+}
+
+
+} // namespace abstraction_cost
+
+#endif // ifndef ABSTRACTION_COST_HPP
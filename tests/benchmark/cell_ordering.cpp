@@ -0,0 +1,399 @@
+/*
+Benchmark of solving cells in space-filling curve order.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+
+
+
+Steps game of life and advection, ported from the serial examples,
+on periodic 2d grids whose cells are stored by id in a hash table
+like in dccrg or contiguously in solving order. Cells are solved in
+order of their ids, which is the order in which dccrg returns local
+cells, in random order, as can happen after load balancing, and
+along Morton and Hilbert curves. Cells of hash tables are inserted
+in random order, in solving order or in order of their ids like
+dccrg creates them. Neighbors in hash tables are either looked up
+at every step or, like with examples/neighbor_table.hpp, once into
+a table of pointers in solving order. Prints the time per cell
+and step of each. Run e.g. with make benchmark and with perf
+stat -e cache-misses to see the number of cache misses.
+*/
+
+#include "algorithm"
+#include "array"
+#include "chrono"
+#include "cmath"
+#include "cstdint"
+#include "cstdlib"
+#include "iomanip"
+#include "iostream"
+#include "random"
+#include "string"
+#include "unordered_map"
+#include "vector"
+
+#include "gensimcell.hpp"
+#include "space_filling_curve.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+
+struct Is_Alive { using data_type = bool; };
+struct Live_Neighbors { using data_type = int; };
+
+using Gol_Cell = gensimcell::Cell<
+	gensimcell::Never_Transfer,
+	Is_Alive,
+	Live_Neighbors
+>;
+
+struct Density { using data_type = double; };
+struct Density_Flux { using data_type = double; };
+struct Velocity { using data_type = array<double, 2>; };
+
+using Advection_Cell = gensimcell::Cell<
+	gensimcell::Never_Transfer,
+	Density,
+	Density_Flux,
+	Velocity
+>;
+
+using Index_T = array<uint64_t, 2>;
+
+// approximate number of cells to step in total for each grid size
+constexpr size_t cell_steps = size_t(1) << 22;
+
+const array<array<int, 2>, 8> gol_offsets{{
+	{{-1, -1}}, {{0, -1}}, {{1, -1}}, {{-1, 0}},
+	{{1, 0}}, {{-1, 1}}, {{0, 1}}, {{1, 1}}
+}};
+
+const array<array<int, 2>, 4> advection_offsets{{
+	{{-1, 0}}, {{1, 0}}, {{0, -1}}, {{0, 1}}
+}};
+
+
+/*!
+Cells of a periodic grid of given size with ids starting from 1
+like in dccrg, solved in order of cell ids in solve_order.
+
+If contiguous cells are stored in solving order in a vector
+otherwise in a hash table.
+*/
+template<class Cell_T, size_t Neighbors> class Cells
+{
+public:
+	size_t size;
+	vector<uint64_t> solve_order;
+	array<array<int, 2>, Neighbors> offsets;
+
+	bool contiguous, cached;
+	unordered_map<uint64_t, Cell_T> by_id;
+	vector<Cell_T> data;
+	vector<array<size_t, Neighbors>> neighbor_positions;
+	// cells and their neighbors in solving order if cached
+	vector<Cell_T*> cell_pointers;
+	vector<array<Cell_T*, Neighbors>> neighbor_pointers;
+
+
+	Index_T get_index(const uint64_t id) const
+	{
+		return {{(id - 1) % this->size, (id - 1) / this->size}};
+	}
+
+	uint64_t get_id(const Index_T& index) const
+	{
+		return 1 + index[0] + index[1] * this->size;
+	}
+
+	uint64_t get_neighbor(const uint64_t id, const array<int, 2>& offset) const
+	{
+		const auto index = this->get_index(id);
+		return this->get_id({{
+			(index[0] + this->size + offset[0]) % this->size,
+			(index[1] + this->size + offset[1]) % this->size
+		}});
+	}
+
+
+	/*!
+	Calls f(cell, neighbors, index) for each cell in solving order.
+	*/
+	template<class Function> void for_each_cell(Function f)
+	{
+		array<Cell_T*, Neighbors> neighbors;
+
+		if (this->cached) {
+			for (size_t i = 0; i < this->cell_pointers.size(); i++) {
+				f(
+					*this->cell_pointers[i],
+					this->neighbor_pointers[i],
+					this->get_index(this->solve_order[i])
+				);
+			}
+		} else if (this->contiguous) {
+			for (size_t i = 0; i < this->data.size(); i++) {
+				for (size_t n = 0; n < Neighbors; n++) {
+					neighbors[n] = &this->data[this->neighbor_positions[i][n]];
+				}
+				f(this->data[i], neighbors, this->get_index(this->solve_order[i]));
+			}
+		} else {
+			for (const auto id: this->solve_order) {
+				for (size_t n = 0; n < Neighbors; n++) {
+					neighbors[n] = &this->by_id.at(
+						this->get_neighbor(id, this->offsets[n])
+					);
+				}
+				f(this->by_id.at(id), neighbors, this->get_index(id));
+			}
+		}
+	}
+};
+
+
+//! Steps game of life, see examples/game_of_life/serial.cpp.
+void step(Cells<Gol_Cell, 8>& cells)
+{
+	cells.for_each_cell(
+		[](Gol_Cell& cell, const array<Gol_Cell*, 8>& neighbors, const Index_T&) {
+			for (const auto* neighbor: neighbors) {
+				if ((*neighbor)[Is_Alive()]) {
+					cell[Live_Neighbors()]++;
+				}
+			}
+		}
+	);
+
+	cells.for_each_cell(
+		[](Gol_Cell& cell, const array<Gol_Cell*, 8>&, const Index_T&) {
+			if (cell[Live_Neighbors()] == 3) {
+				cell[Is_Alive()] = true;
+			} else if (cell[Live_Neighbors()] != 2) {
+				cell[Is_Alive()] = false;
+			}
+			cell[Live_Neighbors()] = 0;
+		}
+	);
+}
+
+
+//! Steps advection, see examples/advection/serial.cpp.
+void step(Cells<Advection_Cell, 4>& cells)
+{
+	const double
+		cell_size = 2.0 / cells.size,
+		dt = 0.25 * cell_size;
+
+	const auto get_flux
+		= [&](const Advection_Cell& cell) -> array<double, 2> {
+			return {{
+				cell[Density()] * (cell[Velocity()][0] * dt / cell_size),
+				cell[Density()] * (cell[Velocity()][1] * dt / cell_size)
+			}};
+		};
+
+	cells.for_each_cell(
+		[&](
+			Advection_Cell& cell,
+			const array<Advection_Cell*, 4>& neighbors,
+			const Index_T&
+		) {
+			const array<double, 2> flux = get_flux(cell);
+			cell[Density_Flux()]
+				+= max(get_flux(*neighbors[0])[0], 0.0)
+				+ max(-get_flux(*neighbors[1])[0], 0.0)
+				+ max(get_flux(*neighbors[2])[1], 0.0)
+				+ max(-get_flux(*neighbors[3])[1], 0.0)
+				- fabs(flux[0]) - fabs(flux[1]);
+		}
+	);
+
+	cells.for_each_cell(
+		[](Advection_Cell& cell, const array<Advection_Cell*, 4>&, const Index_T&) {
+			cell[Density()] += cell[Density_Flux()];
+			cell[Density_Flux()] = 0;
+		}
+	);
+}
+
+
+void initialize(Cells<Gol_Cell, 8>& cells)
+{
+	cells.for_each_cell(
+		[](Gol_Cell& cell, const array<Gol_Cell*, 8>&, const Index_T& index) {
+			// something that doesn't die out immediately
+			cell[Is_Alive()] = (index[0] * 7 + index[1] * 13) % 5 < 2;
+			cell[Live_Neighbors()] = 0;
+		}
+	);
+}
+
+void initialize(Cells<Advection_Cell, 4>& cells)
+{
+	const auto size = cells.size;
+	cells.for_each_cell(
+		[&](
+			Advection_Cell& cell,
+			const array<Advection_Cell*, 4>&,
+			const Index_T& index
+		) {
+			const double
+				x = -1.0 + (0.5 + index[0]) * 2.0 / size,
+				y = -1.0 + (0.5 + index[1]) * 2.0 / size;
+			cell[Density()] = (fabs(x) < 0.5 and fabs(y) < 0.5 ? 1 : 0);
+			cell[Density_Flux()] = 0;
+			cell[Velocity()] = {{2 * y, -2 * x}};
+		}
+	);
+}
+
+
+/*!
+Prints time per cell and step of stepping cells of a grid
+of given size in each order and with each storage.
+*/
+template<class Cell_T, size_t Neighbors> void benchmark(
+	const string& solver,
+	const size_t size,
+	const array<array<int, 2>, Neighbors>& offsets
+) {
+	vector<uint64_t> ids;
+	for (uint64_t id = 1; id <= size * size; id++) {
+		ids.push_back(id);
+	}
+
+	vector<uint64_t> random_ids(ids);
+	shuffle(random_ids.begin(), random_ids.end(), mt19937_64(size));
+
+	const auto get_index = [size](const uint64_t id) -> Index_T {
+		return {{(id - 1) % size, (id - 1) / size}};
+	};
+
+	const vector<pair<string, vector<uint64_t>>> orders{
+		{"id", ids},
+		{"random", random_ids},
+		{"morton", gensimcell::sort_along_curve(
+			random_ids, get_index, gensimcell::Curve::morton
+		)},
+		{"hilbert", gensimcell::sort_along_curve(
+			random_ids, get_index, gensimcell::Curve::hilbert
+		)}
+	};
+
+	for (const string storage: {
+		"map random", "map ordered", "map id", "table id", "vector"
+	})
+	for (const auto& order: orders) {
+		Cells<Cell_T, Neighbors> cells;
+		cells.size = size;
+		cells.solve_order = order.second;
+		cells.offsets = offsets;
+		cells.contiguous = (storage == "vector");
+		cells.cached = (storage == "table id");
+
+		if (cells.contiguous) {
+			cells.data.resize(size * size);
+			vector<size_t> positions(size * size + 1);
+			for (size_t i = 0; i < cells.solve_order.size(); i++) {
+				positions[cells.solve_order[i]] = i;
+			}
+			for (const auto id: cells.solve_order) {
+				array<size_t, Neighbors> neighbors;
+				for (size_t n = 0; n < Neighbors; n++) {
+					neighbors[n] = positions[cells.get_neighbor(id, offsets[n])];
+				}
+				cells.neighbor_positions.push_back(neighbors);
+			}
+		} else {
+			// allocation order of cells follows insertion order
+			const auto& insertion_order
+				= (storage == "map random")
+				? random_ids
+				: (storage == "map ordered" ? order.second : ids);
+			for (const auto id: insertion_order) {
+				cells.by_id[id];
+			}
+
+			if (cells.cached) {
+				for (const auto id: cells.solve_order) {
+					array<Cell_T*, Neighbors> neighbors;
+					for (size_t n = 0; n < Neighbors; n++) {
+						neighbors[n] = &cells.by_id.at(cells.get_neighbor(id, offsets[n]));
+					}
+					cells.cell_pointers.push_back(&cells.by_id.at(id));
+					cells.neighbor_pointers.push_back(neighbors);
+				}
+			}
+		}
+		initialize(cells);
+
+		const size_t steps = max<size_t>(1, cell_steps / (size * size));
+		// warm up
+		step(cells);
+
+		const auto start = steady_clock::now();
+		for (size_t i = 0; i < steps; i++) {
+			step(cells);
+		}
+		const double time = duration<double>(steady_clock::now() - start).count();
+
+		cout << setw(10) << left << solver << right
+			<< setw(7) << size
+			<< "   " << setw(12) << left << storage
+			<< setw(8) << order.first << right
+			<< fixed << setprecision(3)
+			<< setw(10) << time / steps / (size * size) * 1e9
+			<< endl;
+	}
+}
+
+
+int main(int, char**)
+{
+	cout << setw(10) << left << "solver" << right
+		<< setw(7) << "size"
+		<< "   " << setw(12) << left << "storage"
+		<< setw(8) << "order" << right
+		<< setw(10) << "ns/cell"
+		<< endl;
+
+	for (const size_t size: {128, 1024}) {
+		benchmark<Gol_Cell, 8>("gol", size, gol_offsets);
+	}
+	for (const size_t size: {128, 1024}) {
+		benchmark<Advection_Cell, 4>("advection", size, advection_offsets);
+	}
+
+	return EXIT_SUCCESS;
+}
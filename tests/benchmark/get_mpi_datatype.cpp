@@ -0,0 +1,266 @@
+/*
+Measures the cost of creating MPI datatypes of cells with different variables.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+For each shape of variable and size prints the time per cell
+spent in get_mpi_datatype(), MPI_Type_commit() and MPI_Type_free()
+and the size, extent and number of top level entries of the
+resulting datatype. Run e.g. with make benchmark.
+*/
+
+#include "array"
+#include "chrono"
+#include "cstdlib"
+#include "Eigen/Core"
+#include "Eigen/StdVector"
+#include "iomanip"
+#include "iostream"
+#include "mpi.h"
+#include "string"
+#include "tuple"
+#include "utility"
+#include "vector"
+
+#include "gensimcell.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+
+//! Number of items created with get_var_mpi_datatype() in all cells of a benchmark.
+constexpr size_t total_items = 1 << 18;
+
+
+template<class Data_T> struct Variable {
+	using data_type = Data_T;
+};
+
+template<class Data_T> using One_Variable_Cell = gensimcell::Cell<
+	gensimcell::Always_Transfer,
+	Variable<Data_T>
+>;
+
+
+/*!
+Prints the cost of creating datatypes of given cells.
+
+Size is the number of items in each cell's variable.
+*/
+template<class Cell_T, class Allocator> void benchmark(
+	const string& shape,
+	const size_t size,
+	const vector<Cell_T, Allocator>& cells
+) {
+	vector<tuple<void*, int, MPI_Datatype>> transfer_infos(cells.size());
+
+	const auto construction_start = steady_clock::now();
+	for (size_t i = 0; i < cells.size(); i++) {
+		transfer_infos[i] = cells[i].get_mpi_datatype();
+	}
+	const auto construction_end = steady_clock::now();
+
+	// predefined datatypes aren't committed nor freed
+	int combiner = -1, integers = -1, addresses = -1, datatypes = -1;
+	MPI_Type_get_envelope(
+		get<2>(transfer_infos[0]),
+		&integers,
+		&addresses,
+		&datatypes,
+		&combiner
+	);
+	const bool is_derived = (combiner != MPI_COMBINER_NAMED);
+	const int entries = (is_derived ? datatypes : 1);
+
+	const auto commit_start = steady_clock::now();
+	if (is_derived) {
+		for (auto& transfer_info: transfer_infos) {
+			MPI_Type_commit(&get<2>(transfer_info));
+		}
+	}
+	const auto commit_end = steady_clock::now();
+
+	int datatype_size = -1;
+	MPI_Aint lower_bound = 0, extent = 0;
+	MPI_Type_size(get<2>(transfer_infos[0]), &datatype_size);
+	MPI_Type_get_extent(get<2>(transfer_infos[0]), &lower_bound, &extent);
+
+	const auto free_start = steady_clock::now();
+	if (is_derived) {
+		for (auto& transfer_info: transfer_infos) {
+			MPI_Type_free(&get<2>(transfer_info));
+		}
+	}
+	const auto free_end = steady_clock::now();
+
+	const double nanoseconds_per_cell = 1e9 / cells.size();
+	cout
+		<< setw(22) << left << shape << right
+		<< setw(7) << size
+		<< setw(9) << cells.size()
+		<< fixed << setprecision(1)
+		<< setw(13)
+		<< duration<double>(construction_end - construction_start).count()
+			* nanoseconds_per_cell
+		<< setw(11)
+		<< duration<double>(commit_end - commit_start).count()
+			* nanoseconds_per_cell
+		<< setw(11)
+		<< duration<double>(free_end - free_start).count()
+			* nanoseconds_per_cell
+		<< setw(10) << get<1>(transfer_infos[0]) * datatype_size
+		<< setw(10) << get<1>(transfer_infos[0]) * extent
+		<< setw(9) << entries
+		<< endl;
+}
+
+
+//! Returns the number of cells to use for given number of items per cell.
+size_t get_number_of_cells(const size_t items_per_cell)
+{
+	return std::max(size_t(16), total_items / std::max(size_t(1), items_per_cell));
+}
+
+
+template<size_t Size> void benchmark_array()
+{
+	using Cell_T = One_Variable_Cell<array<double, Size>>;
+	benchmark("std::array<double>", Size, vector<Cell_T>(get_number_of_cells(Size)));
+}
+
+
+template<int Size> void benchmark_eigen()
+{
+	using Cell_T = One_Variable_Cell<Eigen::Matrix<double, Size, Size>>;
+	benchmark(
+		"Eigen::Matrix<double>",
+		Size * Size,
+		vector<Cell_T, Eigen::aligned_allocator<Cell_T>>(
+			get_number_of_cells(Size * Size)
+		)
+	);
+}
+
+
+int main(int argc, char* argv[])
+{
+	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
+		cerr << "Couldn't initialize MPI." << endl;
+		abort();
+	}
+
+	cout
+		<< setw(22) << left << "shape" << right
+		<< setw(7) << "size"
+		<< setw(9) << "cells"
+		<< setw(13) << "create ns"
+		<< setw(11) << "commit ns"
+		<< setw(11) << "free ns"
+		<< setw(10) << "bytes"
+		<< setw(10) << "extent"
+		<< setw(9) << "entries"
+		<< endl;
+
+	benchmark("double", 1, vector<One_Variable_Cell<double>>(total_items));
+
+	benchmark_array<3>();
+	benchmark_array<16>();
+	benchmark_array<256>();
+	benchmark_array<4096>();
+
+	for (const size_t size: {1, 16, 256, 4096}) {
+		using Cell_T = One_Variable_Cell<vector<double>>;
+		vector<Cell_T> cells(get_number_of_cells(size));
+		for (auto& cell: cells) {
+			cell[Variable<vector<double>>()].resize(size);
+		}
+		benchmark("std::vector<double>", size, cells);
+	}
+
+	// vectors of non-primitive items have one entry per item
+	for (const size_t size: {1, 16, 256}) {
+		using Data_T = vector<array<double, 3>>;
+		using Cell_T = One_Variable_Cell<Data_T>;
+		vector<Cell_T> cells(get_number_of_cells(size));
+		for (auto& cell: cells) {
+			cell[Variable<Data_T>()].resize(size);
+		}
+		benchmark("std::vector<array>", size, cells);
+	}
+
+	benchmark(
+		"std::pair",
+		2,
+		vector<One_Variable_Cell<pair<int, double>>>(get_number_of_cells(2))
+	);
+
+	benchmark(
+		"std::tuple",
+		3,
+		vector<One_Variable_Cell<tuple<int, double, array<float, 3>>>>(
+			get_number_of_cells(3)
+		)
+	);
+
+	{
+		using Inner_Cell = gensimcell::Cell<
+			gensimcell::Always_Transfer,
+			Variable<int>,
+			Variable<array<double, 3>>
+		>;
+		benchmark(
+			"gensimcell::Cell",
+			2,
+			vector<One_Variable_Cell<Inner_Cell>>(get_number_of_cells(2))
+		);
+	}
+
+	{
+		using Cell_T = gensimcell::Cell<
+			gensimcell::Always_Transfer,
+			Variable<char>,
+			Variable<int>,
+			Variable<float>,
+			Variable<double>,
+			Variable<array<double, 3>>,
+			Variable<pair<int, int>>
+		>;
+		benchmark("many variables", 6, vector<Cell_T>(get_number_of_cells(6)));
+	}
+
+	benchmark_eigen<2>();
+	benchmark_eigen<4>();
+	benchmark_eigen<8>();
+
+	MPI_Finalize();
+
+	return EXIT_SUCCESS;
+}
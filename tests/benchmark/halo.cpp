@@ -0,0 +1,210 @@
+/*
+Benchmark of halo exchange transports.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+Decomposes a periodic 2d grid between processes with
+MPI_Cart_create and exchanges edge cells of each process'
+block between neighbors using each gensimcell::Halo_Transport.
+Prints the slowest process' average time per exchange for
+several block sizes. Run e.g. with make benchmark or with
+mpirun -n 4 tests/benchmark/halo.mexe.
+*/
+
+#include "array"
+#include "chrono"
+#include "cstdlib"
+#include "iomanip"
+#include "iostream"
+#include "mpi.h"
+#include "string"
+#include "vector"
+
+#include "gensimcell.hpp"
+#include "halo.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+
+struct Density {
+	using data_type = double;
+};
+
+struct Momentum {
+	using data_type = array<double, 3>;
+};
+
+using Cell_T = gensimcell::Cell<
+	gensimcell::Always_Transfer,
+	Density,
+	Momentum
+>;
+
+constexpr size_t repetitions = 200;
+
+
+/*!
+Prints average time of exchanging edges of a block of cells of
+given size on each process between neighbors with given transport.
+*/
+void benchmark(
+	const size_t block_size,
+	const gensimcell::Halo_Transport transport,
+	const string& transport_name,
+	MPI_Comm cart_comm
+) {
+	int rank = -1;
+	MPI_Comm_rank(cart_comm, &rank);
+
+	// block with one layer of ghost cells on each side
+	const size_t width = block_size + 2;
+	vector<Cell_T> cells(width * width);
+	const auto get_cell = [&](const size_t x, const size_t y) -> Cell_T& {
+		return cells[x + y * width];
+	};
+
+	gensimcell::Halo<Cell_T> halo;
+	for (int dimension = 0; dimension < 2; dimension++) {
+		int previous = -1, next = -1;
+		MPI_Cart_shift(cart_comm, dimension, 1, &previous, &next);
+
+		// tag is direction of travel
+		const int to_positive = 2 * dimension, to_negative = 2 * dimension + 1;
+		for (size_t i = 1; i <= block_size; i++) {
+			if (dimension == 0) {
+				halo.add_send(next, to_positive, get_cell(block_size, i));
+				halo.add_send(previous, to_negative, get_cell(1, i));
+				halo.add_receive(previous, to_positive, get_cell(0, i));
+				halo.add_receive(next, to_negative, get_cell(block_size + 1, i));
+			} else {
+				halo.add_send(next, to_positive, get_cell(i, block_size));
+				halo.add_send(previous, to_negative, get_cell(i, 1));
+				halo.add_receive(previous, to_positive, get_cell(i, 0));
+				halo.add_receive(next, to_negative, get_cell(i, block_size + 1));
+			}
+		}
+	}
+
+	if (not halo.initialize(cart_comm)) {
+		cerr << "Couldn't initialize halo." << endl;
+		abort();
+	}
+
+	// warm up
+	if (not halo.exchange(transport)) {
+		if (rank == 0) {
+			cout << setw(22) << left << transport_name << right
+				<< setw(8) << block_size << "   not supported" << endl;
+		}
+		return;
+	}
+
+	MPI_Barrier(cart_comm);
+	const auto start = steady_clock::now();
+	for (size_t i = 0; i < repetitions; i++) {
+		halo.exchange(transport);
+	}
+	double time = duration<double>(steady_clock::now() - start).count() / repetitions;
+	MPI_Allreduce(MPI_IN_PLACE, &time, 1, MPI_DOUBLE, MPI_MAX, cart_comm);
+
+	if (rank == 0) {
+		cout << setw(22) << left << transport_name << right
+			<< setw(8) << block_size
+			<< setw(10) << 4 * block_size * (sizeof(double) + sizeof(Momentum::data_type))
+			<< fixed << setprecision(2)
+			<< setw(14) << time * 1e6
+			<< endl;
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
+		cerr << "Couldn't initialize MPI." << endl;
+		abort();
+	}
+
+	int comm_size = -1;
+	MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+
+	array<int, 2> dimensions{{0, 0}}, periodic{{1, 1}};
+	MPI_Dims_create(comm_size, 2, dimensions.data());
+
+	MPI_Comm cart_comm;
+	MPI_Cart_create(
+		MPI_COMM_WORLD, 2, dimensions.data(), periodic.data(), 0, &cart_comm
+	);
+
+	int rank = -1;
+	MPI_Comm_rank(cart_comm, &rank);
+	if (rank == 0) {
+		cout << "processes " << dimensions[0] << " x " << dimensions[1] << "\n"
+			<< setw(22) << left << "transport" << right
+			<< setw(8) << "block"
+			<< setw(10) << "bytes"
+			<< setw(14) << "exchange us"
+			<< endl;
+	}
+
+	for (const size_t block_size: {4, 32, 256}) {
+		benchmark(
+			block_size,
+			gensimcell::Halo_Transport::point_to_point,
+			"point_to_point",
+			cart_comm
+		);
+		benchmark(
+			block_size,
+			gensimcell::Halo_Transport::neighbor_collective,
+			"neighbor_collective",
+			cart_comm
+		);
+		benchmark(
+			block_size,
+			gensimcell::Halo_Transport::one_sided,
+			"one_sided",
+			cart_comm
+		);
+		benchmark(
+			block_size,
+			gensimcell::Halo_Transport::shared_memory,
+			"shared_memory",
+			cart_comm
+		);
+	}
+
+	MPI_Comm_free(&cart_comm);
+	MPI_Finalize();
+
+	return EXIT_SUCCESS;
+}
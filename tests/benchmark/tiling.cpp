@@ -0,0 +1,283 @@
+/*
+Benchmark of tiled iteration over structured grids.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+
+Steps game of life and advection, ported from the serial examples,
+on periodic structured grids of several sizes, the largest of which
+don't fit into L2 or L3 cache, visiting cells row by row, one tile
+at a time and one tile at a time in several threads. Prints the
+time per cell and step of each. Run e.g. with make benchmark.
+*/
+
+#include "algorithm"
+#include "array"
+#include "chrono"
+#include "cmath"
+#include "cstdlib"
+#include "iomanip"
+#include "iostream"
+#include "string"
+#include "thread"
+
+#include "gensimcell.hpp"
+#include "structured_grid.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+
+struct Is_Alive { using data_type = bool; };
+struct Live_Neighbors { using data_type = int; };
+
+using Gol_Cell = gensimcell::Cell<
+	gensimcell::Never_Transfer,
+	Is_Alive,
+	Live_Neighbors
+>;
+
+struct Density { using data_type = double; };
+struct Density_Flux { using data_type = double; };
+struct Velocity { using data_type = array<double, 2>; };
+
+using Advection_Cell = gensimcell::Cell<
+	gensimcell::Never_Transfer,
+	Density,
+	Density_Flux,
+	Velocity
+>;
+
+template<class Cell_T> using Grid = gensimcell::Structured_Grid<Cell_T, 2>;
+using Index_T = Grid<Gol_Cell>::Index_T;
+using Size_T = Grid<Gol_Cell>::Size_T;
+
+// approximate number of cells to step in total for each grid size
+constexpr size_t cell_steps = size_t(1) << 25;
+
+
+/*!
+Visits cells of a grid either row by row, if tile
+size is empty, or one tile at a time in given threads.
+*/
+struct Iteration {
+	string name;
+	Size_T tile_size;
+	size_t threads;
+
+	template<class Grid_T, class Function> void operator()(
+		Grid_T& grid,
+		Function f
+	) const {
+		if (this->tile_size == Size_T{{0, 0}}) {
+			grid.for_each_cell(f);
+		} else {
+			grid.for_each_cell_tiled(this->tile_size, f, this->threads);
+		}
+	}
+
+	template<class Grid_T, size_t N, class Function> void operator()(
+		Grid_T& grid,
+		const array<ptrdiff_t, N>& offsets,
+		Function f
+	) const {
+		if (this->tile_size == Size_T{{0, 0}}) {
+			grid.for_each_cell(offsets, f);
+		} else {
+			grid.for_each_cell_tiled(this->tile_size, offsets, f, this->threads);
+		}
+	}
+};
+
+
+//! Steps game of life, see examples/game_of_life/serial.cpp.
+void step(Grid<Gol_Cell>& grid, const Iteration& iterate)
+{
+	grid.fill_periodic(Is_Alive());
+
+	const auto offsets = grid.get_offsets<8>({{
+		{{-1, -1}}, {{0, -1}}, {{1, -1}}, {{-1, 0}},
+		{{1, 0}}, {{-1, 1}}, {{0, 1}}, {{1, 1}}
+	}});
+	iterate(
+		grid,
+		offsets,
+		[](Gol_Cell& cell, const array<Gol_Cell*, 8>& neighbors, const Index_T&) {
+			for (const auto* neighbor: neighbors) {
+				if ((*neighbor)[Is_Alive()]) {
+					cell[Live_Neighbors()]++;
+				}
+			}
+		}
+	);
+
+	iterate(grid, [](Gol_Cell& cell, const Index_T&) {
+		if (cell[Live_Neighbors()] == 3) {
+			cell[Is_Alive()] = true;
+		} else if (cell[Live_Neighbors()] != 2) {
+			cell[Is_Alive()] = false;
+		}
+		cell[Live_Neighbors()] = 0;
+	});
+}
+
+
+//! Steps advection, see examples/advection/serial.cpp.
+void step(Grid<Advection_Cell>& grid, const Iteration& iterate)
+{
+	grid.fill_periodic(Density(), Velocity());
+
+	const array<double, 2> cell_size{{
+		2.0 / grid.get_size()[0],
+		2.0 / grid.get_size()[1]
+	}};
+	const double dt = 0.25 * min(cell_size[0], cell_size[1]);
+
+	const auto get_flux
+		= [&](const Advection_Cell& cell) -> array<double, 2> {
+			return {{
+				cell[Density()] * (cell[Velocity()][0] * dt / cell_size[0]),
+				cell[Density()] * (cell[Velocity()][1] * dt / cell_size[1])
+			}};
+		};
+
+	const auto offsets = grid.get_offsets<4>({{
+		{{-1, 0}}, {{1, 0}}, {{0, -1}}, {{0, 1}}
+	}});
+	iterate(
+		grid,
+		offsets,
+		[&](
+			Advection_Cell& cell,
+			const array<Advection_Cell*, 4>& neighbors,
+			const Index_T&
+		) {
+			const array<double, 2> flux = get_flux(cell);
+			cell[Density_Flux()]
+				+= max(get_flux(*neighbors[0])[0], 0.0)
+				+ max(-get_flux(*neighbors[1])[0], 0.0)
+				+ max(get_flux(*neighbors[2])[1], 0.0)
+				+ max(-get_flux(*neighbors[3])[1], 0.0)
+				- fabs(flux[0]) - fabs(flux[1]);
+		}
+	);
+
+	iterate(grid, [](Advection_Cell& cell, const Index_T&) {
+		cell[Density()] += cell[Density_Flux()];
+		cell[Density_Flux()] = 0;
+	});
+}
+
+
+void initialize(Grid<Gol_Cell>& grid)
+{
+	grid.for_each_cell([](Gol_Cell& cell, const Index_T& index) {
+		// something that doesn't die out immediately
+		cell[Is_Alive()] = (index[0] * 7 + index[1] * 13) % 5 < 2;
+		cell[Live_Neighbors()] = 0;
+	});
+}
+
+void initialize(Grid<Advection_Cell>& grid)
+{
+	const auto& size = grid.get_size();
+	grid.for_each_cell([&](Advection_Cell& cell, const Index_T& index) {
+		const double
+			x = -1.0 + (0.5 + index[0]) * 2.0 / size[0],
+			y = -1.0 + (0.5 + index[1]) * 2.0 / size[1];
+		cell[Density()] = (fabs(x) < 0.5 and fabs(y) < 0.5 ? 1 : 0);
+		cell[Density_Flux()] = 0;
+		cell[Velocity()] = {{2 * y, -2 * x}};
+	});
+}
+
+
+/*!
+Prints time per cell and step of stepping a grid
+of given size with each given iteration.
+*/
+template<class Cell_T> void benchmark(
+	const string& solver,
+	const size_t size,
+	const vector<Iteration>& iterations
+) {
+	for (const auto& iterate: iterations) {
+		Grid<Cell_T> grid({{size, size}}, 1);
+		initialize(grid);
+
+		const size_t steps = max<size_t>(1, cell_steps / (size * size));
+		// warm up
+		step(grid, iterate);
+
+		const auto start = steady_clock::now();
+		for (size_t i = 0; i < steps; i++) {
+			step(grid, iterate);
+		}
+		const double time = duration<double>(steady_clock::now() - start).count();
+
+		cout << setw(10) << left << solver << right
+			<< setw(7) << size
+			<< setw(10) << size * size * sizeof(Cell_T) / 1024
+			<< "   " << setw(18) << left << iterate.name << right
+			<< fixed << setprecision(3)
+			<< setw(10) << time / steps / (size * size) * 1e9
+			<< endl;
+	}
+}
+
+
+int main(int, char**)
+{
+	const size_t threads = max(2u, thread::hardware_concurrency());
+
+	const vector<Iteration> iterations{
+		{"rows", {{0, 0}}, 1},
+		{"tiles 64x64", {{64, 64}}, 1},
+		{"tiles 512x16", {{512, 16}}, 1},
+		{"tiles 64x64 x" + to_string(threads), {{64, 64}}, threads}
+	};
+
+	cout << setw(10) << left << "solver" << right
+		<< setw(7) << "size"
+		<< setw(10) << "KiB"
+		<< "   " << setw(18) << left << "iteration" << right
+		<< setw(10) << "ns/cell"
+		<< endl;
+
+	for (const size_t size: {128, 512, 2048, 4096}) {
+		benchmark<Gol_Cell>("gol", size, iterations);
+	}
+	for (const size_t size: {128, 512, 2048}) {
+		benchmark<Advection_Cell>("advection", size, iterations);
+	}
+
+	return EXIT_SUCCESS;
+}
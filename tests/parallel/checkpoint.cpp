@@ -0,0 +1,217 @@
+/*
+Tests saving and loading cells with checkpoint files.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+*/
+
+#include "array"
+#include "cstdint"
+#include "cstdio"
+#include "cstdlib"
+#include "fstream"
+#include "iostream"
+#include "iterator"
+#include "mpi.h"
+#include "string"
+#include "vector"
+
+#include "check_true.hpp"
+#include "checkpoint.hpp"
+#include "gensimcell.hpp"
+
+struct Count {
+	using data_type = int;
+};
+
+struct Vector3 {
+	using data_type = std::array<double, 3>;
+};
+
+struct Values {
+	using data_type = std::vector<double>;
+};
+
+using Cell_T = gensimcell::Cell<
+	gensimcell::Never_Transfer,
+	Count,
+	Vector3,
+	Values
+>;
+
+
+void set_values(Cell_T& cell, const int index)
+{
+	cell[Count()] = index;
+	cell[Vector3()] = {{index + 0.25, index + 0.5, index + 0.75}};
+	cell[Values()].resize(size_t(index % 5));
+	for (size_t i = 0; i < cell[Values()].size(); i++) {
+		cell[Values()][i] = index * 10.0 + i;
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
+		std::cerr << "Couldn't initialize MPI." << std::endl;
+		abort();
+	}
+
+	MPI_Comm comm = MPI_COMM_WORLD;
+
+	int rank = 0, comm_size = 0;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &comm_size);
+
+	const char file_name[] = "tests/parallel/checkpoint.gc";
+
+	// save with different number of cells than when loading
+	int first_index = 0;
+	for (int i = 0; i < rank; i++) {
+		first_index += 3 + i;
+	}
+	std::vector<Cell_T> saved(size_t(3 + rank));
+	for (size_t i = 0; i < saved.size(); i++) {
+		set_values(saved[i], first_index + int(i));
+	}
+
+	CHECK_TRUE(
+		gensimcell::save_checkpoint(
+			file_name,
+			comm,
+			saved.cbegin(),
+			saved.cend(),
+			Count(),
+			Vector3(),
+			Values()
+		)
+	)
+
+	first_index = 0;
+	for (int i = 0; i < rank; i++) {
+		first_index += 3 + (comm_size - 1 - i);
+	}
+	std::vector<Cell_T> loaded(size_t(3 + comm_size - 1 - rank));
+	for (auto& cell: loaded) {
+		cell[Count()] = -1;
+	}
+
+	// load only some of the variables in different order
+	CHECK_TRUE(
+		gensimcell::load_checkpoint(
+			file_name,
+			comm,
+			loaded.begin(),
+			loaded.end(),
+			Values(),
+			Vector3()
+		)
+	)
+	for (size_t i = 0; i < loaded.size(); i++) {
+		Cell_T reference;
+		set_values(reference, first_index + int(i));
+
+		CHECK_TRUE(loaded[i][Count()] == -1)
+		CHECK_TRUE(loaded[i][Vector3()] == reference[Vector3()])
+		CHECK_TRUE(loaded[i][Values()] == reference[Values()])
+	}
+
+	CHECK_TRUE(
+		gensimcell::load_checkpoint(
+			file_name,
+			comm,
+			loaded.begin(),
+			loaded.end(),
+			Count()
+		)
+	)
+	for (size_t i = 0; i < loaded.size(); i++) {
+		CHECK_TRUE(loaded[i][Count()] == first_index + int(i))
+	}
+
+	// wrong number of cells
+	CHECK_TRUE(
+		not gensimcell::load_checkpoint(
+			file_name,
+			comm,
+			loaded.begin() + 1,
+			loaded.end(),
+			Count()
+		)
+	)
+
+	// same variable name with different data type
+	MPI_Barrier(comm);
+	if (rank == 0) {
+		std::fstream file(file_name, std::ios::in | std::ios::out | std::ios::binary);
+		std::string contents(
+			(std::istreambuf_iterator<char>(file)),
+			std::istreambuf_iterator<char>()
+		);
+		const uint64_t length = 3;
+		const std::string type_name
+			= std::string(reinterpret_cast<const char*>(&length), sizeof(length))
+			+ "int";
+		const auto position = contents.find(type_name);
+		CHECK_TRUE(position != std::string::npos)
+		file.seekp(std::streamoff(position + sizeof(length)));
+		file.write("flt", 3);
+	}
+	MPI_Barrier(comm);
+
+	CHECK_TRUE(
+		not gensimcell::load_checkpoint(
+			file_name,
+			comm,
+			loaded.begin(),
+			loaded.end(),
+			Count()
+		)
+	)
+	CHECK_TRUE(
+		gensimcell::load_checkpoint(
+			file_name,
+			comm,
+			loaded.begin(),
+			loaded.end(),
+			Vector3()
+		)
+	)
+
+	MPI_Barrier(comm);
+	if (rank == 0) {
+		std::remove(file_name);
+	}
+
+	MPI_Finalize();
+
+	return EXIT_SUCCESS;
+}
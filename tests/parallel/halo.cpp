@@ -0,0 +1,167 @@
+/*
+Tests exchange of cell data between neighboring processes.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "cstdlib"
+#include "iostream"
+#include "mpi.h"
+#include "vector"
+
+#include "check_true.hpp"
+#include "gensimcell.hpp"
+#include "halo.hpp"
+
+struct Id {
+	using data_type = int;
+};
+
+struct Values {
+	using data_type = std::vector<double>;
+};
+
+struct Not_Transferred {
+	using data_type = int;
+};
+
+using Cell_T = gensimcell::Cell<
+	gensimcell::Optional_Transfer,
+	Id,
+	Values,
+	Not_Transferred
+>;
+
+// direction in which data travels
+enum {positive, negative};
+
+constexpr int cells_per_process = 4;
+
+
+/*!
+Checks that ghost cells of a periodic 1d grid with
+given number of cells per process have correct data.
+*/
+void check_ghosts(
+	const std::vector<Cell_T>& ghosts,
+	const int rank,
+	const int comm_size
+) {
+	const int
+		total_cells = cells_per_process * comm_size,
+		previous_id = (rank * cells_per_process + total_cells - 1) % total_cells,
+		next_id = ((rank + 1) * cells_per_process) % total_cells;
+
+	CHECK_TRUE(ghosts[0][Id()] == previous_id)
+	CHECK_TRUE(ghosts[0][Values()].size() == size_t(previous_id % 3))
+	for (const auto value: ghosts[0][Values()]) {
+		CHECK_TRUE(value == previous_id)
+	}
+	CHECK_TRUE(ghosts[0][Not_Transferred()] == -1)
+
+	CHECK_TRUE(ghosts[1][Id()] == next_id)
+	CHECK_TRUE(ghosts[1][Values()].size() == size_t(next_id % 3))
+	for (const auto value: ghosts[1][Values()]) {
+		CHECK_TRUE(value == next_id)
+	}
+	CHECK_TRUE(ghosts[1][Not_Transferred()] == -1)
+}
+
+
+int main(int argc, char* argv[])
+{
+	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
+		std::cerr << "Couldn't initialize MPI." << std::endl;
+		abort();
+	}
+
+	MPI_Comm comm = MPI_COMM_WORLD;
+	int rank = -1, comm_size = -1;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &comm_size);
+
+	const int
+		previous = (rank + comm_size - 1) % comm_size,
+		next = (rank + 1) % comm_size;
+
+	std::vector<Cell_T> cells(cells_per_process), ghosts(2);
+	for (int i = 0; i < cells_per_process; i++) {
+		const int id = rank * cells_per_process + i;
+		cells[i][Id()] = id;
+		cells[i][Values()].resize(id % 3, id);
+		cells[i][Not_Transferred()] = id;
+	}
+
+	gensimcell::Halo<Cell_T> halo;
+	halo.add_send(next, positive, cells.back());
+	halo.add_send(previous, negative, cells.front());
+	halo.add_receive(previous, positive, ghosts.front());
+	halo.add_receive(next, negative, ghosts.back());
+	CHECK_TRUE(not halo.exchange())
+	CHECK_TRUE(halo.initialize(comm))
+	CHECK_TRUE(halo.get_send_processes().size() == (comm_size > 2 ? 2u : 1u))
+
+	Cell_T::set_transfer_all(true, Id(), Values());
+
+	for (const auto transport: {
+		gensimcell::Halo_Transport::point_to_point,
+		gensimcell::Halo_Transport::neighbor_collective,
+		gensimcell::Halo_Transport::one_sided,
+		gensimcell::Halo_Transport::shared_memory
+	}) {
+		if (not halo.is_supported(transport)) {
+			CHECK_TRUE(not halo.exchange(transport))
+			continue;
+		}
+
+		for (auto& ghost: ghosts) {
+			ghost[Id()] = ghost[Not_Transferred()] = -1;
+			ghost[Values()].clear();
+		}
+
+		// sizes of variable length data first
+		Cell_T::set_transfer_all(false, Values());
+		CHECK_TRUE(halo.exchange(transport))
+		for (auto& ghost: ghosts) {
+			ghost[Values()].resize(ghost[Id()] % 3);
+		}
+
+		Cell_T::set_transfer_all(true, Values());
+		CHECK_TRUE(halo.start(transport))
+		CHECK_TRUE(not halo.start(transport))
+		CHECK_TRUE(halo.wait())
+
+		check_ghosts(ghosts, rank, comm_size);
+	}
+
+	MPI_Finalize();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+/*
+Tests reductions of variables over cells of all processes.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "cstdlib"
+#include "iostream"
+#include "limits"
+#include "mpi.h"
+#include "tuple"
+#include "vector"
+
+#include "check_true.hpp"
+#include "gensimcell.hpp"
+#include "reduce.hpp"
+
+struct Is_Alive {
+	using data_type = bool;
+};
+
+struct Density {
+	using data_type = double;
+};
+
+struct Id {
+	using data_type = unsigned long long int;
+};
+
+struct Level {
+	using data_type = signed char;
+};
+
+using Cell_T = gensimcell::Cell<
+	gensimcell::Never_Transfer,
+	Is_Alive,
+	Density,
+	Id,
+	Level
+>;
+
+
+int main(int argc, char* argv[])
+{
+	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
+		std::cerr << "Couldn't initialize MPI." << std::endl;
+		abort();
+	}
+
+	MPI_Comm comm = MPI_COMM_WORLD;
+	int rank = -1, comm_size = -1;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &comm_size);
+
+	// cell ids rank, rank + comm_size, ... below total_cells
+	constexpr unsigned long long int total_cells = 1001;
+	std::vector<Cell_T> cells;
+	for (auto id = (unsigned long long int) rank; id < total_cells; id += comm_size) {
+		cells.emplace_back();
+		cells.back()[Is_Alive()] = (id % 3 == 0);
+		cells.back()[Density()] = 0.5 * id;
+		cells.back()[Id()] = id;
+		cells.back()[Level()] = -(signed char)(id % 5);
+	}
+
+	// local
+	const auto local = gensimcell::reduce(
+		cells.cbegin(), cells.cend(), gensimcell::Sum(), Is_Alive(), Id()
+	);
+	unsigned long long int local_ids = 0;
+	int local_alive = 0;
+	for (const auto& cell: cells) {
+		local_ids += cell[Id()];
+		local_alive += cell[Is_Alive()];
+	}
+	CHECK_TRUE(std::get<0>(local) == local_alive)
+	CHECK_TRUE(std::get<1>(local) == local_ids)
+
+	// threads give identical results
+	for (const size_t threads: {1, 2, 3, 7, 5000}) {
+		CHECK_TRUE(
+			gensimcell::reduce(
+				threads, cells.cbegin(), cells.cend(), gensimcell::Sum(), Is_Alive(), Id()
+			) == local
+		)
+	}
+
+	// pointers to cells
+	std::vector<const Cell_T*> cell_pointers;
+	for (const auto& cell: cells) {
+		cell_pointers.push_back(&cell);
+	}
+	CHECK_TRUE(
+		gensimcell::reduce(
+			cell_pointers.cbegin(), cell_pointers.cend(), gensimcell::Sum(), Is_Alive(), Id()
+		) == local
+	)
+
+	// empty range gives identity
+	CHECK_TRUE(
+		std::get<0>(gensimcell::reduce(
+			cells.cend(), cells.cend(), gensimcell::Min(), Density()
+		)) == std::numeric_limits<double>::max()
+	)
+
+	// global, all variables in one collective
+	const auto sums = gensimcell::all_reduce(
+		comm, cells.cbegin(), cells.cend(), gensimcell::Sum(), Is_Alive(), Density(), Id()
+	);
+	CHECK_TRUE(std::get<0>(sums) == (total_cells + 2) / 3)
+	CHECK_TRUE(std::get<1>(sums) == 0.25 * total_cells * (total_cells - 1))
+	CHECK_TRUE(std::get<2>(sums) == total_cells * (total_cells - 1) / 2)
+
+	const auto minimums = gensimcell::all_reduce(
+		comm, 2, cells.cbegin(), cells.cend(), gensimcell::Min(), Density(), Id(), Level()
+	);
+	CHECK_TRUE(std::get<0>(minimums) == 0)
+	CHECK_TRUE(std::get<1>(minimums) == 0)
+	CHECK_TRUE(std::get<2>(minimums) == -4)
+
+	const auto maximums = gensimcell::all_reduce(
+		comm, cells.cbegin(), cells.cend(), gensimcell::Max(), Density(), Id(), Level()
+	);
+	CHECK_TRUE(std::get<0>(maximums) == 0.5 * (total_cells - 1))
+	CHECK_TRUE(std::get<1>(maximums) == total_cells - 1)
+	CHECK_TRUE(std::get<2>(maximums) == 0)
+
+	MPI_Finalize();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,206 @@
+/*
+Runs parallel examples with different numbers of processes and grid sizes.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+Usage: scaling.exe mpi_command max_processes [program ...]
+where mpi_command followed by the number of processes launches
+a program, for example "mpirun --oversubscribe -n" which allows
+using more processes than there are cores on one machine.
+Programs must accept the number of cells in x and y dimensions as
+their first argument and print their phase times in the format of
+examples/phase_timer.hpp, by default the dccrg versions of game of
+life, advection, particle propagation and combined examples are run.
+
+Results are printed to standard output in CSV format with strong
+scaling efficiency t(1) / (n * t(n)) for fixed grid sizes and weak
+scaling efficiency t(1) / t(n) for grid sizes that keep the number
+of cells per process approximately constant, where t(n) is the
+maximum total time over processes with n processes.
+*/
+
+#include "cmath"
+#include "cstdio"
+#include "cstdlib"
+#include "iostream"
+#include "map"
+#include "sstream"
+#include "string"
+#include "vector"
+
+using namespace std;
+
+
+/*!
+Runs given program with given number of processes and grid size.
+
+Returns time of each phase reported by the program.
+*/
+map<string, double> run(
+	const string& mpi_command,
+	const string& program,
+	const int processes,
+	const int grid_size
+) {
+	const string command
+		= mpi_command + " " + to_string(processes)
+		+ " " + program + " " + to_string(grid_size);
+
+	FILE* output = popen(command.c_str(), "r");
+	if (output == NULL) {
+		cerr << __FILE__ << ":" << __LINE__
+			<< " Couldn't run " << command << endl;
+		abort();
+	}
+
+	map<string, double> phase_times;
+	char buffer[1024];
+	while (fgets(buffer, sizeof(buffer), output) != NULL) {
+		istringstream line(buffer);
+		string word;
+		line >> word;
+		if (word != "phase_times") {
+			continue;
+		}
+
+		string phase;
+		double time;
+		while (line >> phase >> time) {
+			phase_times[phase] = time;
+		}
+	}
+
+	if (pclose(output) != EXIT_SUCCESS or phase_times.count("total") == 0) {
+		cerr << __FILE__ << ":" << __LINE__
+			<< " Running " << command << " failed, "
+			"was this program run from the gensimcell directory?"
+			<< endl;
+		abort();
+	}
+
+	return phase_times;
+}
+
+
+void print_result(
+	const string& program,
+	const string& scaling,
+	const int processes,
+	const int grid_size,
+	map<string, double>& phase_times,
+	const double efficiency
+) {
+	cout
+		<< program << ","
+		<< scaling << ","
+		<< processes << ","
+		<< grid_size << ","
+		<< grid_size * grid_size << ","
+		<< phase_times["solve"] << ","
+		<< phase_times["wait"] << ","
+		<< phase_times["apply"] << ","
+		<< phase_times["save"] << ","
+		<< phase_times["total"] << ","
+		<< efficiency << endl;
+}
+
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3) {
+		cerr << "Usage: " << argv[0]
+			<< " \"mpirun --oversubscribe -n\" max_processes [program ...]"
+			<< endl;
+		abort();
+	}
+
+	const string mpi_command(argv[1]);
+	const int max_processes = atoi(argv[2]);
+	if (max_processes < 1) {
+		cerr << "Maximum number of processes must be at least 1" << endl;
+		abort();
+	}
+
+	vector<string> programs;
+	for (int i = 3; i < argc; i++) {
+		programs.push_back(argv[i]);
+	}
+	if (programs.size() == 0) {
+		programs = {
+			"examples/game_of_life/parallel/main.dexe",
+			"examples/advection/parallel/main.dexe",
+			"examples/particle_propagation/parallel/main.dexe",
+			"examples/combined/parallel.dexe"
+		};
+	}
+
+	const vector<int>
+		strong_grid_sizes{20, 40, 80},
+		weak_grid_sizes{20, 40};
+
+	cout << "program,scaling,processes,grid_size,cells,"
+		"solve,wait,apply,save,total,efficiency" << endl;
+
+	for (const auto& program: programs) {
+
+		for (const auto grid_size: strong_grid_sizes) {
+			double serial_time = 0;
+			for (int processes = 1; processes <= max_processes; processes++) {
+				auto phase_times = run(mpi_command, program, processes, grid_size);
+				if (processes == 1) {
+					serial_time = phase_times["total"];
+				}
+				print_result(
+					program, "strong", processes, grid_size, phase_times,
+					serial_time / (processes * phase_times["total"])
+				);
+			}
+		}
+
+		for (const auto base_grid_size: weak_grid_sizes) {
+			double serial_time = 0;
+			for (int processes = 1; processes <= max_processes; processes++) {
+				const int grid_size
+					= int(round(base_grid_size * sqrt(double(processes))));
+				auto phase_times = run(mpi_command, program, processes, grid_size);
+				if (processes == 1) {
+					serial_time = phase_times["total"];
+				}
+				print_result(
+					program, "weak", processes, grid_size, phase_times,
+					serial_time / phase_times["total"]
+				);
+			}
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,117 @@
+/*
+Tests exchange of data between processes that don't know who sends to them.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "cstdlib"
+#include "iostream"
+#include "mpi.h"
+#include "vector"
+
+#include "check_true.hpp"
+#include "sparse_exchange.hpp"
+
+struct Item {
+	int sender, receiver, round, index;
+};
+
+
+//! Returns the number of items sent from sender to receiver in given round.
+int get_nr_items(const int sender, const int receiver, const int round)
+{
+	// most processes don't send to each other
+	if ((sender * 7 + receiver * 3 + round) % 4 != 0) {
+		return 0;
+	}
+	return 1 + (sender + receiver + round) % 5;
+}
+
+
+int main(int argc, char* argv[])
+{
+	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
+		std::cerr << "Couldn't initialize MPI." << std::endl;
+		abort();
+	}
+
+	MPI_Comm comm = MPI_COMM_WORLD;
+	int rank = -1, comm_size = -1;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &comm_size);
+
+	gensimcell::Sparse_Exchange<Item> exchange;
+
+	for (int round = 0; round < 20; round++) {
+		size_t expected_sends = 0;
+		for (int receiver = 0; receiver < comm_size; receiver++) {
+			const int nr_items = get_nr_items(rank, receiver, round);
+			if (nr_items > 0) {
+				expected_sends++;
+			}
+			for (int i = 0; i < nr_items; i++) {
+				exchange.get_send_items(receiver).push_back({rank, receiver, round, i});
+			}
+		}
+
+		std::vector<int> received(comm_size, 0);
+		CHECK_TRUE(exchange.exchange(
+			comm,
+			[&](const int sender, const std::vector<Item>& items) {
+				CHECK_TRUE(sender >= 0 and sender < comm_size)
+				CHECK_TRUE(received[sender] == 0)
+				CHECK_TRUE(int(items.size()) == get_nr_items(sender, rank, round))
+				for (size_t i = 0; i < items.size(); i++) {
+					CHECK_TRUE(items[i].sender == sender)
+					CHECK_TRUE(items[i].receiver == rank)
+					CHECK_TRUE(items[i].round == round)
+					CHECK_TRUE(items[i].index == int(i))
+				}
+				received[sender]++;
+			},
+			10
+		))
+
+		size_t expected_receives = 0;
+		for (int sender = 0; sender < comm_size; sender++) {
+			const bool sends = get_nr_items(sender, rank, round) > 0;
+			CHECK_TRUE(received[sender] == (sends ? 1 : 0))
+			if (sends) {
+				expected_receives++;
+			}
+		}
+		CHECK_TRUE(exchange.get_sent_messages() == expected_sends)
+		CHECK_TRUE(exchange.get_received_messages() == expected_receives)
+	}
+
+	MPI_Finalize();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+/*
+Tests statistics of variables included in MPI transfers.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#define GENSIMCELL_STATISTICS
+
+#include "cstdlib"
+#include "iostream"
+#include "mpi.h"
+#include "sstream"
+#include "string"
+#include "tuple"
+#include "vector"
+
+#include "check_true.hpp"
+#include "gensimcell.hpp"
+
+struct Scalar {
+	using data_type = int;
+};
+
+struct Values {
+	using data_type = std::vector<double>;
+};
+
+struct Rank_Specific {
+	using data_type = char;
+};
+
+using Cell_T = gensimcell::Cell<
+	gensimcell::Optional_Transfer,
+	Scalar,
+	Values
+>;
+
+
+void free_datatype(const std::tuple<void*, int, MPI_Datatype>& transfer_info)
+{
+	MPI_Datatype datatype = std::get<2>(transfer_info);
+	gensimcell::detail::free_derived_datatype(datatype);
+}
+
+
+int main(int argc, char* argv[])
+{
+	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
+		std::cerr << "Couldn't initialize MPI." << std::endl;
+		abort();
+	}
+
+	MPI_Comm comm = MPI_COMM_WORLD;
+
+	int rank = 0, comm_size = 0;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &comm_size);
+
+	Cell_T cell;
+	cell[Values()].resize(3);
+
+	// include both variables twice
+	cell.set_transfer_all(true, Scalar(), Values());
+	free_datatype(cell.get_mpi_datatype());
+	free_datatype(cell.get_mpi_datatype());
+
+	// include only scalar
+	cell.set_transfer_all(false, Values());
+	free_datatype(cell.get_mpi_datatype());
+
+	auto statistics = gensimcell::get_statistics();
+	CHECK_TRUE(statistics.at("Scalar").inclusions == 3)
+	CHECK_TRUE(statistics.at("Scalar").exclusions == 0)
+	CHECK_TRUE(statistics.at("Scalar").bytes == 3 * sizeof(int))
+	CHECK_TRUE(statistics.at("Values").inclusions == 2)
+	CHECK_TRUE(statistics.at("Values").exclusions == 1)
+	CHECK_TRUE(statistics.at("Values").bytes == 2 * 3 * sizeof(double))
+	CHECK_TRUE(statistics.at("Values").construction_time >= 0)
+
+	// variables recorded only by some processes
+	if (rank == 0) {
+		gensimcell::Cell<gensimcell::Always_Transfer, Rank_Specific> rank_cell;
+		free_datatype(rank_cell.get_mpi_datatype());
+	}
+
+	std::ostringstream report;
+	gensimcell::report_statistics(report, comm);
+	if (rank == 0) {
+		const std::string result = report.str();
+		CHECK_TRUE(result.find("Rank_Specific") != std::string::npos)
+
+		std::ostringstream total_scalar;
+		total_scalar << 3 * comm_size;
+		const auto total_start = result.find("   total");
+		CHECK_TRUE(total_start != std::string::npos)
+		const auto scalar_line = result.find("Scalar", total_start);
+		CHECK_TRUE(
+			result.substr(total_start, scalar_line - total_start).find(total_scalar.str())
+			!= std::string::npos
+		)
+	} else {
+		CHECK_TRUE(report.str().size() == 0)
+	}
+
+	gensimcell::reset_statistics();
+	statistics = gensimcell::get_statistics();
+	CHECK_TRUE(statistics.at("Scalar").inclusions == 0)
+	CHECK_TRUE(statistics.at("Values").bytes == 0)
+
+	MPI_Finalize();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,260 @@
+/*
+Tests exchange of ghost cells of structured grids between processes.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+*/
+
+#include "array"
+#include "cstddef"
+#include "cstdlib"
+#include "iostream"
+#include "mpi.h"
+
+#include "check_true.hpp"
+#include "gensimcell.hpp"
+#include "structured_halo.hpp"
+
+struct Id {
+	using data_type = long long int;
+};
+
+struct Is_Alive {
+	using data_type = bool;
+};
+
+struct Live_Neighbors {
+	using data_type = int;
+};
+
+using Cell_T = gensimcell::Cell<
+	gensimcell::Optional_Transfer,
+	Id,
+	Is_Alive,
+	Live_Neighbors
+>;
+
+
+/*!
+Returns Cartesian communicator of given number of
+dimensions, periodic in all of them.
+*/
+template<std::size_t Dimensions> MPI_Comm get_cart_comm()
+{
+	int comm_size = -1;
+	MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+
+	std::array<int, Dimensions> dimensions, periodic;
+	dimensions.fill(0);
+	periodic.fill(1);
+	MPI_Dims_create(comm_size, int(Dimensions), dimensions.data());
+
+	MPI_Comm cart_comm;
+	MPI_Cart_create(
+		MPI_COMM_WORLD,
+		int(Dimensions),
+		dimensions.data(),
+		periodic.data(),
+		0,
+		&cart_comm
+	);
+	return cart_comm;
+}
+
+
+/*!
+Checks that all ghost cells of a periodic grid with given
+local size per process have their wrapped global index.
+*/
+template<std::size_t Dimensions> void check_ghosts(
+	const typename gensimcell::Structured_Grid<Cell_T, Dimensions>::Size_T& size,
+	const std::size_t ghost_width
+) {
+	using Grid_T = gensimcell::Structured_Grid<Cell_T, Dimensions>;
+	using Index_T = typename Grid_T::Index_T;
+
+	MPI_Comm cart_comm = get_cart_comm<Dimensions>();
+	std::array<int, Dimensions> dimensions, periodic, coordinates;
+	MPI_Cart_get(
+		cart_comm,
+		int(Dimensions),
+		dimensions.data(),
+		periodic.data(),
+		coordinates.data()
+	);
+
+	// returns global id of cell at given local index wrapped periodically
+	const auto get_id = [&](const Index_T& index) {
+		long long int id = 0, stride = 1;
+		for (std::size_t d = 0; d < Dimensions; d++) {
+			const long long int
+				length = (long long int)(size[d]) * dimensions[d],
+				global = coordinates[d] * (long long int)(size[d]) + index[d];
+			id += ((global % length + length) % length) * stride;
+			stride *= length;
+		}
+		return id;
+	};
+
+	Grid_T grid(size, ghost_width);
+	grid.for_each_cell(ghost_width, [&](Cell_T& cell, const Index_T&) {
+		cell[Id()] = -1;
+	});
+	grid.for_each_cell([&](Cell_T& cell, const Index_T& index) {
+		cell[Id()] = get_id(index);
+	});
+
+	gensimcell::Structured_Halo<Cell_T, Dimensions> halo;
+	CHECK_TRUE(halo.initialize(grid, cart_comm))
+
+	Cell_T::set_transfer_all(true, Id());
+	CHECK_TRUE(halo.exchange())
+	Cell_T::set_transfer_all(false, Id());
+
+	grid.for_each_cell(ghost_width, [&](const Cell_T& cell, const Index_T& index) {
+		CHECK_TRUE(cell[Id()] == get_id(index))
+	});
+
+	MPI_Comm_free(&cart_comm);
+}
+
+
+/*!
+Plays game of life with a glider for given number of turns
+exchanging ghost cells every ghost_width turns and returns
+the number of live cells in given global area on all processes.
+*/
+long long int play(
+	const std::size_t turns,
+	const std::size_t ghost_width,
+	const std::array<long long int, 4>& live_area
+) {
+	using Grid_T = gensimcell::Structured_Grid<Cell_T, 2>;
+	using Index_T = Grid_T::Index_T;
+
+	constexpr std::ptrdiff_t size = 6;
+
+	MPI_Comm cart_comm = get_cart_comm<2>();
+	std::array<int, 2> dimensions, periodic, coordinates;
+	MPI_Cart_get(cart_comm, 2, dimensions.data(), periodic.data(), coordinates.data());
+
+	Grid_T grid({{size, size}}, ghost_width);
+	grid.for_each_cell(ghost_width, [&](Cell_T& cell, const Index_T& index) {
+		const std::array<std::ptrdiff_t, 2> global{{
+			coordinates[0] * size + index[0],
+			coordinates[1] * size + index[1]
+		}};
+		cell[Is_Alive()]
+			= (global == std::array<std::ptrdiff_t, 2>{{2, 1}})
+			or (global == std::array<std::ptrdiff_t, 2>{{3, 2}})
+			or (global[1] == 3 and global[0] >= 1 and global[0] <= 3);
+		cell[Live_Neighbors()] = 0;
+	});
+
+	gensimcell::Structured_Halo<Cell_T, 2> halo;
+	CHECK_TRUE(halo.initialize(grid, cart_comm))
+
+	const auto offsets = grid.get_offsets<8>({{
+		{{-1, -1}}, {{0, -1}}, {{1, -1}}, {{-1, 0}},
+		{{1, 0}}, {{-1, 1}}, {{0, 1}}, {{1, 1}}
+	}});
+
+	Cell_T::set_transfer_all(true, Is_Alive());
+	for (std::size_t turn = 0; turn < turns; turn++) {
+		const std::size_t margin = ghost_width - 1 - turn % ghost_width;
+		if (margin == ghost_width - 1) {
+			CHECK_TRUE(halo.exchange())
+		}
+
+		grid.for_each_cell(
+			margin,
+			offsets,
+			[](Cell_T& cell, const std::array<Cell_T*, 8>& neighbors, const Index_T&) {
+				for (const auto* neighbor: neighbors) {
+					if ((*neighbor)[Is_Alive()]) {
+						cell[Live_Neighbors()]++;
+					}
+				}
+			}
+		);
+		grid.for_each_cell(margin, [](Cell_T& cell, const Index_T&) {
+			if (cell[Live_Neighbors()] == 3) {
+				cell[Is_Alive()] = true;
+			} else if (cell[Live_Neighbors()] != 2) {
+				cell[Is_Alive()] = false;
+			}
+			cell[Live_Neighbors()] = 0;
+		});
+	}
+	Cell_T::set_transfer_all(false, Is_Alive());
+
+	long long int live_cells = 0;
+	grid.for_each_cell([&](const Cell_T& cell, const Index_T& index) {
+		const std::array<std::ptrdiff_t, 2> global{{
+			coordinates[0] * size + index[0],
+			coordinates[1] * size + index[1]
+		}};
+		if (
+			cell[Is_Alive()]
+			and global[0] >= live_area[0] and global[0] <= live_area[1]
+			and global[1] >= live_area[2] and global[1] <= live_area[3]
+		) {
+			live_cells++;
+		}
+	});
+	MPI_Allreduce(MPI_IN_PLACE, &live_cells, 1, MPI_LONG_LONG_INT, MPI_SUM, cart_comm);
+
+	MPI_Comm_free(&cart_comm);
+	return live_cells;
+}
+
+
+int main(int argc, char* argv[])
+{
+	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
+		std::cerr << "Couldn't initialize MPI." << std::endl;
+		abort();
+	}
+
+	check_ghosts<1>({{3}}, 2);
+	check_ghosts<2>({{4, 3}}, 1);
+	check_ghosts<2>({{5, 4}}, 3);
+	check_ghosts<3>({{3, 2, 4}}, 2);
+
+	// glider moves one cell in x and y every 4 turns and has 5 cells
+	for (const std::size_t ghost_width: {1, 2, 3, 4}) {
+		CHECK_TRUE(play(8, ghost_width, {{3, 5, 3, 5}}) == 5)
+		CHECK_TRUE(play(9, ghost_width, {{0, 1000, 0, 1000}}) == 5)
+	}
+
+	MPI_Finalize();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,252 @@
+/*
+Tests writing cells into VTK files.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "array"
+#include "cstdint"
+#include "cstdio"
+#include "cstdlib"
+#include "cstring"
+#include "fstream"
+#include "iostream"
+#include "iterator"
+#include "mpi.h"
+#include "string"
+#include "vector"
+
+#include "check_true.hpp"
+#include "gensimcell.hpp"
+#include "vtk_writer.hpp"
+
+struct Scalar {
+	using data_type = double;
+};
+
+struct Vector2 {
+	using data_type = std::array<float, 2>;
+};
+
+struct Flag {
+	using data_type = bool;
+};
+
+template<class T> struct Tagged {
+	using data_type = T;
+};
+
+using Cell_T = gensimcell::Cell<
+	gensimcell::Never_Transfer,
+	Scalar,
+	Vector2,
+	Flag,
+	Tagged<int>
+>;
+
+
+//! Returns the contents of given file.
+std::string read_file(const std::string& file_name)
+{
+	std::ifstream file(file_name, std::ios::binary);
+	return std::string(
+		std::istreambuf_iterator<char>(file),
+		std::istreambuf_iterator<char>()
+	);
+}
+
+
+/*!
+Returns the start of appended data of array
+with given name in given .vtu file contents.
+*/
+size_t get_array_start(const std::string& contents, const std::string& name)
+{
+	const std::string appended = "<AppendedData encoding=\"raw\">\n_";
+	const size_t data_start = contents.find(appended) + appended.size();
+
+	const size_t array_start = contents.find("Name=\"" + name + "\"");
+	const size_t offset_start
+		= contents.find("offset=\"", array_start) + std::strlen("offset=\"");
+
+	return data_start + std::stoul(contents.substr(offset_start));
+}
+
+
+int main(int argc, char* argv[])
+{
+	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
+		std::cerr << "Couldn't initialize MPI." << std::endl;
+		abort();
+	}
+
+	MPI_Comm comm = MPI_COMM_WORLD;
+
+	int rank = 0, comm_size = 0;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &comm_size);
+
+	const std::string prefix = "tests/parallel/vtk_writer";
+
+	std::vector<Cell_T> cells(size_t(2 + rank));
+	std::vector<const Cell_T*> cell_pointers;
+	std::vector<std::array<double, 3>> cell_min, cell_max;
+	for (size_t i = 0; i < cells.size(); i++) {
+		cells[i][Scalar()] = rank + 0.5 * i;
+		cells[i][Vector2()] = {{float(i), float(-rank)}};
+		cells[i][Flag()] = (i % 2 == 0);
+		cells[i][Tagged<int>()] = int(i);
+
+		cell_pointers.push_back(&cells[i]);
+		cell_min.push_back({{double(i), double(rank), 0}});
+		cell_max.push_back({{i + 1.0, rank + 1.0, 1}});
+	}
+
+	CHECK_TRUE(
+		gensimcell::save_vtk(
+			prefix,
+			comm,
+			cell_pointers,
+			cell_min,
+			cell_max,
+			Scalar(),
+			Vector2(),
+			Flag(),
+			Tagged<int>()
+		)
+	)
+
+	// wrong number of bounding boxes
+	cell_min.pop_back();
+	CHECK_TRUE(
+		not gensimcell::save_vtk(
+			prefix + "_failure",
+			comm,
+			cell_pointers,
+			cell_min,
+			cell_max,
+			Scalar()
+		)
+	)
+
+	const std::string vtu_name = prefix + "_" + std::to_string(rank) + ".vtu";
+	const std::string vtu = read_file(vtu_name);
+	CHECK_TRUE(
+		vtu.find("NumberOfCells=\"" + std::to_string(cells.size()) + "\"")
+		!= std::string::npos
+	)
+	CHECK_TRUE(
+		vtu.find("<DataArray type=\"Float32\" Name=\"Vector2\" NumberOfComponents=\"2\"")
+		!= std::string::npos
+	)
+	CHECK_TRUE(vtu.substr(vtu.size() - 11) == "</VTKFile>\n")
+
+	// name of templated variable must be escaped
+	CHECK_TRUE(vtu.find("Name=\"Tagged&lt;int&gt;\"") != std::string::npos)
+	CHECK_TRUE(vtu.find("Tagged<") == std::string::npos)
+
+	// check number of bytes and values of each array
+	uint64_t number_of_bytes = 0;
+	std::memcpy(
+		&number_of_bytes,
+		vtu.data() + get_array_start(vtu, "Scalar"),
+		sizeof(uint64_t)
+	);
+	CHECK_TRUE(number_of_bytes == cells.size() * sizeof(double))
+
+	for (size_t i = 0; i < cells.size(); i++) {
+		double scalar = -1;
+		std::memcpy(
+			&scalar,
+			vtu.data()
+				+ get_array_start(vtu, "Scalar")
+				+ sizeof(uint64_t)
+				+ i * sizeof(double),
+			sizeof(double)
+		);
+		CHECK_TRUE(scalar == cells[i][Scalar()])
+
+		std::array<float, 2> vector{{0, 0}};
+		std::memcpy(
+			vector.data(),
+			vtu.data()
+				+ get_array_start(vtu, "Vector2")
+				+ sizeof(uint64_t)
+				+ i * sizeof(vector),
+			sizeof(vector)
+		);
+		CHECK_TRUE(vector == cells[i][Vector2()])
+
+		uint8_t flag = 2;
+		std::memcpy(
+			&flag,
+			vtu.data()
+				+ get_array_start(vtu, "Flag")
+				+ sizeof(uint64_t)
+				+ i,
+			1
+		);
+		CHECK_TRUE(flag == (cells[i][Flag()] ? 1 : 0))
+	}
+
+	// last corner of last cell
+	std::array<double, 3> corner{{0, 0, 0}};
+	std::memcpy(
+		corner.data(),
+		vtu.data()
+			+ get_array_start(vtu, "connectivity")
+			- sizeof(corner),
+		sizeof(corner)
+	);
+	CHECK_TRUE(corner == cell_max.back())
+
+	MPI_Barrier(comm);
+
+	if (rank == 0) {
+		const std::string pvtu = read_file(prefix + ".pvtu");
+		for (int i = 0; i < comm_size; i++) {
+			CHECK_TRUE(
+				pvtu.find(
+					"<Piece Source=\"vtk_writer_" + std::to_string(i) + ".vtu\"/>"
+				) != std::string::npos
+			)
+		}
+		CHECK_TRUE(pvtu.find("Name=\"Flag\"") != std::string::npos)
+		CHECK_TRUE(pvtu.find("Name=\"Tagged&lt;int&gt;\"") != std::string::npos)
+		std::remove((prefix + ".pvtu").c_str());
+		std::remove((prefix + "_failure.pvtu").c_str());
+	}
+	std::remove(vtu_name.c_str());
+	std::remove((prefix + "_failure_" + std::to_string(rank) + ".vtu").c_str());
+
+	MPI_Finalize();
+
+	return EXIT_SUCCESS;
+}
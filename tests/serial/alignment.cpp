@@ -0,0 +1,153 @@
+/*
+Tests alignment of variables and cells.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "array"
+#include "cstdint"
+#include "cstdlib"
+#include "iostream"
+#include "mpi.h"
+#include "tuple"
+#include "vector"
+
+#include "check_true.hpp"
+#include "gensimcell.hpp"
+
+using namespace std;
+
+struct Unaligned {
+	using data_type = char;
+};
+
+struct Aligned_Velocity {
+	using data_type = array<double, 4>;
+	static constexpr size_t alignment = 32;
+};
+
+// smaller than natural alignment is ignored
+struct Underaligned_Pressure {
+	using data_type = double;
+	static constexpr size_t alignment = 1;
+};
+
+struct Cache_Line_Density {
+	using data_type = double;
+	static constexpr size_t alignment = 64;
+};
+
+struct Aligned_Coordinates {
+	using data_type = vector<double, gensimcell::Aligned_Allocator<double, 64>>;
+};
+
+bool is_aligned(const void* const address, const size_t alignment)
+{
+	return reinterpret_cast<uintptr_t>(address) % alignment == 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
+		cerr << "Couldn't initialize MPI." << endl;
+		abort();
+	}
+
+	CHECK_TRUE(gensimcell::get_variable_alignment<Unaligned>::value == 1)
+	CHECK_TRUE(gensimcell::get_variable_alignment<Aligned_Velocity>::value == 32)
+	CHECK_TRUE(gensimcell::get_variable_alignment<Underaligned_Pressure>::value == alignof(double))
+	CHECK_TRUE(gensimcell::get_variable_alignment<Cache_Line_Density>::value == 64)
+
+	using Cell1_T = gensimcell::Cell<
+		gensimcell::Optional_Transfer,
+		Unaligned,
+		Aligned_Velocity,
+		Underaligned_Pressure
+	>;
+	CHECK_TRUE(alignof(Cell1_T) == 32)
+	CHECK_TRUE(sizeof(Cell1_T) % 32 == 0)
+
+	// whole cells on separate cache lines
+	using Cell2_T = gensimcell::Cell<
+		gensimcell::Always_Transfer,
+		Cache_Line_Density,
+		Unaligned
+	>;
+	CHECK_TRUE(alignof(Cell2_T) == 64)
+	CHECK_TRUE(sizeof(Cell2_T) % 64 == 0)
+
+	vector<Cell1_T, gensimcell::Aligned_Allocator<Cell1_T>> cells1(7);
+	for (const auto& cell: cells1) {
+		CHECK_TRUE(is_aligned(&cell, 32))
+		CHECK_TRUE(is_aligned(cell[Aligned_Velocity()].data(), 32))
+	}
+
+	vector<Cell2_T, gensimcell::Aligned_Allocator<Cell2_T>> cells2(5);
+	for (size_t i = 0; i < cells2.size(); i++) {
+		CHECK_TRUE(is_aligned(&cells2[i], 64))
+		cells2[i][Cache_Line_Density()] = i;
+	}
+	cells2.resize(100);
+	for (size_t i = 0; i < 5; i++) {
+		CHECK_TRUE(is_aligned(&cells2[i], 64))
+		CHECK_TRUE(cells2[i][Cache_Line_Density()] == i)
+	}
+
+	// vectors of aligned data
+	gensimcell::Cell<gensimcell::Always_Transfer, Aligned_Coordinates> cell3;
+	cell3[Aligned_Coordinates()].resize(9, 1.5);
+	CHECK_TRUE(is_aligned(cell3[Aligned_Coordinates()].data(), 64))
+
+	void* address = nullptr;
+	int count = -1;
+	MPI_Datatype datatype = MPI_DATATYPE_NULL;
+	std::tie(address, count, datatype) = cell3.get_mpi_datatype();
+	CHECK_TRUE(address == cell3[Aligned_Coordinates()].data())
+	CHECK_TRUE(count == 9)
+	CHECK_TRUE(datatype == MPI_DOUBLE)
+
+	// transfer between aligned cells
+	Cell1_T::set_transfer_all(true, Aligned_Velocity());
+	cells1[0][Aligned_Velocity()] = {{1, 2, 3, 4}};
+	std::tie(address, count, datatype) = cells1[0].get_mpi_datatype();
+	CHECK_TRUE(address == cells1[0][Aligned_Velocity()].data())
+	CHECK_TRUE(count == 4)
+	CHECK_TRUE(datatype == MPI_DOUBLE)
+	MPI_Sendrecv(
+		address, count, datatype, 0, 0,
+		cells1[1][Aligned_Velocity()].data(), count, datatype, 0, 0,
+		MPI_COMM_SELF, MPI_STATUS_IGNORE
+	);
+	CHECK_TRUE(cells1[1][Aligned_Velocity()][3] == 4)
+
+	MPI_Finalize();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,205 @@
+/*
+Tests variables stored outside of cells.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "array"
+#include "cstdint"
+#include "cstdlib"
+#include "iostream"
+#include "mpi.h"
+#include "tuple"
+#include "type_traits"
+#include "utility"
+#include "vector"
+
+#include "check_true.hpp"
+#include "gensimcell.hpp"
+
+using namespace std;
+
+struct Density {
+	using data_type = double;
+};
+
+struct Particles {
+	using data_type = vector<array<double, 3>>;
+};
+
+struct Field {
+	using data_type = array<double, 64>;
+	static constexpr size_t alignment = 64;
+};
+
+int main(int argc, char* argv[])
+{
+	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
+		cerr << "Couldn't initialize MPI." << endl;
+		abort();
+	}
+
+	using Hot_Cell = gensimcell::Cell<
+		gensimcell::Optional_Transfer,
+		Density,
+		Particles,
+		Field
+	>;
+	using Cell = gensimcell::Cell<
+		gensimcell::Optional_Transfer,
+		Density,
+		gensimcell::Cold<Particles>,
+		gensimcell::Cold<Field>
+	>;
+	CHECK_TRUE(sizeof(Cell) < sizeof(Particles::data_type) + sizeof(Field::data_type))
+	CHECK_TRUE(sizeof(Cell) < sizeof(Hot_Cell))
+	CHECK_TRUE(alignof(Cell) < 64)
+
+	Cell cell1;
+	cell1[Density()] = 3;
+	cell1[Particles()].resize(2, {{1, 2, 3}});
+	cell1[Field()][63] = 4;
+	CHECK_TRUE(reinterpret_cast<uintptr_t>(cell1[Field()].data()) % 64 == 0)
+	CHECK_TRUE(cell1[Particles()][1][2] == 3)
+	CHECK_TRUE(get<1>(cell1(Density(), Field()))[63] == 4)
+
+	// copies have own data
+	Cell cell2(cell1);
+	CHECK_TRUE(cell2[Particles()].size() == 2)
+	CHECK_TRUE(cell2[Field()][63] == 4)
+	cell2[Particles()][0][0] = -1;
+	CHECK_TRUE(cell1[Particles()][0][0] == 1)
+
+	Cell cell3;
+	cell3 = cell2;
+	CHECK_TRUE(cell3[Density()] == 3)
+	CHECK_TRUE(cell3[Particles()][0][0] == -1)
+	cell3[Field()][63] = 5;
+	CHECK_TRUE(cell2[Field()][63] == 4)
+
+	// containers of cells
+	vector<Cell> cells(10, cell1);
+	cells.resize(100);
+	CHECK_TRUE(cells[9][Particles()].size() == 2)
+	CHECK_TRUE(cells[99][Particles()].size() == 0)
+
+	// moves transfer data without copying
+	CHECK_TRUE(std::is_nothrow_move_constructible<Cell>::value)
+	CHECK_TRUE(std::is_nothrow_move_assignable<Cell>::value)
+	const auto* const particles_data = cells[9][Particles()].data();
+	Cell moved(std::move(cells[9]));
+	CHECK_TRUE(moved[Particles()].data() == particles_data)
+	CHECK_TRUE(moved[Particles()].size() == 2)
+	const Cell& moved_from = cells[9];
+	CHECK_TRUE(moved_from[Particles()].size() == 0)
+	CHECK_TRUE(cells[9][Field()][63] == 0)
+	cells[9] = std::move(moved);
+	CHECK_TRUE(cells[9][Particles()].data() == particles_data)
+	moved = cells[9];
+	CHECK_TRUE(moved[Particles()].data() != particles_data)
+	CHECK_TRUE(moved[Particles()].size() == 2)
+	cells.reserve(2 * cells.capacity());
+	CHECK_TRUE(cells[9][Particles()].data() == particles_data)
+
+	// like copying, move assignment only moves data
+	cells[9].set_transfer(true, Particles());
+	cells[9] = Cell();
+	CHECK_TRUE(cells[9].get_transfer(Particles()))
+	CHECK_TRUE(cells[9][Particles()].size() == 0)
+
+	// assignment between hot and cold cells
+	Hot_Cell hot;
+	hot.assign(cell1);
+	CHECK_TRUE(hot[Particles()].size() == 2)
+	CHECK_TRUE(hot[Field()][63] == 4)
+	hot[Density()] = -3;
+	cell1.assign(hot);
+	CHECK_TRUE(cell1[Density()] == -3)
+
+	// transfer
+	Cell::set_transfer_all(true, Density(), Particles(), Field());
+	cell2 = Cell();
+	cell2[Particles()].resize(2);
+	void* address = nullptr;
+	int count = -1;
+	MPI_Datatype send_type = MPI_DATATYPE_NULL, receive_type = MPI_DATATYPE_NULL;
+	tie(address, count, send_type) = cell1.get_mpi_datatype();
+	CHECK_TRUE(address == &cell1[Density()])
+	CHECK_TRUE(count == 1)
+	MPI_Type_commit(&send_type);
+
+	void* receive_address = nullptr;
+	tie(receive_address, count, receive_type) = cell2.get_mpi_datatype();
+	MPI_Type_commit(&receive_type);
+
+	MPI_Sendrecv(
+		address, 1, send_type, 0, 0,
+		receive_address, 1, receive_type, 0, 0,
+		MPI_COMM_SELF, MPI_STATUS_IGNORE
+	);
+	MPI_Type_free(&send_type);
+	MPI_Type_free(&receive_type);
+
+	CHECK_TRUE(cell2[Density()] == -3)
+	CHECK_TRUE(cell2[Particles()][1][2] == 3)
+	CHECK_TRUE(cell2[Field()][63] == 4)
+
+	// receive into moved-from cells
+	Cell
+		cell4(std::move(cell2)),
+		cell5(std::move(cell3));
+	(void)cell4;
+	(void)cell5;
+	// only fixed size variables are accessed through const cell
+	cell2[Particles()].resize(2);
+	const Cell& const_moved_from = cell2;
+	tie(address, count, send_type) = cell1.get_mpi_datatype();
+	MPI_Type_commit(&send_type);
+	tie(receive_address, count, receive_type) = const_moved_from.get_mpi_datatype();
+	MPI_Type_commit(&receive_type);
+	MPI_Sendrecv(
+		address, 1, send_type, 0, 0,
+		receive_address, 1, receive_type, 0, 0,
+		MPI_COMM_SELF, MPI_STATUS_IGNORE
+	);
+	MPI_Type_free(&send_type);
+	MPI_Type_free(&receive_type);
+
+	CHECK_TRUE(cell2[Density()] == -3)
+	CHECK_TRUE(cell2[Particles()][1][2] == 3)
+	CHECK_TRUE(cell2[Field()][63] == 4)
+	const Cell& other_moved_from = cell3;
+	CHECK_TRUE(other_moved_from[Field()][63] == 0)
+	CHECK_TRUE(&other_moved_from[Field()] != &const_moved_from[Field()])
+
+	MPI_Finalize();
+
+	return EXIT_SUCCESS;
+}
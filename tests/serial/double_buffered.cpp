@@ -0,0 +1,168 @@
+/*
+Tests game of life with double buffered variables.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "array"
+#include "cstdlib"
+#include "iostream"
+#include "mpi.h"
+#include "tuple"
+
+#include "check_true.hpp"
+#include "gensimcell.hpp"
+
+using namespace std;
+
+struct Is_Alive {
+	using data_type = gensimcell::Double_Buffered<int, Is_Alive>;
+};
+
+struct Velocity {
+	using data_type = gensimcell::Double_Buffered<array<double, 2>, Velocity>;
+};
+
+using Cell_T = gensimcell::Cell<
+	gensimcell::Always_Transfer,
+	Is_Alive
+>;
+
+constexpr size_t width = 5, height = 5;
+using Grid_T = array<array<Cell_T, width>, height>;
+
+
+//! Writes next state of given grid with periodic boundaries.
+void solve(Grid_T& grid)
+{
+	for (size_t row_i = 0; row_i < height; row_i++)
+	for (size_t cell_i = 0; cell_i < width; cell_i++) {
+		int live_neighbors = 0;
+		for (auto row_offset: {size_t(1), size_t(0), height - 1})
+		for (auto cell_offset: {size_t(1), size_t(0), width - 1}) {
+			if (row_offset == 0 and cell_offset == 0) {
+				continue;
+			}
+			live_neighbors += grid[
+				(row_i + row_offset) % height
+			][
+				(cell_i + cell_offset) % width
+			][Is_Alive()].current();
+		}
+
+		auto& is_alive = grid[row_i][cell_i][Is_Alive()];
+		if (live_neighbors == 3) {
+			is_alive.next() = 1;
+		} else if (live_neighbors == 2) {
+			is_alive.next() = is_alive.current();
+		} else {
+			is_alive.next() = 0;
+		}
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
+		cerr << "Couldn't initialize MPI." << endl;
+		abort();
+	}
+
+	Grid_T grid;
+	for (auto& row: grid) {
+		for (auto& cell: row) {
+			cell[Is_Alive()].current() = 0;
+		}
+	}
+
+	// horizontal blinker
+	grid[2][1][Is_Alive()].current() =
+	grid[2][2][Is_Alive()].current() =
+	grid[2][3][Is_Alive()].current() = 1;
+
+	for (size_t turn = 0; turn < 4; turn++) {
+		solve(grid);
+		Is_Alive::data_type::swap();
+
+		const bool vertical = (turn % 2 == 0);
+		for (size_t row_i = 0; row_i < height; row_i++)
+		for (size_t cell_i = 0; cell_i < width; cell_i++) {
+			const bool on_line
+				= vertical
+				? (cell_i == 2 and row_i >= 1 and row_i <= 3)
+				: (row_i == 2 and cell_i >= 1 and cell_i <= 3);
+			CHECK_TRUE(grid[row_i][cell_i][Is_Alive()].current() == int(on_line))
+		}
+	}
+	CHECK_TRUE(Is_Alive::data_type::get_current_index() == 0)
+
+	// swapping one variable doesn't affect others
+	Velocity::data_type velocity;
+	velocity.current() = {{1, 2}};
+	velocity.next() = {{3, 4}};
+	Is_Alive::data_type::swap();
+	CHECK_TRUE(velocity.current()[0] == 1)
+	Velocity::data_type::swap();
+	CHECK_TRUE(velocity.current()[0] == 3)
+	CHECK_TRUE(velocity.next()[1] == 2)
+
+	// only current buffer is transferred
+	void* address = nullptr;
+	int count = -1;
+	MPI_Datatype datatype = MPI_DATATYPE_NULL;
+	tie(address, count, datatype) = grid[2][2].get_mpi_datatype();
+	CHECK_TRUE(address == &grid[2][2][Is_Alive()].current())
+	CHECK_TRUE(count == 1)
+	CHECK_TRUE(datatype == MPI_INT)
+
+	tie(address, count, datatype) = velocity.get_mpi_datatype();
+	CHECK_TRUE(address == velocity.current().data())
+	CHECK_TRUE(count == 2)
+	CHECK_TRUE(datatype == MPI_DOUBLE)
+
+	Cell_T received;
+	received[Is_Alive()].current() = 0;
+	received[Is_Alive()].next() = -1;
+	void* receive_address = nullptr;
+	tie(address, count, datatype) = grid[1][2].get_mpi_datatype();
+	tie(receive_address, count, datatype) = received.get_mpi_datatype();
+	MPI_Sendrecv(
+		address, count, datatype, 0, 0,
+		receive_address, count, datatype, 0, 0,
+		MPI_COMM_SELF, MPI_STATUS_IGNORE
+	);
+	CHECK_TRUE(received[Is_Alive()].current() == 1)
+	CHECK_TRUE(received[Is_Alive()].next() == -1)
+
+	MPI_Finalize();
+
+	return EXIT_SUCCESS;
+}
@@ -36,6 +36,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "iostream"
 
 #include "gensimcell.hpp"
+#include "structured_grid.hpp"
 
 using namespace std;
 using namespace std::chrono;
@@ -68,6 +69,8 @@ using cell_t = gensimcell::Cell<
 	live_neighbors
 >;
 
+using grid_t = gensimcell::Structured_Grid<cell_t, 2>;
+
 
 int main(int, char**)
 {
@@ -76,76 +79,69 @@ int main(int, char**)
 		width = 100,
 		height = 100;
 
-	array<array<cell_t, width>, height> game_grid;
+	grid_t game_grid({{width, height}}, 1);
 
 
 	// initialize the game with a glider at upper left
-	for (auto& row: game_grid) {
-		for (auto& cell: row) {
-			cell[is_alive()] = false;
-			cell[live_neighbors()] = 0;
-		}
-	}
-	game_grid[1][2][is_alive()] = true;
-	game_grid[2][3][is_alive()] = true;
-	game_grid[3][3][is_alive()] = true;
-	game_grid[3][2][is_alive()] = true;
-	game_grid[3][1][is_alive()] = true;
+	game_grid.for_each_cell([](cell_t& cell, const grid_t::Index_T&) {
+		cell[is_alive()] = false;
+		cell[live_neighbors()] = 0;
+	});
+	game_grid[{{2, 1}}][is_alive()] = true;
+	game_grid[{{3, 2}}][is_alive()] = true;
+	game_grid[{{3, 3}}][is_alive()] = true;
+	game_grid[{{2, 3}}][is_alive()] = true;
+	game_grid[{{1, 3}}][is_alive()] = true;
+
+	const auto neighbor_offsets = game_grid.get_offsets<8>({{
+		{{-1, -1}}, {{0, -1}}, {{1, -1}},
+		{{-1,  0}},            {{1,  0}},
+		{{-1,  1}}, {{0,  1}}, {{1,  1}}
+	}});
 
 	const auto time_start = high_resolution_clock::now();
 
 	constexpr size_t max_turns = 30000;
 	for (size_t turn = 0; turn < max_turns; turn++) {
 
-		// collect live neighbor counts, use periodic boundaries
-		for (size_t row_i = 0; row_i < game_grid.size(); row_i++)
-		for (size_t cell_i = 0; cell_i < game_grid[row_i].size(); cell_i++) {
-
-			cell_t& current_cell = game_grid[row_i][cell_i];
-
-			for (auto row_offset: {size_t(1), size_t(0), width - 1}) 
-			for (auto cell_offset: {size_t(1), size_t(0), height - 1}) {
-
-				if (row_offset == 0 and cell_offset == 0) {
-					continue;
-				}
-
-				const cell_t& neighbor
-					= game_grid[
-						(row_i + row_offset) % height
-					][
-						(cell_i + cell_offset) % width
-					];
-
-				if (neighbor[is_alive()]) {
-					current_cell[live_neighbors()]++;
+		// use periodic boundaries
+		game_grid.fill_periodic(is_alive());
+
+		// collect live neighbor counts
+		game_grid.for_each_cell(
+			neighbor_offsets,
+			[](
+				cell_t& current_cell,
+				const array<cell_t*, 8>& neighbors,
+				const grid_t::Index_T&
+			) {
+				for (const cell_t* neighbor: neighbors) {
+					if ((*neighbor)[is_alive()]) {
+						current_cell[live_neighbors()]++;
+					}
 				}
 			}
-		}
+		);
 
 		// set new state
-		for (size_t row_i = 0; row_i < game_grid.size(); row_i++)
-		for (size_t cell_i = 0; cell_i < game_grid[row_i].size(); cell_i++) {
-
-			cell_t& cell = game_grid[row_i][cell_i];
+		game_grid.for_each_cell([](cell_t& cell, const grid_t::Index_T&) {
 			if (cell[live_neighbors()] == 3) {
 				cell[is_alive()] = true;
 			} else if (cell[live_neighbors()] != 2) {
 				cell[is_alive()] = false;
 			}
 			cell[live_neighbors()] = 0;
-		}
+		});
 	}
 
 	const auto time_end = high_resolution_clock::now();
 
 	size_t number_of_live_cells = 0;
-	for (const auto& row: game_grid) {
-	for (const auto& cell: row) {
+	game_grid.for_each_cell([&](const cell_t& cell, const grid_t::Index_T&) {
 		if (cell[is_alive()]) {
 			number_of_live_cells++;
 		}
-	}}
+	});
 
 	if (number_of_live_cells != 5) {
 		std::cerr << __FILE__ << ":" << __LINE__ << " FAILED" << std::endl;
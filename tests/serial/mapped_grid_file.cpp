@@ -0,0 +1,146 @@
+/*
+Tests reading files with gensimcell::Mapped_Grid_File.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "array"
+#include "cstdint"
+#include "cstdio"
+#include "cstdlib"
+#include "cstring"
+#include "fstream"
+#include "iostream"
+#include "vector"
+
+#include "check_true.hpp"
+#include "mapped_grid_file.hpp"
+
+template<class T> void write(std::ofstream& file, const T& data)
+{
+	file.write(reinterpret_cast<const char*>(&data), sizeof(T));
+}
+
+int main()
+{
+	const char file_name[] = "tests/serial/mapped_grid_file.dc";
+
+	/*
+	Write a file in the format of dccrg with an unaligned
+	header, 3 cells whose data isn't in the order of
+	the cell list and 1, 2 and 3 doubles of data
+	*/
+	const uint64_t
+		header_size = 13,
+		list_start = header_size,
+		data_start = list_start + sizeof(uint64_t) * (1 + 3 * 2);
+
+	const std::vector<uint64_t> cells{10, 5, 7};
+	const std::vector<uint64_t> offsets{
+		data_start + 3 * sizeof(double),
+		data_start,
+		data_start + sizeof(double)
+	};
+
+	std::ofstream out(file_name, std::ios::binary);
+	for (uint64_t i = 0; i < header_size; i++) {
+		out.put(char(i));
+	}
+	write(out, uint64_t(cells.size()));
+	for (size_t i = 0; i < cells.size(); i++) {
+		write(out, cells[i]);
+		write(out, offsets[i]);
+	}
+	// cell 5
+	write(out, 1.5);
+	// cell 7
+	write(out, 2.5);
+	write(out, 3.5);
+	// cell 10
+	write(out, 4.5);
+	write(out, 5.5);
+	write(out, 6.5);
+	out.close();
+
+	gensimcell::Mapped_Grid_File file;
+	CHECK_TRUE(not file.is_open())
+	CHECK_TRUE(not file.open("tests/serial/nonexisting_file.dc"))
+
+	CHECK_TRUE(file.open(file_name))
+	CHECK_TRUE(file.is_open())
+	CHECK_TRUE(file.size() == data_start + 6 * sizeof(double))
+	CHECK_TRUE(file.data()[header_size - 1] == char(header_size - 1))
+
+	// reading beyond end of file
+	double value = 0;
+	CHECK_TRUE(not file.read(file.size() - 1, value))
+	CHECK_TRUE(not file.read(file.size() + 1, value))
+	CHECK_TRUE(file.read(file.size() - sizeof(double), value))
+	CHECK_TRUE(value == 6.5)
+	CHECK_TRUE(not file.read_cells(file.size() - 4))
+	CHECK_TRUE(file.get_cells().size() == 0)
+
+	CHECK_TRUE(file.read_cells(list_start))
+	CHECK_TRUE(file.get_cells() == cells)
+	CHECK_TRUE(file.get_cell_index(7) == 2)
+	CHECK_TRUE(file.get_cell_index(8) == cells.size())
+
+	// cell data is unaligned so compare bytes
+	const auto cell_10 = file.get_cell_data(file.get_cell_index(10));
+	CHECK_TRUE(cell_10.second == 3 * sizeof(double))
+	value = 4.5;
+	CHECK_TRUE(std::memcmp(cell_10.first, &value, sizeof(double)) == 0)
+
+	CHECK_TRUE(file.get_cell_data(file.get_cell_index(5)).second == sizeof(double))
+	CHECK_TRUE(file.get_cell_data(file.get_cell_index(7)).second == 2 * sizeof(double))
+
+	std::array<double, 2> cell_7{{0, 0}};
+	CHECK_TRUE(file.read(file.get_cell_data_offset(2), cell_7))
+	CHECK_TRUE(cell_7[0] == 2.5)
+	CHECK_TRUE(cell_7[1] == 3.5)
+
+	std::vector<double> cell_10_data(3);
+	CHECK_TRUE(
+		file.read(
+			file.get_cell_data_offset(0),
+			cell_10_data.data(),
+			cell_10_data.size()
+		)
+	)
+	CHECK_TRUE(cell_10_data[2] == 6.5)
+
+	file.close();
+	CHECK_TRUE(not file.is_open())
+	CHECK_TRUE(file.get_cells().size() == 0)
+
+	std::remove(file_name);
+
+	return EXIT_SUCCESS;
+}
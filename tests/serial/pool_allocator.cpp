@@ -0,0 +1,181 @@
+/*
+Tests vectors of cells using pooled memory.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "array"
+#include "cstdlib"
+#include "iostream"
+#include "mpi.h"
+#include "thread"
+#include "tuple"
+#include "utility"
+#include "vector"
+
+#include "check_true.hpp"
+#include "gensimcell.hpp"
+
+using namespace std;
+
+struct Test_Pool {};
+
+struct Number_Of_Particles {
+	using data_type = unsigned long long int;
+};
+
+struct Particles {
+	using data_type = vector<
+		array<double, 3>,
+		gensimcell::Pool_Allocator<array<double, 3>, Test_Pool>
+	>;
+};
+
+struct Destinations {
+	using data_type = vector<
+		pair<int, double>,
+		gensimcell::Pool_Allocator<pair<int, double>, Test_Pool>
+	>;
+};
+
+using Pool = gensimcell::Pool<Test_Pool>;
+
+int main(int argc, char* argv[])
+{
+	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
+		cerr << "Couldn't initialize MPI." << endl;
+		abort();
+	}
+
+	CHECK_TRUE(Pool::get_cached_bytes() == 0)
+
+	using Cell = gensimcell::Cell<
+		gensimcell::Optional_Transfer,
+		Number_Of_Particles,
+		Particles,
+		Destinations
+	>;
+
+	vector<Cell> cells(10);
+	for (size_t i = 0; i < cells.size(); i++) {
+		cells[i][Particles()].resize(i + 1, {{double(i), 1, 2}});
+		cells[i][Number_Of_Particles()] = i + 1;
+		cells[i][Destinations()].emplace_back(i, 0.5);
+	}
+	CHECK_TRUE(Pool::get_cached_bytes() == 0)
+
+	// freed memory is reused by the next allocation of same size
+	const auto* const old_particles = cells[3][Particles()].data();
+	const auto old_capacity = cells[3][Particles()].capacity();
+	Particles::data_type().swap(cells[3][Particles()]);
+	CHECK_TRUE(Pool::get_cached_bytes() > 0)
+	cells[3][Particles()].resize(old_capacity);
+	CHECK_TRUE(cells[3][Particles()].data() == old_particles)
+	CHECK_TRUE(Pool::get_cached_bytes() == 0)
+
+	// copies allocate from the same pool
+	Cell copy = cells[9];
+	CHECK_TRUE(copy[Particles()].size() == 10)
+	CHECK_TRUE(copy[Particles()][9][0] == 9)
+	CHECK_TRUE(copy[Destinations()][0].first == 9)
+
+	cells.clear();
+	copy = Cell();
+	CHECK_TRUE(Pool::get_cached_bytes() > 0)
+	Pool::release();
+	CHECK_TRUE(Pool::get_cached_bytes() == 0)
+
+	// large blocks aren't pooled
+	{
+		Particles::data_type large(Pool::max_pooled_bytes);
+	}
+	CHECK_TRUE(Pool::get_cached_bytes() == 0)
+
+	// memory freed into a full pool is returned to the system
+	Pool::set_max_cached_bytes(1024);
+	CHECK_TRUE(Pool::get_max_cached_bytes() == 1024)
+	{
+		Particles::data_type small(10), large(1000);
+	}
+	CHECK_TRUE(Pool::get_cached_bytes() > 0)
+	CHECK_TRUE(Pool::get_cached_bytes() <= 1024)
+	Pool::set_max_cached_bytes(0);
+	CHECK_TRUE(Pool::get_cached_bytes() == 0)
+	Pool::set_max_cached_bytes(Pool::default_max_cached_bytes);
+
+	/*
+	Pools of other threads are released when they exit, also
+	memory freed after the thread's pool was destroyed, e.g. by
+	thread local objects constructed before it, is released
+	*/
+	std::size_t thread_cached_bytes = 0;
+	std::thread thread([&thread_cached_bytes](){
+		thread_local Particles::data_type destroyed_last;
+		destroyed_last.resize(5);
+		Particles::data_type(20).swap(destroyed_last);
+		thread_cached_bytes = Pool::get_cached_bytes();
+	});
+	thread.join();
+	CHECK_TRUE(thread_cached_bytes > 0)
+	CHECK_TRUE(Pool::get_cached_bytes() == 0)
+
+	// transfer
+	Cell sender, receiver;
+	sender[Particles()].resize(3, {{1, 2, 3}});
+	sender[Destinations()].resize(2, {-1, 4.5});
+	receiver[Particles()].resize(3);
+	receiver[Destinations()].resize(2);
+	Cell::set_transfer_all(true, Particles(), Destinations());
+
+	void* send_address = nullptr, * receive_address = nullptr;
+	int send_count = -1, receive_count = -1;
+	MPI_Datatype send_type = MPI_DATATYPE_NULL, receive_type = MPI_DATATYPE_NULL;
+	tie(send_address, send_count, send_type) = sender.get_mpi_datatype();
+	tie(receive_address, receive_count, receive_type) = receiver.get_mpi_datatype();
+	CHECK_TRUE(send_count == 1)
+	CHECK_TRUE(receive_count == 1)
+	MPI_Type_commit(&send_type);
+	MPI_Type_commit(&receive_type);
+	MPI_Sendrecv(
+		send_address, send_count, send_type, 0, 0,
+		receive_address, receive_count, receive_type, 0, 0,
+		MPI_COMM_SELF, MPI_STATUS_IGNORE
+	);
+	MPI_Type_free(&send_type);
+	MPI_Type_free(&receive_type);
+
+	CHECK_TRUE(receiver[Particles()][2][2] == 3)
+	CHECK_TRUE(receiver[Destinations()][1].first == -1)
+	CHECK_TRUE(receiver[Destinations()][1].second == 4.5)
+
+	MPI_Finalize();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+/*
+Tests compile time information about variables of cells.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "array"
+#include "cstdlib"
+#include "string"
+#include "type_traits"
+#include "vector"
+
+#include "check_true.hpp"
+#include "gensimcell.hpp"
+
+using namespace std;
+
+struct Is_Alive {
+	using data_type = bool;
+};
+
+struct Density {
+	using data_type = double;
+};
+
+struct Velocity {
+	using data_type = array<double, 3>;
+};
+
+struct Particles {
+	using data_type = vector<array<double, 3>>;
+};
+
+using Cell_T = gensimcell::Cell<
+	gensimcell::Never_Transfer,
+	Is_Alive,
+	Density,
+	Velocity,
+	gensimcell::Cold<Particles>
+>;
+
+static_assert(Cell_T::variable_count == 4, "");
+static_assert(Cell_T::index_of<Is_Alive>() == 0, "");
+static_assert(Cell_T::index_of<Velocity>() == 2, "");
+static_assert(Cell_T::index_of<Particles>() == 3, "");
+static_assert(is_same<Cell_T::variable_at<1>, Density>::value, "");
+static_assert(is_same<Cell_T::variable_at<3>, Particles>::value, "");
+static_assert(Cell_T::size_of<Velocity>() == 3 * sizeof(double), "");
+
+// usable as template arguments
+static_assert(
+	is_same<
+		Cell_T::variable_at<Cell_T::index_of<Velocity>()>,
+		Velocity
+	>::value,
+	""
+);
+
+
+//! Adds up sizes and increments data of variables.
+struct Visitor {
+	size_t total_size = 0;
+	string order;
+
+	template<class Variable> void operator()(
+		const Variable&,
+		typename Variable::data_type&
+	) {
+		this->total_size += Cell_T::size_of<Variable>();
+		this->order += to_string(Cell_T::index_of<Variable>());
+	}
+
+	void operator()(const Density&, double& density)
+	{
+		density += 1;
+		this->order += "d";
+	}
+};
+
+//! Counts variables of a const cell.
+struct Const_Visitor {
+	size_t count = 0;
+
+	template<class Variable, class Data> void operator()(
+		const Variable&,
+		const Data&
+	) {
+		this->count++;
+	}
+};
+
+int main(int, char**)
+{
+	Cell_T cell;
+	cell[Density()] = 2;
+
+	const auto visitor = gensimcell::for_each_variable(cell, Visitor());
+	CHECK_TRUE(visitor.order == "0d23")
+	CHECK_TRUE(visitor.total_size == sizeof(bool) + sizeof(Velocity::data_type) + sizeof(Particles::data_type))
+	CHECK_TRUE(cell[Density()] == 3)
+
+	const Cell_T& const_cell = cell;
+	CHECK_TRUE(gensimcell::for_each_variable(const_cell, Const_Visitor()).count == 4)
+
+	const size_t
+		density_offset = Cell_T::offset_of<Density>(),
+		velocity_offset = Cell_T::offset_of<Velocity>();
+	CHECK_TRUE(density_offset + sizeof(double) <= sizeof(Cell_T))
+	CHECK_TRUE(velocity_offset + sizeof(Velocity::data_type) <= sizeof(Cell_T))
+	CHECK_TRUE(density_offset != velocity_offset)
+
+	vector<Cell_T> cells(3);
+	for (const auto& item: cells) {
+		CHECK_TRUE(
+			reinterpret_cast<const char*>(&item[Velocity()])
+			== reinterpret_cast<const char*>(&item) + velocity_offset
+		)
+	}
+
+	return EXIT_SUCCESS;
+}
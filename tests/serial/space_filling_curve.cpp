@@ -0,0 +1,145 @@
+/*
+Tests ordering of cells along space-filling curves.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+*/
+
+#include "array"
+#include "cstddef"
+#include "cstdint"
+#include "cstdlib"
+#include "string"
+#include "vector"
+
+#include "check_true.hpp"
+#include "space_filling_curve.hpp"
+
+
+//! Returns true if consecutive indices are face neighbors.
+template<std::size_t Dimensions> bool is_continuous(
+	const std::vector<std::array<std::uint64_t, Dimensions>>& indices,
+	const std::vector<std::size_t>& order
+) {
+	for (std::size_t i = 1; i < order.size(); i++) {
+		const auto
+			&previous = indices[order[i - 1]],
+			&current = indices[order[i]];
+		std::uint64_t distance = 0;
+		for (std::size_t d = 0; d < Dimensions; d++) {
+			distance += (previous[d] > current[d])
+				? previous[d] - current[d]
+				: current[d] - previous[d];
+		}
+		if (distance != 1) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+int main(int, char**)
+{
+	using gensimcell::Curve;
+	using gensimcell::get_curve_order;
+
+	// morton, first dimension varies fastest
+	{
+		const std::vector<std::array<std::uint64_t, 2>> indices{
+			{{1, 1}}, {{0, 1}}, {{1, 0}}, {{0, 0}}, {{2, 0}}
+		};
+		const std::vector<std::size_t>
+			order = get_curve_order(indices, Curve::morton),
+			expected{3, 2, 1, 0, 4};
+		CHECK_TRUE(order == expected)
+	}
+
+	// hilbert in 2d
+	{
+		constexpr std::uint64_t width = 16;
+		std::vector<std::array<std::uint64_t, 2>> indices;
+		for (std::uint64_t x = 0; x < width; x++)
+		for (std::uint64_t y = 0; y < width; y++) {
+			indices.push_back({{x, y}});
+		}
+		const auto order = get_curve_order(indices, Curve::hilbert);
+		CHECK_TRUE(order.size() == indices.size())
+		CHECK_TRUE(is_continuous(indices, order))
+		CHECK_TRUE(not is_continuous(indices, get_curve_order(indices, Curve::morton)))
+	}
+
+	// hilbert in 3d, also when all bits don't fit into key
+	for (const std::uint64_t offset: {std::uint64_t(0), std::uint64_t(1) << 40}) {
+		constexpr std::uint64_t width = 8;
+		std::vector<std::array<std::uint64_t, 3>> indices;
+		for (std::uint64_t z = 0; z < width; z++)
+		for (std::uint64_t y = 0; y < width; y++)
+		for (std::uint64_t x = 0; x < width; x++) {
+			indices.push_back({{x + offset, y, z}});
+		}
+		const auto order = get_curve_order(indices, Curve::hilbert);
+		CHECK_TRUE(order.size() == indices.size())
+		if (offset == 0) {
+			CHECK_TRUE(is_continuous(indices, order))
+		}
+
+		std::vector<bool> found(order.size(), false);
+		for (const auto i: order) {
+			CHECK_TRUE(i < found.size())
+			CHECK_TRUE(not found[i])
+			found[i] = true;
+		}
+	}
+
+	// sorting items and relocating them
+	{
+		const std::vector<std::string> items{"d", "b", "a", "c"};
+		const std::vector<std::array<int, 2>> indices{
+			{{1, 1}}, {{0, 1}}, {{0, 0}}, {{1, 0}}
+		};
+		const auto sorted = gensimcell::sort_along_curve(
+			items,
+			[&](const std::string& item) {
+				return indices[std::size_t(item[0] - 'a')];
+			},
+			Curve::morton
+		);
+		const std::vector<std::string> expected{"c", "d", "b", "a"};
+		CHECK_TRUE(sorted == expected)
+
+		std::vector<std::string> relocated(items);
+		gensimcell::apply_order(relocated, get_curve_order(indices, Curve::hilbert));
+		const std::vector<std::string> expected_hilbert{"a", "b", "d", "c"};
+		CHECK_TRUE(relocated == expected_hilbert)
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,249 @@
+/*
+Tests Cartesian grid of cells with ghost layers.
+
+Copyright 2016 Ilja Honkonen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+  list of conditions and the following disclaimer in the documentation and/or
+  other materials provided with the distribution.
+
+* Neither the name of copyright holders nor the names of their contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+*/
+
+#include "array"
+#include "cstddef"
+#include "cstdlib"
+
+#include "check_true.hpp"
+#include "gensimcell.hpp"
+#include "structured_grid.hpp"
+
+struct Id {
+	using data_type = int;
+};
+
+struct Other {
+	using data_type = int;
+};
+
+using Cell_T = gensimcell::Cell<
+	gensimcell::Never_Transfer,
+	Id,
+	Other
+>;
+
+
+int main(int, char**)
+{
+	// 2d
+	{
+		using Grid_T = gensimcell::Structured_Grid<Cell_T, 2>;
+		using Index_T = Grid_T::Index_T;
+
+		constexpr int width = 5, height = 3;
+		Grid_T grid({{width, height}}, 2);
+		CHECK_TRUE(grid.get_number_of_cells() == width * height)
+		CHECK_TRUE(grid.get_storage_size() == (width + 4) * (height + 4))
+		CHECK_TRUE(grid.get_strides()[0] == 1)
+		CHECK_TRUE(grid.get_strides()[1] == width + 4)
+		const Index_T first{{-2, -2}}, origin{{0, 0}}, next{{1, 0}};
+		CHECK_TRUE(&grid[first] == grid.data())
+		CHECK_TRUE(&grid[next] - &grid[origin] == grid.get_offset_to(next))
+
+		// cells are visited in storage order
+		int visited = 0;
+		const Cell_T* previous = nullptr;
+		grid.for_each_cell([&](Cell_T& cell, const Index_T& index) {
+			CHECK_TRUE(&cell == &grid[index])
+			CHECK_TRUE(previous == nullptr or &cell > previous)
+			previous = &cell;
+			cell[Id()] = int(index[0] + index[1] * width);
+			cell[Other()] = -1;
+			visited++;
+		});
+		CHECK_TRUE(visited == width * height)
+
+		grid.fill_periodic(Id());
+		for (int y = -2; y < height + 2; y++)
+		for (int x = -2; x < width + 2; x++) {
+			const Index_T
+				index{{x, y}},
+				wrapped{{(x + width) % width, (y + height) % height}};
+			CHECK_TRUE(grid[index][Id()] == wrapped[0] + wrapped[1] * width)
+			CHECK_TRUE(&grid.get_periodic(index) == &grid[wrapped])
+			if (index != wrapped) {
+				CHECK_TRUE(grid[index][Other()] != -1)
+			}
+		}
+
+		grid.fill_periodic();
+		const Index_T corner{{-1, -1}};
+		CHECK_TRUE(grid[corner][Other()] == -1)
+
+		const auto offsets = grid.get_offsets<4>({{
+			{{-2, 0}}, {{2, 0}}, {{0, -2}}, {{0, 2}}
+		}});
+		grid.for_each_cell(
+			offsets,
+			[&](Cell_T& cell, const std::array<Cell_T*, 4>& neighbors, const Index_T& index) {
+				const Index_T
+					negative_x{{index[0] - 2, index[1]}},
+					positive_y{{index[0], index[1] + 2}};
+				CHECK_TRUE(&cell == &grid[index])
+				CHECK_TRUE(neighbors[0] == &grid[negative_x])
+				CHECK_TRUE(neighbors[3] == &grid[positive_y])
+				CHECK_TRUE(
+					(*neighbors[1])[Id()]
+					== int((index[0] + 2) % width + index[1] * width)
+				)
+			}
+		);
+
+		// margin and reach of offsets together fit within ghost cells
+		const auto near_offsets = grid.get_offsets<2>({{{{-1, 0}}, {{0, 1}}}});
+		int with_margin = 0;
+		grid.for_each_cell(
+			1,
+			near_offsets,
+			[&](Cell_T&, const std::array<Cell_T*, 2>&, const Index_T&) {
+				with_margin++;
+			}
+		);
+		CHECK_TRUE(with_margin == (width + 2) * (height + 2))
+	}
+
+	// 3d, no ghosts
+	{
+		using Grid_T = gensimcell::Structured_Grid<Cell_T, 3>;
+		using Index_T = Grid_T::Index_T;
+
+		Grid_T grid({{2, 3, 4}}, 0);
+		CHECK_TRUE(grid.get_storage_size() == 2 * 3 * 4)
+
+		int id = 0;
+		grid.for_each_cell([&](Cell_T& cell, const Index_T& index) {
+			CHECK_TRUE(&cell - grid.data() == id)
+			CHECK_TRUE(index[0] == id % 2)
+			CHECK_TRUE(index[2] == id / 6)
+			cell[Id()] = id++;
+		});
+		CHECK_TRUE(id == 2 * 3 * 4)
+		grid.fill_periodic();
+		const Index_T corner{{-1, -1, -1}};
+		CHECK_TRUE(grid.get_periodic(corner)[Id()] == 23)
+
+		const Grid_T& const_grid = grid;
+		int sum = 0;
+		const_grid.for_each_cell([&](const Cell_T& cell, const Index_T&) {
+			sum += cell[Id()];
+		});
+		CHECK_TRUE(sum == 23 * 24 / 2)
+	}
+
+	// tiles
+	{
+		using Grid_T = gensimcell::Structured_Grid<Cell_T, 3>;
+		using Index_T = Grid_T::Index_T;
+
+		Grid_T grid({{7, 5, 3}}, 1);
+		grid.for_each_cell([&](Cell_T& cell, const Index_T&) {
+			cell[Id()] = cell[Other()] = 0;
+		});
+
+		// each cell once regardless of tile size and threads
+		for (const auto& tile_size: {
+			Grid_T::Size_T{{2, 2, 2}},
+			Grid_T::Size_T{{0, 3, 1}},
+			Grid_T::Size_T{{100, 1, 100}}
+		}) {
+			for (const std::size_t threads: {1, 3}) {
+				grid.for_each_cell_tiled(
+					tile_size,
+					[&](Cell_T& cell, const Index_T& index) {
+						CHECK_TRUE(&cell == &grid[index])
+						cell[Id()]++;
+					},
+					threads
+				);
+			}
+		}
+		grid.for_each_cell_tiled<4, 4, 4>([](Cell_T& cell, const Index_T&) {
+			cell[Id()]++;
+		});
+		grid.for_each_cell([](const Cell_T& cell, const Index_T&) {
+			CHECK_TRUE(cell[Id()] == 7)
+		});
+
+		// tiles of first dimension are visited row by row
+		Grid_T::Index_T previous{{-1, 0, 0}};
+		grid.for_each_cell_tiled({{3, 2, 1}}, [&](Cell_T&, const Index_T& index) {
+			if (index[0] % 3 != 0) {
+				CHECK_TRUE(index[0] == previous[0] + 1)
+				CHECK_TRUE(index[1] == previous[1])
+			}
+			previous = index;
+		});
+
+		const auto offsets = grid.get_offsets<2>({{
+			{{0, 0, -1}}, {{1, 1, 1}}
+		}});
+		grid.for_each_cell_tiled(
+			{{2, 2, 2}},
+			offsets,
+			[&](Cell_T& cell, const std::array<Cell_T*, 2>& neighbors, const Index_T&) {
+				CHECK_TRUE(neighbors[0] == &cell - 9 * 7)
+				CHECK_TRUE(neighbors[1] == &cell + 1 + 9 + 9 * 7)
+				cell[Other()]++;
+			},
+			2
+		);
+		grid.for_each_cell([](const Cell_T& cell, const Index_T&) {
+			CHECK_TRUE(cell[Other()] == 1)
+		});
+	}
+
+	// 3d, ghosts
+	{
+		using Grid_T = gensimcell::Structured_Grid<Cell_T, 3>;
+		using Index_T = Grid_T::Index_T;
+
+		Grid_T grid({{3, 2, 2}}, 1);
+		grid.for_each_cell([&](Cell_T& cell, const Index_T& index) {
+			cell[Id()] = int(index[0] + 3 * index[1] + 6 * index[2]);
+		});
+		grid.fill_periodic(Id());
+		for (int z = -1; z < 3; z++)
+		for (int y = -1; y < 3; y++)
+		for (int x = -1; x < 4; x++) {
+			const Index_T index{{x, y, z}};
+			CHECK_TRUE(
+				grid[index][Id()]
+				== (x + 3) % 3 + 3 * ((y + 2) % 2) + 6 * ((z + 2) % 2)
+			)
+		}
+	}
+
+	return EXIT_SUCCESS;
+}